@@ -0,0 +1,186 @@
+#include "gvk.h"
+using namespace gvk;
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+#include <algorithm>
+
+#define require(expr,target) if(auto v = expr;v.has_value()) { target = v.value(); } else { gvk_assert(false);return -1; }
+
+//every thread creates buffers,images with views,samplers and queues,
+//then destroys them while the other threads are still creating.
+//handles of live objects must be unique and every object created must be destroyed
+static constexpr uint32 thread_count = 8;
+static constexpr uint32 round_count = 64;
+static constexpr uint32 objects_per_round = 16;
+
+struct LiveHandles
+{
+	std::mutex					 lock;
+	std::unordered_set<uint64_t> handles;
+
+	bool Add(uint64_t handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return handles.insert(handle).second;
+	}
+
+	bool Remove(uint64_t handle)
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		return handles.erase(handle) != 0;
+	}
+};
+
+int main()
+{
+	ptr<gvk::Window> window;
+	require(gvk::Window::Create(100, 100, "stress"), window);
+
+	std::string error;
+	ptr<gvk::Context> context;
+	require(gvk::Context::CreateContext("stress", GVK_VERSION{ 1,0,0 }, VK_API_VERSION_1_3, window, &error),
+		context);
+
+	GvkInstanceCreateInfo instance_create;
+	instance_create.AddInstanceExtension(GVK_INSTANCE_EXTENSION_DEBUG);
+	instance_create.AddLayer(GVK_LAYER_DEBUG);
+	if (!context->InitializeInstance(instance_create, &error))
+	{
+		printf("fail to initialize instance reason %s\n", error.c_str());
+		return -1;
+	}
+
+	GvkDeviceCreateInfo device_create;
+	device_create.AddDeviceExtension(GVK_DEVICE_EXTENSION_SWAP_CHAIN);
+	//one queue for every thread besides the present queue
+	device_create.RequireQueue(VK_QUEUE_GRAPHICS_BIT, thread_count + 1);
+	if (!context->InitializeDevice(device_create, &error))
+	{
+		printf("fail to initialize device reason %s\n", error.c_str());
+		return -1;
+	}
+
+	LiveHandles buffers, images, views, samplers, queues;
+	std::atomic<uint32> created{ 0 }, destroyed{ 0 }, failures{ 0 };
+
+	auto worker = [&](uint32 thread_index)
+	{
+		for (uint32 round = 0; round < round_count; round++)
+		{
+			std::vector<ptr<Buffer>> round_buffers;
+			std::vector<ptr<Image>>  round_images;
+			std::vector<VkSampler>	 round_samplers;
+			ptr<CommandQueue>		 round_queue;
+
+			for (uint32 i = 0; i < objects_per_round; i++)
+			{
+				auto buffer = context->CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 256 * (i + 1), GVK_HOST_WRITE_SEQUENTIAL);
+				if (!buffer.has_value() || !buffers.Add((uint64_t)buffer.value()->GetBuffer())) failures++;
+				else
+				{
+					round_buffers.push_back(buffer.value());
+					created++;
+				}
+
+				auto image = context->CreateImage(GvkImageCreateInfo::Image2D(VK_FORMAT_R8G8B8A8_UNORM, 16 + i, 16,
+					VK_IMAGE_USAGE_SAMPLED_BIT));
+				if (!image.has_value() || !images.Add((uint64_t)image.value()->GetImage())) failures++;
+				else
+				{
+					round_images.push_back(image.value());
+					created++;
+					//views are staged by the image,the second call of the same range must return the staged view
+					auto view = image.value()->CreateView(VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1, VK_IMAGE_VIEW_TYPE_2D);
+					auto staged = image.value()->CreateView(VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1, VK_IMAGE_VIEW_TYPE_2D);
+					if (!view.has_value() || !staged.has_value() || view.value() != staged.value() ||
+						!views.Add((uint64_t)view.value())) failures++;
+				}
+
+				VkSamplerCreateInfo sampler_info{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+				sampler_info.maxLod = (float)i;
+				auto sampler = context->CreateSampler(sampler_info);
+				if (!sampler.has_value() || !samplers.Add((uint64_t)sampler.value())) failures++;
+				else
+				{
+					round_samplers.push_back(sampler.value());
+					created++;
+				}
+			}
+
+			//queues return to the context when they are destroyed.
+			//devices may expose fewer queues than threads,so a thread may find none left
+			if (auto queue = context->CreateQueue(VK_QUEUE_GRAPHICS_BIT); queue.has_value())
+			{
+				if (!queues.Add((uint64_t)queue.value().get())) failures++;
+				else
+				{
+					round_queue = queue.value();
+					created++;
+				}
+			}
+
+			//destroy in a different order on every thread so destructions interleave with creations
+			if (thread_index % 2 == 0)
+			{
+				std::reverse(round_buffers.begin(), round_buffers.end());
+				std::reverse(round_images.begin(), round_images.end());
+			}
+			for (auto& buffer : round_buffers)
+			{
+				if (!buffers.Remove((uint64_t)buffer->GetBuffer())) failures++;
+				buffer = nullptr;
+				destroyed++;
+			}
+			for (auto& image : round_images)
+			{
+				if (!images.Remove((uint64_t)image->GetImage())) failures++;
+				for (auto view : image->GetViews())
+				{
+					if (!views.Remove((uint64_t)view)) failures++;
+				}
+				image = nullptr;
+				destroyed++;
+			}
+			for (auto sampler : round_samplers)
+			{
+				if (!samplers.Remove((uint64_t)sampler)) failures++;
+				context->DestroySampler(sampler);
+				destroyed++;
+			}
+			if (round_queue != nullptr)
+			{
+				if (!queues.Remove((uint64_t)round_queue.get())) failures++;
+				round_queue = nullptr;
+				destroyed++;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32 i = 0; i < thread_count; i++)
+	{
+		threads.emplace_back(worker, i);
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	//buffers and images are destroyed by the release queue
+	context->WaitForDeviceIdle();
+	uint32 pending = context->GetReleaseQueue()->GetPendingCount();
+	bool leaked = !buffers.handles.empty() || !images.handles.empty() || !views.handles.empty() ||
+		!samplers.handles.empty() || !queues.handles.empty();
+
+	printf("created %u destroyed %u failures %u pending releases %u\n", created.load(), destroyed.load(), failures.load(), pending);
+	if (failures != 0 || created != destroyed || pending != 0 || leaked)
+	{
+		printf("stress test failed\n");
+		return -1;
+	}
+	printf("stress test passed\n");
+	return 0;
+}
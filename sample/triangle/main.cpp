@@ -47,6 +47,13 @@ int main()
 
 	uint32 back_buffer_count = context->GetBackBufferCount();
 
+	//frames in flight,AcquireNextImage waits for the frame with the same index and recycles its command buffers
+	if (!context->InitializeFrameRing(GvkFrameRingCreateInfo{}, &error))
+	{
+		printf("fail to initialize frame ring reason %s\n", error.c_str());
+		return -1;
+	}
+
 	const char* include_directorys[] = { TRIANGLE_SHADER_DIRECTORY};
 
 	auto vert = context->CompileShader("triangle.vert", gvk::ShaderMacros(),
@@ -111,12 +118,7 @@ int main()
 	buffer->Write(vertexs, 0, sizeof(vertexs));
 
 	ptr<gvk::CommandQueue> queue;
-	ptr<gvk::CommandPool>  pool;
-	std::vector<VkCommandBuffer>	cmd_buffers(back_buffer_count);
 	require(context->CreateQueue(VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_TRANSFER_BIT), queue);
-	require(context->CreateCommandPool(queue.get()), pool);
-	for(uint32 i = 0;i < back_buffer_count;i++)
-		require(pool->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY), cmd_buffers[i]);
 
 	std::vector<VkSemaphore> color_output_finish(back_buffer_count);
 	for(uint32 i = 0;i < back_buffer_count;i++)
@@ -196,23 +198,8 @@ int main()
 		.ImageWrite(descriptor_set, "my_texture",sampler , view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
 		.Emit(context->GetDevice());
 
-	uint32 i = 0;
-	std::vector<VkFence> fence(back_buffer_count);
-	for (uint32 i = 0;i < back_buffer_count;i++) 
-	{
-		//it is handy when implementing frame in flight
-		require(context->CreateFence(VK_FENCE_CREATE_SIGNALED_BIT), fence[i]);
-	}
 	while (!window->ShouldClose()) 
 	{
-		uint32 current_frame_idx = context->CurrentFrameIndex();
-		vkWaitForFences(context->GetDevice(), 1, &fence[current_frame_idx], VK_TRUE, 0xffffffff);
-		vkResetFences(context->GetDevice(), 1, &fence[current_frame_idx]);
-		
-
-		VkCommandBuffer cmd_buffer = cmd_buffers[current_frame_idx];
-		vkResetCommandBuffer(cmd_buffer, 0);
-
 		VkCommandBufferBeginInfo begin{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 		begin.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
 		ptr<gvk::Image> back_buffer;
@@ -250,6 +237,12 @@ int main()
 			break;
 		}
 
+		//the frame has begun after the image is acquired,its command buffers are free to record
+		FrameContext& frame = context->GetFrameRing()->GetCurrentFrame();
+		uint32 current_frame_idx = frame.GetIndex();
+		VkCommandBuffer cmd_buffer;
+		require(frame.AllocateCommandBuffer(), cmd_buffer);
+
 		if (vkBeginCommandBuffer(cmd_buffer, &begin) != VK_SUCCESS) 
 		{
 			return 0;
@@ -310,7 +303,7 @@ int main()
 		queue->Submit(&cmd_buffer, 1,
 			gvk::SemaphoreInfo()
 			.Wait(acquire_image_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
-			.Signal(color_output_finish[current_frame_idx]), fence[current_frame_idx]
+			.Signal(color_output_finish[current_frame_idx]), NULL
 		);
 
 		context->Present(gvk::SemaphoreInfo().Wait(color_output_finish[current_frame_idx], 0));
@@ -321,7 +314,6 @@ int main()
 
 	for (auto fb : frame_buffers) context->DestroyFrameBuffer(fb);
 	for(auto sm : color_output_finish)  context->DestroyVkSemaphore(sm);
-	for (auto f : fence) context->DestroyFence(f);
 	context->DestroySampler(sampler);
 
 	buffer = nullptr;
@@ -6,3 +6,9 @@
 #include "gvk_window.h"
 #include "gvk_context.h"
 #include "gvk_raytracing.h"
+#include "gvk_bindless.h"
+#include "gvk_descriptor_buffer.h"
+#include "gvk_uniform_ring.h"
+#include "gvk_render_queue.h"
+#include "gvk_frame.h"
+#include "gvk_release.h"
@@ -0,0 +1,257 @@
+#include "gvk_bindless.h"
+#include "gvk_context.h"
+
+namespace gvk {
+
+	BindlessHeap::BindlessHeap(VkDevice device, VkDescriptorPool pool, Heap heaps[GVK_BINDLESS_RESOURCE_COUNT], ptr<ReleaseQueue> release_queue)
+		:m_Device(device), m_Pool(pool), m_ReleaseQueue(release_queue)
+	{
+		for (uint32 i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+		{
+			m_Heaps[i] = std::move(heaps[i]);
+		}
+	}
+
+	BindlessHeap::~BindlessHeap()
+	{
+		//descriptor sets are released with the pool
+		vkDestroyDescriptorPool(m_Device, m_Pool, nullptr);
+	}
+
+	opt<uint32> BindlessHeap::AllocateSlot(Heap& heap)
+	{
+		if (!heap.free_slots.empty())
+		{
+			uint32 slot = heap.free_slots.back();
+			heap.free_slots.pop_back();
+			return slot;
+		}
+		if (heap.next_slot < heap.capacity)
+		{
+			return heap.next_slot++;
+		}
+		return std::nullopt;
+	}
+
+	opt<uint32> BindlessHeap::AddTexture(VkImageView view, VkImageLayout layout)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Heap& heap = m_Heaps[GVK_BINDLESS_RESOURCE_TEXTURE];
+		auto slot = AllocateSlot(heap);
+		if (!slot.has_value()) return std::nullopt;
+
+		VkDescriptorImageInfo image_info{};
+		image_info.imageView = view;
+		image_info.imageLayout = layout;
+
+		VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = heap.set;
+		write.dstBinding = 0;
+		write.dstArrayElement = slot.value();
+		write.descriptorCount = 1;
+		write.descriptorType = heap.type;
+		write.pImageInfo = &image_info;
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return slot;
+	}
+
+	opt<uint32> BindlessHeap::AddSampler(VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Heap& heap = m_Heaps[GVK_BINDLESS_RESOURCE_SAMPLER];
+		auto slot = AllocateSlot(heap);
+		if (!slot.has_value()) return std::nullopt;
+
+		VkDescriptorImageInfo image_info{};
+		image_info.sampler = sampler;
+
+		VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = heap.set;
+		write.dstBinding = 0;
+		write.dstArrayElement = slot.value();
+		write.descriptorCount = 1;
+		write.descriptorType = heap.type;
+		write.pImageInfo = &image_info;
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return slot;
+	}
+
+	opt<uint32> BindlessHeap::AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		Heap& heap = m_Heaps[GVK_BINDLESS_RESOURCE_STORAGE_BUFFER];
+		auto slot = AllocateSlot(heap);
+		if (!slot.has_value()) return std::nullopt;
+
+		VkDescriptorBufferInfo buffer_info{};
+		buffer_info.buffer = buffer;
+		buffer_info.offset = offset;
+		buffer_info.range = size;
+
+		VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		write.dstSet = heap.set;
+		write.dstBinding = 0;
+		write.dstArrayElement = slot.value();
+		write.descriptorCount = 1;
+		write.descriptorType = heap.type;
+		write.pBufferInfo = &buffer_info;
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return slot;
+	}
+
+	void BindlessHeap::Release(GVK_BINDLESS_RESOURCE type, uint32 handle)
+	{
+		gvk_assert(type < GVK_BINDLESS_RESOURCE_COUNT);
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			gvk_assert(handle < m_Heaps[type].next_slot);
+		}
+		//the heap may be destroyed before the commands using the slot have finished
+		std::weak_ptr<BindlessHeap> heap = weak_from_this();
+		m_ReleaseQueue->Release([heap, type, handle]()
+			{
+				if (auto target = heap.lock())
+				{
+					target->RecycleSlot(type, handle);
+				}
+			});
+	}
+
+	void BindlessHeap::RecycleSlot(GVK_BINDLESS_RESOURCE type, uint32 handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Heaps[type].free_slots.push_back(handle);
+	}
+
+	ptr<DescriptorSetLayout> BindlessHeap::GetLayout(GVK_BINDLESS_RESOURCE type)
+	{
+		gvk_assert(type < GVK_BINDLESS_RESOURCE_COUNT);
+		return m_Heaps[type].layout;
+	}
+
+	VkDescriptorSet BindlessHeap::GetDescriptorSet(GVK_BINDLESS_RESOURCE type)
+	{
+		gvk_assert(type < GVK_BINDLESS_RESOURCE_COUNT);
+		return m_Heaps[type].set;
+	}
+
+	uint32 BindlessHeap::GetCapacity(GVK_BINDLESS_RESOURCE type)
+	{
+		gvk_assert(type < GVK_BINDLESS_RESOURCE_COUNT);
+		return m_Heaps[type].capacity;
+	}
+
+	void BindlessHeap::Bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32 first_set)
+	{
+		VkDescriptorSet sets[GVK_BINDLESS_RESOURCE_COUNT];
+		for (uint32 i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+		{
+			sets[i] = m_Heaps[i].set;
+		}
+		vkCmdBindDescriptorSets(cmd, bind_point, layout, first_set, GVK_BINDLESS_RESOURCE_COUNT, sets, 0, nullptr);
+	}
+
+	bool Context::InitializeBindlessHeap(const GvkBindlessHeapCreateInfo& info, std::string* error)
+	{
+		gvk_assert(m_BindlessHeap == nullptr);
+		if (m_DescriptorBufferEnabled)
+		{
+			if (error) *error = "gvk : bindless heap is allocated from descriptor pools, it can't be used with descriptor buffers";
+			return false;
+		}
+
+		BindlessHeap::Heap heaps[GVK_BINDLESS_RESOURCE_COUNT];
+		heaps[GVK_BINDLESS_RESOURCE_TEXTURE].type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		heaps[GVK_BINDLESS_RESOURCE_TEXTURE].capacity = info.texture_count;
+		heaps[GVK_BINDLESS_RESOURCE_SAMPLER].type = VK_DESCRIPTOR_TYPE_SAMPLER;
+		heaps[GVK_BINDLESS_RESOURCE_SAMPLER].capacity = info.sampler_count;
+		heaps[GVK_BINDLESS_RESOURCE_STORAGE_BUFFER].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		heaps[GVK_BINDLESS_RESOURCE_STORAGE_BUFFER].capacity = info.storage_buffer_count;
+
+		std::vector<VkDescriptorPoolSize> pool_sizes;
+		for (uint32 i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+		{
+			auto& heap = heaps[i];
+			if (heap.capacity == 0)
+			{
+				if (error) *error = "gvk : fail to initialize bindless heap, capacity of every resource type should not be 0";
+				return false;
+			}
+
+			//slots not written are never accessed by shaders,so the binding is partially bound
+			VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+			VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+			flags_info.bindingCount = 1;
+			flags_info.pBindingFlags = &binding_flags;
+
+			VkDescriptorSetLayoutBinding binding{};
+			binding.binding = 0;
+			binding.descriptorType = heap.type;
+			binding.descriptorCount = heap.capacity;
+			binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+			VkDescriptorSetLayoutCreateInfo layout_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+			layout_info.pNext = &flags_info;
+			layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+			layout_info.bindingCount = 1;
+			layout_info.pBindings = &binding;
+
+			auto layout = AcquireDescriptorSetLayout(layout_info, { binding_flags });
+			if (!layout.has_value())
+			{
+				if (error) *error = "gvk : fail to create descriptor set layout for bindless heap";
+				return false;
+			}
+			//heap layouts are not created from shaders,the set index is the resource type
+			heap.layout = ptr<DescriptorSetLayout>(new DescriptorSetLayout(layout.value(), {}, {}, i, m_Device, heap.capacity, true));
+
+			pool_sizes.push_back(VkDescriptorPoolSize{ heap.type, heap.capacity });
+		}
+
+		VkDescriptorPoolCreateInfo pool_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+		pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		pool_info.maxSets = GVK_BINDLESS_RESOURCE_COUNT;
+		pool_info.poolSizeCount = pool_sizes.size();
+		pool_info.pPoolSizes = pool_sizes.data();
+
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(m_Device, &pool_info, nullptr, &pool) != VK_SUCCESS)
+		{
+			if (error) *error = "gvk : fail to create descriptor pool for bindless heap";
+			return false;
+		}
+
+		VkDescriptorSetLayout layouts[GVK_BINDLESS_RESOURCE_COUNT];
+		VkDescriptorSet sets[GVK_BINDLESS_RESOURCE_COUNT];
+		for (uint32 i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+		{
+			layouts[i] = heaps[i].layout->GetLayout();
+		}
+
+		VkDescriptorSetAllocateInfo alloc_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		alloc_info.descriptorPool = pool;
+		alloc_info.descriptorSetCount = GVK_BINDLESS_RESOURCE_COUNT;
+		alloc_info.pSetLayouts = layouts;
+		if (vkAllocateDescriptorSets(m_Device, &alloc_info, sets) != VK_SUCCESS)
+		{
+			vkDestroyDescriptorPool(m_Device, pool, nullptr);
+			if (error) *error = "gvk : fail to allocate descriptor sets for bindless heap";
+			return false;
+		}
+		for (uint32 i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+		{
+			heaps[i].set = sets[i];
+		}
+
+		m_BindlessHeap = ptr<BindlessHeap>(new BindlessHeap(m_Device, pool, heaps, m_ReleaseQueue));
+		return true;
+	}
+
+	ptr<BindlessHeap> Context::GetBindlessHeap()
+	{
+		return m_BindlessHeap;
+	}
+}
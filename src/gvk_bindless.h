@@ -0,0 +1,102 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_pipeline.h"
+#include "gvk_release.h"
+#include <mutex>
+
+enum GVK_BINDLESS_RESOURCE
+{
+	//sampled images,declared as texture2D/textureCube... arrays in shaders
+	GVK_BINDLESS_RESOURCE_TEXTURE,
+	GVK_BINDLESS_RESOURCE_SAMPLER,
+	GVK_BINDLESS_RESOURCE_STORAGE_BUFFER,
+
+	GVK_BINDLESS_RESOURCE_COUNT
+};
+
+struct GvkBindlessHeapCreateInfo
+{
+	//capacity of every resource type,limited by maxDescriptorSetUpdateAfterBind* of the device
+	uint32_t texture_count		  = 16384;
+	uint32_t sampler_count		  = 256;
+	uint32_t storage_buffer_count = 16384;
+};
+
+namespace gvk {
+
+	//context wide bindless descriptor heap.
+	//every resource type lives in one large update-after-bind descriptor set with a single array at binding 0.
+	//resources are added to free slots and referenced in shaders by the returned handle,for example
+	//  layout(set = 0, binding = 0) uniform texture2D textures[];
+	//  texture(sampler2D(textures[nonuniformEXT(handle)], samplers[sampler_handle]), uv);
+	//slots released are recycled after the gpu work submitted before the release has finished
+	class BindlessHeap : public std::enable_shared_from_this<BindlessHeap>
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Write a sampled image to a free slot of the texture heap
+		/// </summary>
+		/// <returns>handle of the slot,nullopt if the heap is full</returns>
+		opt<uint32_t>			 AddTexture(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		/// <summary>
+		/// Write a sampler to a free slot of the sampler heap
+		/// </summary>
+		/// <returns>handle of the slot,nullopt if the heap is full</returns>
+		opt<uint32_t>			 AddSampler(VkSampler sampler);
+
+		/// <summary>
+		/// Write a storage buffer range to a free slot of the storage buffer heap
+		/// </summary>
+		/// <returns>handle of the slot,nullopt if the heap is full</returns>
+		opt<uint32_t>			 AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		/// <summary>
+		/// Release a slot.The slot is reused after the gpu work submitted before the call has finished,
+		/// the resource it refers to must stay alive until then
+		/// </summary>
+		/// <param name="type">type of the heap the handle is allocated from</param>
+		/// <param name="handle">handle returned by Add*</param>
+		void					 Release(GVK_BINDLESS_RESOURCE type, uint32_t handle);
+
+		/// <summary>
+		/// Get the layout of a heap.Add it to GvkDescriptorLayoutHint by AddBindlessHeap
+		/// to make pipelines compatible with the heap
+		/// </summary>
+		ptr<DescriptorSetLayout> GetLayout(GVK_BINDLESS_RESOURCE type);
+		VkDescriptorSet			 GetDescriptorSet(GVK_BINDLESS_RESOURCE type);
+		uint32_t				 GetCapacity(GVK_BINDLESS_RESOURCE type);
+
+		/// <summary>
+		/// Bind all heaps to consecutive set slots starting from first_set,in the order of GVK_BINDLESS_RESOURCE
+		/// </summary>
+		void					 Bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t first_set);
+
+		~BindlessHeap();
+	private:
+		struct Heap
+		{
+			ptr<DescriptorSetLayout> layout;
+			VkDescriptorSet			 set = NULL;
+			VkDescriptorType		 type;
+			uint32_t				 capacity = 0;
+			//slots never used are handed out in order before the free list is used
+			uint32_t				 next_slot = 0;
+			std::vector<uint32_t>	 free_slots;
+		};
+
+		BindlessHeap(VkDevice device, VkDescriptorPool pool, Heap heaps[GVK_BINDLESS_RESOURCE_COUNT], ptr<ReleaseQueue> release_queue);
+
+		opt<uint32_t>			 AllocateSlot(Heap& heap);
+		//called by the release queue after the gpu has finished with the slot
+		void					 RecycleSlot(GVK_BINDLESS_RESOURCE type, uint32_t handle);
+
+		VkDevice				 m_Device;
+		VkDescriptorPool		 m_Pool;
+		Heap					 m_Heaps[GVK_BINDLESS_RESOURCE_COUNT];
+		ptr<ReleaseQueue>		 m_ReleaseQueue;
+		//descriptor set updates need external synchronization
+		std::mutex				 m_Lock;
+	};
+}
@@ -27,22 +27,25 @@ namespace gvk {
 		vkGetDeviceQueue(m_Device, info.family_index, info.queue_index, &queue);
 		if (queue == NULL) return std::nullopt;
 
-		//create a fence for queue for cpu synchronization
-		VkFence fence;
-		if (auto v = CreateFence(VK_FENCE_CREATE_SIGNALED_BIT); v.has_value()) {
-			fence = v.value();
+		//create a timeline semaphore for queue to track its submissions
+		VkSemaphore timeline;
+		if (auto v = CreateTimelineSemaphore(0); v.has_value()) {
+			timeline = v.value();
 		}
 		else {
 			return std::nullopt;
 		}
 
 		m_RequiredQueueInfos.erase(m_RequiredQueueInfos.begin() + idx);
-		ptr<CommandQueue> queue_ptr(new CommandQueue(queue, info.family_index, info.queue_index, info.priority, fence, m_Device));
+		ptr<CommandQueue> queue_ptr(new CommandQueue(queue, info.family_index, info.queue_index, info.priority, timeline, m_Device));
 		queue_ptr->m_Context = this;
+		m_ReleaseQueue->AddQueue(queue_ptr.get());
 		return { queue_ptr };
 	}
 
 	opt<ptr<CommandQueue>> Context::CreateQueue(VkFlags flags, float priority) {
+		//the queue found must not be taken by another thread before it is consumed
+		std::lock_guard lock(m_QueueInfoLock);
 		uint32 queue_idx;
 		if (auto v = FindSuitableQueueIndex(flags, priority); v.has_value()) {
 			queue_idx = v.value();
@@ -69,6 +72,64 @@ namespace gvk {
 		return ptr<CommandPool>(new CommandPool(cmd_pool, queue->QueueFamily(), m_Device));
 	}
 
+	opt<ptr<SecondaryCommandRecorder>> Context::CreateSecondaryCommandRecorder(const CommandQueue* queue, uint32_t worker_count, uint32_t frame_count)
+	{
+		ptr<ThreadPool> thread_pool = GetThreadPool();
+		//the calling thread records a range too
+		worker_count = worker_count != 0 ? worker_count : thread_pool->GetThreadCount() + 1;
+		frame_count = frame_count != 0 ? frame_count : m_BackBufferCount;
+
+		std::vector<SecondaryCommandRecorder::WorkerPool> pools(worker_count * frame_count);
+		for (auto& pool : pools)
+		{
+			VkCommandPoolCreateInfo info{};
+			info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			//command buffers are reset with the pool,not one by one
+			info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			info.queueFamilyIndex = queue->QueueFamily();
+			VkCommandPool cmd_pool;
+			if (vkCreateCommandPool(m_Device, &info, nullptr, &cmd_pool) != VK_SUCCESS) {
+				return std::nullopt;
+			}
+			pool.pool = ptr<CommandPool>(new CommandPool(cmd_pool, queue->QueueFamily(), m_Device));
+		}
+		return ptr<SecondaryCommandRecorder>(new SecondaryCommandRecorder(thread_pool, std::move(pools), worker_count));
+	}
+
+	ptr<CommandPool> Context::GetThreadCommandPool(const CommandQueue* queue)
+	{
+		//pools are owned by the context,threads only keep weak references
+		thread_local std::unordered_map<uint64_t, std::weak_ptr<CommandPool>> thread_pools;
+		//one pool for every queue family of a context
+		uint64_t key = (m_ContextId << 8) | queue->QueueFamily();
+		if (auto iter = thread_pools.find(key); iter != thread_pools.end())
+		{
+			if (auto pool = iter->second.lock())
+			{
+				return pool;
+			}
+		}
+
+		auto pool = CreateCommandPool(queue);
+		if (!pool.has_value())
+		{
+			return nullptr;
+		}
+		std::vector<ThreadObject<CommandPool>> exited;
+		{
+			std::lock_guard<std::mutex> lock(m_ThreadCommandPoolLock);
+			exited = PruneThreadObjects(m_ThreadCommandPools);
+			m_ThreadCommandPools.push_back(ThreadObject<CommandPool>{ GetThreadToken(), pool.value() });
+		}
+		//command buffers of exited threads may still be executing
+		for (auto& object : exited)
+		{
+			m_ReleaseQueue->Release(object.object);
+		}
+		thread_pools[key] = pool.value();
+		return pool.value();
+	}
+
 	void Context::OnCommandQueueDestroy(CommandQueue* queue)
 	{
 		gvk_assert(queue != nullptr);
@@ -80,103 +141,364 @@ namespace gvk {
 		auto queue_family_props = m_DevicePropertiesFeature.QueueFamilyProperties();
 		info.flags = queue_family_props[info.family_index].props.queueFlags;
 		info.priority = queue->m_Priority;
-		m_RequiredQueueInfos.push_back(info);
+		{
+			std::lock_guard lock(m_QueueInfoLock);
+			m_RequiredQueueInfos.push_back(info);
+		}
+		//the queue has waited for its submissions
+		m_ReleaseQueue->RemoveQueue(queue);
 
-		if (queue->m_Fence != nullptr) {
-			vkDestroyFence(m_Device, queue->m_Fence, nullptr);
+		if (queue->m_TimelineSemaphore != nullptr) {
+			vkDestroySemaphore(m_Device, queue->m_TimelineSemaphore, nullptr);
 		}
 	}
 
 
-	VkResult CommandQueue::Submit(VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count,
-		const SemaphoreInfo& semaphore, VkFence target_fence, bool stall_for_device /*= false*/)
+	opt<uint64_t> CommandQueue::Submit(VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count,
+		const SemaphoreInfo& semaphore, VkFence target_fence, bool stall_for_device /*= false*/, VkResult* result /*= nullptr*/)
 	{
-		gvk_assert(target_fence == NULL || !stall_for_device);
-		//reset the command queue's fence before submitting
+		SubmitGroup group{ cmd_buffers, cmd_buffer_count, &semaphore };
+		auto submission = SubmitGroups(&group, 1, {}, target_fence, result);
+		if (!submission.has_value()) return std::nullopt;
+
 		if (stall_for_device) 
 		{
-			vkResetFences(m_Device, 1, &m_Fence);
+			VkResult vkrs = Wait(submission.value());
+			if (result != nullptr) *result = vkrs;
+			if (vkrs != VK_SUCCESS) return std::nullopt;
 		}
 
-		VkSubmitInfo info{};
-		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		info.pNext = nullptr;
-		
-		info.commandBufferCount = cmd_buffer_count;
-		info.pCommandBuffers = cmd_buffers;
-		
-		info.pWaitDstStageMask = semaphore.wait_semaphore_stages.data();
-		info.pSignalSemaphores = semaphore.signal_semaphores.data();
-		info.signalSemaphoreCount = semaphore.signal_semaphores.size();
-
-		info.waitSemaphoreCount = semaphore.wait_semaphores.size();
-		info.pWaitSemaphores = semaphore.wait_semaphores.data();
-
-		
-		if (stall_for_device) target_fence = m_Fence;
-		VkResult vkrs = vkQueueSubmit(m_CommandQueue, 1, &info, target_fence);
-		if (vkrs != VK_SUCCESS) return vkrs;
+		return submission;
+	}
 
-		if (stall_for_device) 
+	opt<uint64_t> CommandQueue::Submit(SubmitBatch& batch, VkFence target_fence, VkResult* result)
+	{
+		batch.m_Submissions.clear();
+
+		//reject a batch that can't be submitted before any queue executes a part of it
+		bool valid = !batch.m_Groups.empty();
+		for (auto& group : batch.m_Groups)
+		{
+			valid &= group.queue == nullptr || group.queue->m_Context == m_Context;
+			valid &= std::find(group.cmd_buffers.begin(), group.cmd_buffers.end(), (VkCommandBuffer)NULL) == group.cmd_buffers.end();
+		}
+		if (!valid)
+		{
+			if (result != nullptr) *result = VK_ERROR_UNKNOWN;
+			return std::nullopt;
+		}
+
+		//groups of secondary queues are submitted first,so groups of this queue can wait for their semaphores
+		std::vector<CommandQueue*> queues;
+		for (auto& group : batch.m_Groups)
 		{
-			return vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, 0xffffffff);
+			if (group.queue != nullptr && group.queue != this &&
+				std::find(queues.begin(), queues.end(), group.queue) == queues.end())
+			{
+				queues.push_back(group.queue);
+			}
 		}
 
-		return VK_SUCCESS;
+		std::vector<SubmitGroup> groups;
+		std::vector<std::pair<VkSemaphore, uint64_t>> tail_waits;
+		for (auto queue : queues)
+		{
+			groups.clear();
+			for (auto& group : batch.m_Groups)
+			{
+				if (group.queue == queue)
+				{
+					groups.push_back(SubmitGroup{ group.cmd_buffers.data(), (uint32)group.cmd_buffers.size(), &group.semaphores });
+				}
+			}
+			auto submission = queue->SubmitGroups(groups.data(), groups.size(), {}, NULL, result);
+			//the queues submitted before keep executing,their submissions stay recorded in the batch
+			if (!submission.has_value())
+			{
+				return std::nullopt;
+			}
+			batch.m_Submissions.push_back(std::make_pair(queue, submission.value()));
+			tail_waits.push_back(std::make_pair(queue->m_TimelineSemaphore, submission.value()));
+		}
+
+		groups.clear();
+		for (auto& group : batch.m_Groups)
+		{
+			if (group.queue == nullptr || group.queue == this)
+			{
+				groups.push_back(SubmitGroup{ group.cmd_buffers.data(), (uint32)group.cmd_buffers.size(), &group.semaphores });
+			}
+		}
+		auto submission = SubmitGroups(groups.data(), groups.size(), tail_waits, target_fence, result);
+		if (submission.has_value())
+		{
+			batch.m_Submissions.push_back(std::make_pair(this, submission.value()));
+		}
+		return submission;
 	}
 
-	
+	opt<uint64_t> CommandQueue::SubmitGroups(const SubmitGroup* groups, uint32 group_count,
+		const std::vector<std::pair<VkSemaphore, uint64_t>>& tail_waits, VkFence target_fence, VkResult* result)
+	{
+		//an empty batch at the end waits for the secondary queues,
+		//so the fence and the timeline value of this submission cover the whole batch
+		//without blocking later work of this queue.
+		//timeline values are passed by VkTimelineSemaphoreSubmitInfo of core vulkan 1.2,
+		//vkQueueSubmit2 would need VK_KHR_synchronization2 or vulkan 1.3
+		bool has_tail = !tail_waits.empty();
+		uint32 info_count = group_count + (has_tail ? 1 : 0);
+		//nothing would signal the timeline semaphore or the fence
+		if (info_count == 0)
+		{
+			if (result != nullptr) *result = VK_ERROR_UNKNOWN;
+			return std::nullopt;
+		}
+
+		std::vector<VkSubmitInfo> infos(info_count, VkSubmitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO });
+		std::vector<VkTimelineSemaphoreSubmitInfo> timeline_infos(info_count, VkTimelineSemaphoreSubmitInfo{ VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO });
+		for (uint32 i = 0; i < group_count; i++)
+		{
+			const SemaphoreInfo& semaphore = *groups[i].semaphores;
+			auto& timeline_info = timeline_infos[i];
+			timeline_info.waitSemaphoreValueCount = semaphore.wait_values.size();
+			timeline_info.pWaitSemaphoreValues = semaphore.wait_values.data();
+			timeline_info.signalSemaphoreValueCount = semaphore.signal_values.size();
+			timeline_info.pSignalSemaphoreValues = semaphore.signal_values.data();
+
+			auto& info = infos[i];
+			info.pNext = &timeline_info;
+			info.commandBufferCount = groups[i].cmd_buffer_count;
+			info.pCommandBuffers = groups[i].cmd_buffers;
+			info.pWaitDstStageMask = semaphore.wait_semaphore_stages.data();
+			info.waitSemaphoreCount = semaphore.wait_semaphores.size();
+			info.pWaitSemaphores = semaphore.wait_semaphores.data();
+			info.pSignalSemaphores = semaphore.signal_semaphores.data();
+			info.signalSemaphoreCount = semaphore.signal_semaphores.size();
+		}
+
+		std::vector<VkSemaphore> tail_semaphores;
+		std::vector<uint64_t> tail_values;
+		std::vector<VkPipelineStageFlags> tail_stages;
+		for (auto& [semaphore, value] : tail_waits)
+		{
+			tail_semaphores.push_back(semaphore);
+			tail_values.push_back(value);
+			tail_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+
+		//the timeline semaphore of the queue is signaled by the last batch after the semaphores of the caller.
+		//signal operations of vkQueueSubmit include every command earlier in submission order
+		std::vector<VkSemaphore> signal_semaphores;
+		std::vector<uint64_t> signal_values;
+		if (!has_tail)
+		{
+			const SemaphoreInfo& semaphore = *groups[group_count - 1].semaphores;
+			signal_semaphores = semaphore.signal_semaphores;
+			signal_values = semaphore.signal_values;
+		}
+		signal_semaphores.push_back(m_TimelineSemaphore);
+		signal_values.push_back(0);
+
+		auto& last_timeline_info = timeline_infos[info_count - 1];
+		auto& last_info = infos[info_count - 1];
+		if (has_tail)
+		{
+			last_timeline_info.waitSemaphoreValueCount = tail_values.size();
+			last_timeline_info.pWaitSemaphoreValues = tail_values.data();
+			last_info.pNext = &last_timeline_info;
+			last_info.waitSemaphoreCount = tail_semaphores.size();
+			last_info.pWaitSemaphores = tail_semaphores.data();
+			last_info.pWaitDstStageMask = tail_stages.data();
+		}
+		last_timeline_info.signalSemaphoreValueCount = signal_values.size();
+		last_timeline_info.pSignalSemaphoreValues = signal_values.data();
+		last_info.signalSemaphoreCount = signal_semaphores.size();
+		last_info.pSignalSemaphores = signal_semaphores.data();
+
+		uint64_t submission;
+		VkResult vkrs;
+		{
+			std::lock_guard lock(m_SubmitLock);
+			submission = m_LastSubmission + 1;
+			signal_values.back() = submission;
+
+			vkrs = vkQueueSubmit(m_CommandQueue, info_count, infos.data(), target_fence);
+			if (vkrs == VK_SUCCESS)
+			{
+				m_LastSubmission = submission;
+			}
+		}
+		if (result != nullptr) *result = vkrs;
+		if (vkrs != VK_SUCCESS) return std::nullopt;
+		return submission;
+	}
+
+	bool CommandQueue::IsComplete(uint64_t submission)
+	{
+		if (submission <= m_CompletedSubmission)
+		{
+			return true;
+		}
+		return submission <= CompletedSubmission();
+	}
+
+	VkResult CommandQueue::Wait(uint64_t submission, int64_t timeout)
+	{
+		gvk_assert(submission <= m_LastSubmission);
+		if (submission <= m_CompletedSubmission)
+		{
+			return VK_SUCCESS;
+		}
+
+		VkSemaphoreWaitInfo wait_info{};
+		wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores = &m_TimelineSemaphore;
+		wait_info.pValues = &submission;
+		VkResult vkrs = vkWaitSemaphores(m_Device, &wait_info, timeout < 0 ? UINT64_MAX : (uint64_t)timeout);
+		if (vkrs == VK_SUCCESS)
+		{
+			//other threads may have observed a larger value
+			uint64_t completed = m_CompletedSubmission;
+			while (completed < submission && !m_CompletedSubmission.compare_exchange_weak(completed, submission));
+		}
+		return vkrs;
+	}
+
+	VkResult CommandQueue::WaitIdle(int64_t timeout)
+	{
+		return Wait(m_LastSubmission, timeout);
+	}
+
+	uint64_t CommandQueue::LastSubmission()
+	{
+		return m_LastSubmission;
+	}
+
+	uint64_t CommandQueue::CompletedSubmission()
+	{
+		uint64_t value = 0;
+		if (vkGetSemaphoreCounterValue(m_Device, m_TimelineSemaphore, &value) != VK_SUCCESS)
+		{
+			return m_CompletedSubmission;
+		}
+		uint64_t completed = m_CompletedSubmission;
+		while (completed < value && !m_CompletedSubmission.compare_exchange_weak(completed, value));
+		return std::max(completed, value);
+	}
 
 	VkResult CommandQueue::SubmitTemporalCommand(std::function<void(VkCommandBuffer)> command, 
 		const SemaphoreInfo& info, VkFence target_fence, bool stall_for_host)
 	{
-		if (m_TemporalBufferPool == NULL) 
+		VkResult result;
+		SubmitTemporal(command, info, target_fence, stall_for_host, &result);
+		return result;
+	}
+
+	opt<uint64_t> CommandQueue::SubmitTemporalCommandAsync(std::function<void(VkCommandBuffer)> command,
+		const SemaphoreInfo& info, VkResult* result)
+	{
+		return SubmitTemporal(command, info, NULL, false, result);
+	}
+
+	opt<uint64_t> CommandQueue::SubmitTemporal(const std::function<void(VkCommandBuffer)>& command,
+		const SemaphoreInfo& info, VkFence target_fence, bool stall_for_host, VkResult* result)
+	{
+		//command buffers of a pool can't be recorded by several threads at the same time,
+		//so temporal command buffers come from the pool of the calling thread and are recorded without lock
+		ptr<CommandPool> pool = m_Context->GetThreadCommandPool(this);
+		if (pool == nullptr)
+		{
+			if (result != nullptr) *result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			return std::nullopt;
+		}
+
+		VkCommandBuffer cmd_buffer = NULL;
+		VkResult vkrs;
 		{
-			VkCommandPoolCreateInfo cmd_pool_info{};
-			cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-			cmd_pool_info.pNext = nullptr;
-			cmd_pool_info.queueFamilyIndex = m_QueueFamilyIndex;
-			// VK_COMMAND_POOL_CREATE_TRANSIENT_BIT specifies that command buffers allocated from the pool will be short-lived,
-			// meaning that they will be reset or freed in a relatively short timeframe. 
-			cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			//the lock only guards the lists,the command may submit to this queue again
+			std::lock_guard lock(m_TemporalBufferLock);
+			//command buffers of finished submissions can be recorded again
+			uint64_t completed = CompletedSubmission();
+			for (uint32 i = 0; i < m_PendingTemporalBuffers.size();)
+			{
+				if (m_PendingTemporalBuffers[i].first <= completed)
+				{
+					m_FreeTemporalBuffers.push_back(std::move(m_PendingTemporalBuffers[i].second));
+					m_PendingTemporalBuffers[i] = std::move(m_PendingTemporalBuffers.back());
+					m_PendingTemporalBuffers.pop_back();
+				}
+				else
+				{
+					i++;
+				}
+			}
 
-			VkResult create_result = vkCreateCommandPool(m_Device, &cmd_pool_info, nullptr, &m_TemporalBufferPool);
-			//fail to create command pool for command buffer
-			//return result
-			if (create_result != VK_SUCCESS) 
+			for (uint32 i = 0; i < m_FreeTemporalBuffers.size(); i++)
 			{
-				return create_result;
+				if (m_FreeTemporalBuffers[i].pool == pool)
+				{
+					cmd_buffer = m_FreeTemporalBuffers[i].cmd_buffer;
+					m_FreeTemporalBuffers[i] = std::move(m_FreeTemporalBuffers.back());
+					m_FreeTemporalBuffers.pop_back();
+					break;
+				}
 			}
 		}
 
-		VkCommandBufferAllocateInfo cmd_buffer_allocate{};
-		cmd_buffer_allocate.commandBufferCount = 1;
-		cmd_buffer_allocate.commandPool = m_TemporalBufferPool;
-		cmd_buffer_allocate.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		cmd_buffer_allocate.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cmd_buffer_allocate.pNext = nullptr;
-
-		VkCommandBuffer cmd_buffer;
-		VkResult vkrs = vkAllocateCommandBuffers(m_Device, &cmd_buffer_allocate, &cmd_buffer);
-		if (vkrs != VK_SUCCESS) 
+		if (cmd_buffer == NULL)
 		{
-			return vkrs;
+			VkCommandBufferAllocateInfo cmd_buffer_allocate{};
+			cmd_buffer_allocate.commandBufferCount = 1;
+			cmd_buffer_allocate.commandPool = pool->m_CommandPool;
+			cmd_buffer_allocate.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			cmd_buffer_allocate.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			cmd_buffer_allocate.pNext = nullptr;
+
+			vkrs = vkAllocateCommandBuffers(m_Device, &cmd_buffer_allocate, &cmd_buffer);
+			if (vkrs != VK_SUCCESS) 
+			{
+				if (result != nullptr) *result = vkrs;
+				return std::nullopt;
+			}
 		}
 
-		//begin recording commands for command buffer
+		//begin recording commands for command buffer,
+		//recycled command buffers are reset implicitly by vkBeginCommandBuffer
 		VkCommandBufferBeginInfo begin_info{};
 		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		vkrs = vkBeginCommandBuffer(cmd_buffer, &begin_info);
-		if (vkrs != VK_SUCCESS) return vkrs;
-		
-		//record commands
-		command(cmd_buffer);
-
-		vkrs = vkEndCommandBuffer(cmd_buffer);
-		if (vkrs != VK_SUCCESS) return vkrs;
-
-		return Submit(&cmd_buffer, 1, info, target_fence, stall_for_host);
+		if (vkrs == VK_SUCCESS)
+		{
+			//record commands
+			command(cmd_buffer);
+			vkrs = vkEndCommandBuffer(cmd_buffer);
+		}
+		opt<uint64_t> submission;
+		if (vkrs == VK_SUCCESS)
+		{
+			submission = Submit(&cmd_buffer, 1, info, target_fence, false, &vkrs);
+		}
+		{
+			std::lock_guard lock(m_TemporalBufferLock);
+			if (submission.has_value())
+			{
+				m_PendingTemporalBuffers.push_back(std::make_pair(submission.value(), TemporalBuffer{ pool, cmd_buffer }));
+			}
+			else
+			{
+				//the command buffer is not pending if the recording or the submission fails
+				m_FreeTemporalBuffers.push_back(TemporalBuffer{ pool, cmd_buffer });
+			}
+		}
+		if (submission.has_value() && stall_for_host)
+		{
+			vkrs = Wait(submission.value());
+			if (vkrs != VK_SUCCESS) submission = std::nullopt;
+		}
+		if (result != nullptr) *result = vkrs;
+		return submission;
 	}
 
 	void CommandQueue::SetDebugName(const std::string& name)
@@ -195,13 +517,18 @@ namespace gvk {
 
 	CommandQueue::~CommandQueue()
 	{
+		//the timeline semaphore can't be destroyed while submissions signaling it are pending
+		WaitIdle();
+		//temporal command buffers are freed with the pools of their threads
+		m_PendingTemporalBuffers.clear();
+		m_FreeTemporalBuffers.clear();
 		//collect allocated queue info
 		m_Context->OnCommandQueueDestroy(this);
 	}
 
-	CommandQueue::CommandQueue(VkQueue queue, uint32 queue_family, uint32 queue_index, float priority, VkFence fence,VkDevice device):
+	CommandQueue::CommandQueue(VkQueue queue, uint32 queue_family, uint32 queue_index, float priority, VkSemaphore timeline,VkDevice device):
 		m_CommandQueue(queue),m_QueueFamilyIndex(queue_family),m_QueueIndex(queue_index),m_Priority(priority),
-		m_Fence(fence),m_Device(device) , m_TemporalBufferPool(NULL)
+		m_TimelineSemaphore(timeline),m_Device(device)
 	{
 		m_Context = NULL;
 	}
@@ -211,6 +538,7 @@ namespace gvk {
 		VkCommandBufferAllocateInfo info{};
 		info.commandBufferCount = 1;
 		info.commandPool = m_CommandPool;
+		info.level = level;
 		info.pNext = nullptr;
 		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		VkCommandBuffer cmd_buffer;
@@ -221,6 +549,11 @@ namespace gvk {
 		return cmd_buffer;
 	}
 
+	VkResult CommandPool::Reset(bool release_resources)
+	{
+		return vkResetCommandPool(m_Device, m_CommandPool, release_resources ? VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT : 0);
+	}
+
 	void CommandPool::SetDebugName(const std::string& name)
 	{
 		VkDebugMarkerObjectNameInfoEXT info{};
@@ -247,6 +580,143 @@ namespace gvk {
 		m_CommandPool(pool),m_QueueFamilyIndex(queue_family),m_Device(device)
 	{}
 
+	SemaphoreInfo& SemaphoreInfo::Wait(const CommandQueue* queue, uint64_t submission, VkPipelineStageFlags stage)
+	{
+		gvk_assert(queue != nullptr);
+		wait_semaphores.push_back(queue->m_TimelineSemaphore);
+		wait_semaphore_stages.push_back(stage);
+		wait_values.push_back(submission);
+		return *this;
+	}
+
+	SubmitBatch& SubmitBatch::Add(const VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count, const SemaphoreInfo& info)
+	{
+		return Add(nullptr, cmd_buffers, cmd_buffer_count, info);
+	}
+
+	SubmitBatch& SubmitBatch::Add(CommandQueue* queue, const VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count, const SemaphoreInfo& info)
+	{
+		Group group;
+		group.queue = queue;
+		group.cmd_buffers.assign(cmd_buffers, cmd_buffers + cmd_buffer_count);
+		group.semaphores = info;
+		m_Groups.push_back(std::move(group));
+		return *this;
+	}
+
+	opt<uint64_t> SubmitBatch::GetSubmission(const CommandQueue* queue) const
+	{
+		for (auto& [submitted_queue, submission] : m_Submissions)
+		{
+			if (submitted_queue == queue) return submission;
+		}
+		return std::nullopt;
+	}
+
+	uint32 SubmitBatch::GroupCount() const
+	{
+		return m_Groups.size();
+	}
+
+	void SubmitBatch::Clear()
+	{
+		m_Groups.clear();
+		m_Submissions.clear();
+	}
+
+	VkResult SecondaryCommandRecorder::BeginFrame(uint32_t frame_index)
+	{
+		gvk_assert(frame_index * m_WorkerCount < m_Pools.size());
+		m_FrameIndex = frame_index;
+		for (uint32 i = 0; i < m_WorkerCount; i++)
+		{
+			auto& pool = m_Pools[frame_index * m_WorkerCount + i];
+			VkResult vkrs = pool.pool->Reset();
+			if (vkrs != VK_SUCCESS) return vkrs;
+			pool.used = 0;
+		}
+		return VK_SUCCESS;
+	}
+
+	VkResult SecondaryCommandRecorder::Record(RenderPassSecondaryContent& content, uint32_t item_count,
+		const std::function<void(VkCommandBuffer, uint32_t)>& record)
+	{
+		if (item_count == 0)
+		{
+			return VK_SUCCESS;
+		}
+
+		uint32 range_count = std::min(item_count, m_WorkerCount);
+		std::vector<VkCommandBuffer> cmd_buffers(range_count, NULL);
+		std::vector<VkResult> results(range_count, VK_SUCCESS);
+		WorkerPool* pools = m_Pools.data() + m_FrameIndex * m_WorkerCount;
+		auto range_begin = [&](uint32 range) { return (uint32)((uint64_t)item_count * range / range_count); };
+
+		//the calling thread records the first range
+		std::vector<std::future<void>> tasks;
+		for (uint32 i = 1; i < range_count; i++)
+		{
+			tasks.push_back(m_ThreadPool->Submit([&, i]()
+				{
+					results[i] = RecordRange(pools[i], content, range_begin(i), range_begin(i + 1), record, &cmd_buffers[i]);
+				}));
+		}
+		results[0] = RecordRange(pools[0], content, range_begin(0), range_begin(1), record, &cmd_buffers[0]);
+		for (auto& task : tasks)
+		{
+			m_ThreadPool->Wait(task);
+		}
+
+		for (auto result : results)
+		{
+			if (result != VK_SUCCESS) return result;
+		}
+		content.Execute(cmd_buffers.data(), range_count);
+		return VK_SUCCESS;
+	}
+
+	VkResult SecondaryCommandRecorder::RecordRange(WorkerPool& pool, const RenderPassSecondaryContent& content, uint32_t begin, uint32_t end,
+		const std::function<void(VkCommandBuffer, uint32_t)>& record, VkCommandBuffer* cmd_buffer)
+	{
+		//command buffers are reused by the frames with the same index after the pool is reset
+		if (pool.used == pool.cmd_buffers.size())
+		{
+			auto cmd = pool.pool->CreateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+			if (!cmd.has_value())
+			{
+				return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+			}
+			pool.cmd_buffers.push_back(cmd.value());
+		}
+		VkCommandBuffer cmd = pool.cmd_buffers[pool.used++];
+
+		VkCommandBufferBeginInfo begin_info{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		begin_info.pInheritanceInfo = content.GetInheritanceInfo();
+		VkResult vkrs = vkBeginCommandBuffer(cmd, &begin_info);
+		if (vkrs != VK_SUCCESS) return vkrs;
+
+		vkCmdSetViewport(cmd, 0, 1, &content.GetViewport());
+		vkCmdSetScissor(cmd, 0, 1, &content.GetScissor());
+		for (uint32 i = begin; i < end; i++)
+		{
+			record(cmd, i);
+		}
+
+		vkrs = vkEndCommandBuffer(cmd);
+		if (vkrs != VK_SUCCESS) return vkrs;
+		*cmd_buffer = cmd;
+		return VK_SUCCESS;
+	}
+
+	uint32_t SecondaryCommandRecorder::GetWorkerCount()
+	{
+		return m_WorkerCount;
+	}
+
+	SecondaryCommandRecorder::SecondaryCommandRecorder(ptr<ThreadPool> thread_pool, std::vector<WorkerPool>&& pools, uint32_t worker_count)
+		:m_ThreadPool(thread_pool), m_Pools(std::move(pools)), m_WorkerCount(worker_count) {}
+
 	gvk::SemaphoreInfo SemaphoreInfo::None()
 	{
 		return gvk::SemaphoreInfo();
@@ -371,3 +841,353 @@ VkDebugMarkerMarkerInfoEXT GvkDebugMarker::InitInfo(const float* color, const ch
 
 	return info;
 }
+
+bool GvkCommandRecorder::SetState::operator==(const SetState& other) const
+{
+	return set == other.set && layout == other.layout && offset_count == other.offset_count &&
+		std::equal(offsets.begin(), offsets.begin() + offset_count, other.offsets.begin());
+}
+
+GvkCommandRecorder::GvkCommandRecorder(VkCommandBuffer cmd)
+	:cmd(cmd) {}
+
+GvkCommandRecorder::BindPointState& GvkCommandRecorder::GetBindPointState(VkPipelineBindPoint bind_point)
+{
+	switch (bind_point)
+	{
+	case VK_PIPELINE_BIND_POINT_GRAPHICS:
+		return bind_points[0];
+	case VK_PIPELINE_BIND_POINT_COMPUTE:
+		return bind_points[1];
+	default:
+		gvk_assert(bind_point == VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR);
+		return bind_points[2];
+	}
+}
+
+void GvkCommandRecorder::BindPipeline(const gvk::ptr<gvk::Pipeline>& pipeline)
+{
+	BindPointState& state = GetBindPointState(pipeline->GetPipelineBindPoint());
+	//push constants pushed with another layout may be disturbed
+	if (pipeline->GetPipelineLayout() != push_constant_layout)
+	{
+		push_constant_known.reset();
+	}
+	state.layout = pipeline->GetPipelineLayout();
+	last_bind_point = pipeline->GetPipelineBindPoint();
+	if (state.pipeline == pipeline->GetPipeline())
+	{
+		stats.elided_pipeline_binds++;
+		return;
+	}
+	vkCmdBindPipeline(cmd, pipeline->GetPipelineBindPoint(), pipeline->GetPipeline());
+	state.pipeline = pipeline->GetPipeline();
+	stats.pipeline_binds++;
+}
+
+void GvkCommandRecorder::BindDescriptorSet(const gvk::ptr<gvk::DescriptorSet>& set, gvk::View<uint32_t> dynamic_offsets)
+{
+	gvk_assert(dynamic_offsets.size() == set->GetLayout()->GetDynamicOffsetCount());
+	BindPointState& state = GetBindPointState(last_bind_point);
+	gvk_assert(state.layout != NULL);
+	BindDescriptorSet(last_bind_point, state.layout, set->GetSetIndex(), set->GetDescriptorSet(), dynamic_offsets);
+}
+
+void GvkCommandRecorder::BindDescriptorSet(VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set_index, VkDescriptorSet set,
+	gvk::View<uint32_t> dynamic_offsets)
+{
+	gvk_assert(set_index < max_set_count);
+	gvk_assert(dynamic_offsets.size() <= max_dynamic_offset_count);
+	BindPointState& state = GetBindPointState(bind_point);
+
+	SetState& pending = state.pending[set_index];
+	pending.set = set;
+	pending.layout = layout;
+	pending.offset_count = dynamic_offsets.size();
+	for (uint32_t i = 0; i < dynamic_offsets.size(); i++)
+	{
+		pending.offsets[i] = dynamic_offsets[i];
+	}
+	state.pending_sets |= 1u << set_index;
+}
+
+void GvkCommandRecorder::BindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset)
+{
+	gvk_assert(binding < max_vertex_binding_count);
+	pending_vertex_buffers[binding] = buffer;
+	pending_vertex_offsets[binding] = offset;
+	pending_vertex_bindings |= 1u << binding;
+}
+
+void GvkCommandRecorder::BindVertexBuffer(uint32_t binding, const gvk::ptr<gvk::Buffer>& buffer, VkDeviceSize offset)
+{
+	BindVertexBuffer(binding, buffer->GetBuffer(), offset);
+}
+
+void GvkCommandRecorder::BindIndexBuffer(VkBuffer buffer, VkIndexType type, VkDeviceSize offset)
+{
+	if (index_buffer == buffer && index_offset == offset && index_type == type)
+	{
+		stats.elided_index_buffer_binds++;
+		return;
+	}
+	vkCmdBindIndexBuffer(cmd, buffer, offset, type);
+	index_buffer = buffer;
+	index_offset = offset;
+	index_type = type;
+	stats.index_buffer_binds++;
+}
+
+void GvkCommandRecorder::BindIndexBuffer(const gvk::ptr<gvk::Buffer>& buffer, VkIndexType type, VkDeviceSize offset)
+{
+	BindIndexBuffer(buffer->GetBuffer(), type, offset);
+}
+
+void GvkCommandRecorder::PushConstants(VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+	gvk_assert(offset + size <= max_push_constant_size);
+	//one vkCmdPushConstants only covers bytes of the same stages
+	if (push_constant_dirty.any() && stages != push_constant_stages)
+	{
+		FlushPushConstants(GetBindPointState(last_bind_point).layout);
+	}
+	push_constant_stages = stages;
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (uint32_t i = 0; i < size; i++)
+	{
+		uint32_t idx = offset + i;
+		if (push_constant_known[idx] && push_constant_byte_stages[idx] == stages && push_constants[idx] == bytes[i])
+		{
+			stats.elided_push_constant_bytes++;
+			continue;
+		}
+		push_constants[idx] = bytes[i];
+		push_constant_known[idx] = false;
+		push_constant_dirty[idx] = true;
+	}
+}
+
+void GvkCommandRecorder::PushConstants(const GvkPushConstant& push_constant, const void* data)
+{
+	PushConstants(push_constant.range.stageFlags, push_constant.range.offset, push_constant.range.size, data);
+}
+
+void GvkCommandRecorder::FlushPushConstants(VkPipelineLayout layout)
+{
+	if (!push_constant_dirty.any())
+	{
+		return;
+	}
+	gvk_assert(layout != NULL);
+	if (layout != push_constant_layout)
+	{
+		push_constant_known.reset();
+		push_constant_layout = layout;
+	}
+
+	//dirty bytes are merged across gaps of bytes already pushed with the same stages,
+	//pushing them again is valid and saves a call
+	auto mergeable = [&](uint32_t idx)
+	{
+		return push_constant_dirty[idx] || (push_constant_known[idx] && push_constant_byte_stages[idx] == push_constant_stages);
+	};
+	uint32_t idx = 0;
+	while (idx < max_push_constant_size)
+	{
+		if (!push_constant_dirty[idx])
+		{
+			idx++;
+			continue;
+		}
+		uint32_t begin = idx, end = idx + 1;
+		for (uint32_t i = idx + 1; i < max_push_constant_size && mergeable(i); i++)
+		{
+			if (push_constant_dirty[i]) end = i + 1;
+		}
+		vkCmdPushConstants(cmd, layout, push_constant_stages, begin, end - begin, push_constants.data() + begin);
+		stats.push_constant_updates++;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			push_constant_known[i] = true;
+			push_constant_byte_stages[i] = push_constant_stages;
+		}
+		idx = end;
+	}
+	push_constant_dirty.reset();
+}
+
+void GvkCommandRecorder::FlushDescriptorSets(VkPipelineBindPoint bind_point, BindPointState& state)
+{
+	uint32_t changed_sets = 0;
+	for (uint32_t i = 0; i < max_set_count; i++)
+	{
+		if (!(state.pending_sets & (1u << i))) continue;
+		if (state.pending[i] == state.bound[i])
+		{
+			stats.elided_descriptor_sets++;
+		}
+		else
+		{
+			changed_sets |= 1u << i;
+		}
+	}
+	state.pending_sets = 0;
+
+	//consecutive changed sets with the same layout are bound by one call
+	uint32_t i = 0;
+	while (i < max_set_count)
+	{
+		if (!(changed_sets & (1u << i)))
+		{
+			i++;
+			continue;
+		}
+		VkPipelineLayout layout = state.pending[i].layout;
+		std::array<VkDescriptorSet, max_set_count> sets;
+		std::array<uint32_t, max_set_count * max_dynamic_offset_count> offsets;
+		uint32_t first = i, count = 0, offset_count = 0;
+		for (; i < max_set_count && (changed_sets & (1u << i)) && state.pending[i].layout == layout; i++)
+		{
+			SetState& pending = state.pending[i];
+			sets[count++] = pending.set;
+			for (uint32_t j = 0; j < pending.offset_count; j++)
+			{
+				offsets[offset_count++] = pending.offsets[j];
+			}
+		}
+		vkCmdBindDescriptorSets(cmd, bind_point, layout, first, count, sets.data(), offset_count, offsets.data());
+		stats.descriptor_set_binds++;
+
+		//sets bound with other layouts may be disturbed
+		for (uint32_t j = 0; j < max_set_count; j++)
+		{
+			if (j >= first && j < first + count)
+			{
+				state.bound[j] = state.pending[j];
+			}
+			else if (state.bound[j].layout != layout)
+			{
+				state.bound[j] = SetState();
+			}
+		}
+	}
+}
+
+void GvkCommandRecorder::FlushVertexBuffers()
+{
+	uint32_t changed_bindings = 0;
+	for (uint32_t i = 0; i < max_vertex_binding_count; i++)
+	{
+		if (!(pending_vertex_bindings & (1u << i))) continue;
+		if (pending_vertex_buffers[i] == bound_vertex_buffers[i] && pending_vertex_offsets[i] == bound_vertex_offsets[i])
+		{
+			stats.elided_vertex_buffers++;
+		}
+		else
+		{
+			changed_bindings |= 1u << i;
+		}
+	}
+	pending_vertex_bindings = 0;
+
+	uint32_t i = 0;
+	while (i < max_vertex_binding_count)
+	{
+		if (!(changed_bindings & (1u << i)))
+		{
+			i++;
+			continue;
+		}
+		uint32_t first = i;
+		for (; i < max_vertex_binding_count && (changed_bindings & (1u << i)); i++)
+		{
+			bound_vertex_buffers[i] = pending_vertex_buffers[i];
+			bound_vertex_offsets[i] = pending_vertex_offsets[i];
+		}
+		vkCmdBindVertexBuffers(cmd, first, i - first, bound_vertex_buffers.data() + first, bound_vertex_offsets.data() + first);
+		stats.vertex_buffer_binds++;
+	}
+}
+
+void GvkCommandRecorder::Flush(VkPipelineBindPoint bind_point)
+{
+	BindPointState& state = GetBindPointState(bind_point);
+	if (state.pending_sets != 0)
+	{
+		FlushDescriptorSets(bind_point, state);
+	}
+	if (bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS && pending_vertex_bindings != 0)
+	{
+		FlushVertexBuffers();
+	}
+	FlushPushConstants(state.layout);
+}
+
+void GvkCommandRecorder::Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+	Flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	vkCmdDraw(cmd, vertex_count, instance_count, first_vertex, first_instance);
+}
+
+void GvkCommandRecorder::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+	Flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	vkCmdDrawIndexed(cmd, index_count, instance_count, first_index, vertex_offset, first_instance);
+}
+
+void GvkCommandRecorder::DrawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+	Flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	vkCmdDrawIndirect(cmd, buffer, offset, draw_count, stride);
+}
+
+void GvkCommandRecorder::DrawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+	Flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	vkCmdDrawIndexedIndirect(cmd, buffer, offset, draw_count, stride);
+}
+
+void GvkCommandRecorder::DrawMeshTasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	Flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	vkCmdDrawMeshTasksEXT(cmd, group_count_x, group_count_y, group_count_z);
+}
+
+void GvkCommandRecorder::Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	Flush(VK_PIPELINE_BIND_POINT_COMPUTE);
+	vkCmdDispatch(cmd, group_count_x, group_count_y, group_count_z);
+}
+
+void GvkCommandRecorder::DispatchIndirect(VkBuffer buffer, VkDeviceSize offset)
+{
+	Flush(VK_PIPELINE_BIND_POINT_COMPUTE);
+	vkCmdDispatchIndirect(cmd, buffer, offset);
+}
+
+void GvkCommandRecorder::Invalidate()
+{
+	//pending binds and push constants are kept,they are recorded at the next flush
+	for (auto& state : bind_points)
+	{
+		state.pipeline = NULL;
+		state.bound.fill(SetState());
+	}
+	bound_vertex_buffers.fill(NULL);
+	bound_vertex_offsets.fill(0);
+	index_buffer = NULL;
+	index_type = VK_INDEX_TYPE_MAX_ENUM;
+	push_constant_known.reset();
+	push_constant_layout = NULL;
+}
+
+VkCommandBuffer GvkCommandRecorder::GetCommandBuffer()
+{
+	return cmd;
+}
+
+const GvkCommandRecorder::Statistics& GvkCommandRecorder::GetStatistics()
+{
+	return stats;
+}
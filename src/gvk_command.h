@@ -2,7 +2,10 @@
 #include "gvk_common.h"
 #include "gvk_pipeline.h"
 #include "gvk_resource.h"
+#include "gvk_job.h"
 #include <functional>
+#include <bitset>
+#include <mutex>
 
 namespace gvk {
 	// We don't hide command pool from user because importance of command pool in multi-threading
@@ -25,6 +28,13 @@ namespace gvk {
 		/// <returns>The created command buffer</returns>
 		opt<VkCommandBuffer>  CreateCommandBuffer(VkCommandBufferLevel level);
 
+		/// <summary>
+		/// Reset every command buffer created from this command pool to the initial state.
+		/// The command buffers must not be pending execution
+		/// </summary>
+		/// <param name="release_resources">return the memory of the command buffers to the system</param>
+		VkResult Reset(bool release_resources = false);
+
 		void	SetDebugName(const std::string& name);
 
 		~CommandPool();
@@ -38,6 +48,8 @@ namespace gvk {
 		VkDevice      m_Device;
 	};
 
+	class CommandQueue;
+
 	class SemaphoreInfo 
 	{
 	private:
@@ -45,28 +57,86 @@ namespace gvk {
 		friend class Context;
 		std::vector<VkSemaphore> wait_semaphores;
 		std::vector<VkPipelineStageFlags> wait_semaphore_stages;
+		//values of timeline semaphores to wait,ignored for binary semaphores
+		std::vector<uint64_t>	 wait_values;
 		std::vector<VkSemaphore> signal_semaphores;
+		std::vector<uint64_t>	 signal_values;
 	public:
 
 		SemaphoreInfo& Wait(VkSemaphore wait_semaphore, VkPipelineStageFlags stage) 
 		{
 			wait_semaphores.push_back(wait_semaphore);
 			wait_semaphore_stages.push_back(stage);
+			wait_values.push_back(0);
 			return *this;
 		}
 
+		/// <summary>
+		/// Wait for a submission of another queue to finish
+		/// </summary>
+		/// <param name="queue">queue the submission is submitted to</param>
+		/// <param name="submission">id returned by CommandQueue::Submit</param>
+		/// <param name="stage">stages waiting for the submission</param>
+		SemaphoreInfo& Wait(const CommandQueue* queue, uint64_t submission, VkPipelineStageFlags stage);
+
 		SemaphoreInfo& Signal(VkSemaphore signal_semaphore) 
 		{
 			signal_semaphores.push_back(signal_semaphore);
+			signal_values.push_back(0);
 			return *this;
 		}
 
 		static SemaphoreInfo None();
 	};
 
+	//groups of command buffers submitted together,each group waits and signals its own semaphores.
+	//groups of a queue are submitted by one vkQueueSubmit,which saves the driver overhead of a submission for every group.
+	//groups can be added for secondary queues,they are submitted to their queues before the groups of the batch's queue
+	class SubmitBatch
+	{
+		friend class CommandQueue;
+	public:
+		/// <summary>
+		/// Add a group executed by the queue the batch is submitted to
+		/// </summary>
+		/// <param name="cmd_buffers">Array of command buffers of the group</param>
+		/// <param name="cmd_buffer_count">Count of the command buffers</param>
+		/// <param name="info">Semaphores the group need to wait and signal</param>
+		SubmitBatch&  Add(const VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count, const SemaphoreInfo& info = SemaphoreInfo::None());
+
+		/// <summary>
+		/// Add a group executed by a secondary queue
+		/// </summary>
+		/// <param name="queue">queue executing the group,the queue the batch is submitted to if null</param>
+		SubmitBatch&  Add(CommandQueue* queue, const VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count, const SemaphoreInfo& info = SemaphoreInfo::None());
+
+		/// <summary>
+		/// Get the id of the submission to a queue by the last CommandQueue::Submit of the batch,
+		/// including the submissions made before a failed submission of the batch
+		/// </summary>
+		/// <returns>id of the submission,nullopt if no group of the batch is submitted to the queue</returns>
+		opt<uint64_t> GetSubmission(const CommandQueue* queue) const;
+
+		uint32		  GroupCount() const;
+		void		  Clear();
+
+	private:
+		struct Group
+		{
+			CommandQueue*				 queue;
+			std::vector<VkCommandBuffer> cmd_buffers;
+			SemaphoreInfo				 semaphores;
+		};
+		std::vector<Group>									  m_Groups;
+		std::vector<std::pair<const CommandQueue*, uint64_t>> m_Submissions;
+	};
+
+	//every submission of a command queue signals the timeline semaphore of the queue with a new value.
+	//the value is the id of the submission,so completion is checked by comparing the counter of the semaphore
 	class CommandQueue 
 	{
 		friend class Context;
+		friend class SemaphoreInfo;
 	public:
 		/// <summary>
 		/// Get the queue family index of this command queue
@@ -81,11 +151,25 @@ namespace gvk {
 		/// <param name="cmd_buffer_count">Count of the command buffers to submit</param>
 		/// <param name="info">Semaphores this queue need to wait and signal</param>
 		/// <param name="stall_for_device">If this flag is set to true,the host wait for this queue until the excution finishes</param>
-		/// <returns>VkResult of the submission</returns>
-		VkResult Submit(VkCommandBuffer* cmd_buffers,uint32 cmd_buffer_count,
+		/// <param name="result">VkResult of the submission</param>
+		/// <returns>id of the submission,greater than ids of earlier submissions to the queue.nullopt if the submission fails</returns>
+		opt<uint64_t> Submit(VkCommandBuffer* cmd_buffers,uint32 cmd_buffer_count,
 			const SemaphoreInfo& info, VkFence target_fence,
-			bool stall_for_device = false);
+			bool stall_for_device = false, VkResult* result = nullptr);
+
 
+		/// <summary>
+		/// Submit every group of a batch.Groups of secondary queues are submitted first,one vkQueueSubmit for each queue,
+		/// then groups of this queue are submitted by one vkQueueSubmit with target_fence.
+		/// The fence and the returned submission finish after every group of the batch.
+		/// The batch is validated before the first vkQueueSubmit.If a later vkQueueSubmit fails,
+		/// the queues submitted before keep executing their groups,their ids are still available by SubmitBatch::GetSubmission
+		/// </summary>
+		/// <param name="batch">groups to submit,ids of the submissions to secondary queues are stored in it</param>
+		/// <param name="target_fence">fence signaled when the batch finishes</param>
+		/// <param name="result">VkResult of the submission,VK_ERROR_UNKNOWN if the batch has no group</param>
+		/// <returns>id of the submission to this queue,nullopt if a submission fails or the batch has no group</returns>
+		opt<uint64_t> Submit(SubmitBatch& batch, VkFence target_fence = NULL, VkResult* result = nullptr);
 		
 		/// <summary>
 		/// Create a command buffer, record command to it and submit it immediately
@@ -98,16 +182,89 @@ namespace gvk {
 		VkResult SubmitTemporalCommand(std::function<void(VkCommandBuffer)> command,
 			const SemaphoreInfo& info, VkFence target_fence,bool stall_for_host);
 
+		/// <summary>
+		/// Record a temporal command buffer and submit it without waiting for the device.
+		/// Command buffers of finished temporal commands are recycled by later calls.
+		/// The command buffer comes from Context::GetThreadCommandPool and is recorded without lock,
+		/// so threads record at the same time and the command may submit to this queue again
+		/// </summary>
+		/// <param name="command">a function record command to command buffer</param>
+		/// <param name="info">the semaphores to wait and signal</param>
+		/// <param name="result">VkResult of the operation</param>
+		/// <returns>id of the submission,checked by IsComplete or waited by Wait.nullopt if the operation fails</returns>
+		opt<uint64_t> SubmitTemporalCommandAsync(std::function<void(VkCommandBuffer)> command,
+			const SemaphoreInfo& info, VkResult* result = nullptr);
+
+		/// <summary>
+		/// Check if a submission has finished on the device without blocking
+		/// </summary>
+		/// <param name="submission">id returned by Submit</param>
+		bool	 IsComplete(uint64_t submission);
+
+		/// <summary>
+		/// Wait for a submission to finish on the device
+		/// </summary>
+		/// <param name="submission">id returned by Submit</param>
+		/// <param name="timeout">timeout in nanoseconds.If timeout is less than 0,host will wait for this forever</param>
+		/// <returns>VK_SUCCESS if the submission has finished,VK_TIMEOUT if timeout expires</returns>
+		VkResult Wait(uint64_t submission, int64_t timeout = -1);
+
+		/// <summary>
+		/// Wait for every submission to the queue to finish
+		/// </summary>
+		VkResult WaitIdle(int64_t timeout = -1);
+
+		/// <summary>
+		/// Get the id of the last submission to the queue,0 if nothing is submitted
+		/// </summary>
+		uint64_t LastSubmission();
+
+		/// <summary>
+		/// Get the id of the last finished submission.Submissions to a queue finish in order
+		/// </summary>
+		uint64_t CompletedSubmission();
+
+		VkSemaphore GetTimelineSemaphore() const { return m_TimelineSemaphore; }
+
 		void	SetDebugName(const std::string& name);
 		
 		~CommandQueue();
 	private:
-		CommandQueue(VkQueue queue,uint32 queue_family,uint32 queue_index,float priority,VkFence fence,VkDevice device);
-
-		//command pool for command buffers only called once
-		VkCommandPool m_TemporalBufferPool;
+		CommandQueue(VkQueue queue,uint32 queue_family,uint32 queue_index,float priority,VkSemaphore timeline,VkDevice device);
 
-		VkFence m_Fence;
+		struct SubmitGroup
+		{
+			const VkCommandBuffer* cmd_buffers;
+			uint32				   cmd_buffer_count;
+			const SemaphoreInfo*   semaphores;
+		};
+		//submit groups by one vkQueueSubmit,the last batch waits for tail_waits and signals the timeline semaphore
+		opt<uint64_t> SubmitGroups(const SubmitGroup* groups, uint32 group_count,
+			const std::vector<std::pair<VkSemaphore, uint64_t>>& tail_waits, VkFence target_fence, VkResult* result);
+
+		opt<uint64_t> SubmitTemporal(const std::function<void(VkCommandBuffer)>& command,
+			const SemaphoreInfo& info, VkFence target_fence, bool stall_for_host, VkResult* result);
+
+		//command buffer only submitted once,allocated from the pool of the recording thread
+		struct TemporalBuffer
+		{
+			ptr<CommandPool> pool;
+			VkCommandBuffer  cmd_buffer;
+		};
+		//guards the lists,commands are recorded without it
+		std::mutex	  m_TemporalBufferLock;
+		//temporal command buffers and the submissions they are executed by
+		std::vector<std::pair<uint64_t, TemporalBuffer>> m_PendingTemporalBuffers;
+		std::vector<TemporalBuffer> m_FreeTemporalBuffers;
+
+		//signaled with the id of every submission
+		VkSemaphore			  m_TimelineSemaphore;
+		//vkQueueSubmit requires the queue to be externally synchronized,
+		//ids are also increased in the order of submissions
+		std::mutex			  m_SubmitLock;
+		std::atomic<uint64_t> m_LastSubmission{ 0 };
+		//cached counter of the timeline semaphore,it only increases
+		std::atomic<uint64_t> m_CompletedSubmission{ 0 };
 		VkDevice m_Device;
 
 		VkQueue m_CommandQueue;
@@ -117,6 +274,57 @@ namespace gvk {
 
 		Context* m_Context;
 	};	
+
+	//records the subpasses of a render pass begun by RenderPass::BeginSecondary from several threads.
+	//every worker owns a command pool for each frame in flight,so pools are never shared by threads
+	//and they are reset wholesale when the frame index comes round again
+	class SecondaryCommandRecorder
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Begin a frame.The command pools of the frame index are reset,
+		/// so the gpu work of the last frame using the index must have finished
+		/// </summary>
+		/// <param name="frame_index">index of the frame in flight</param>
+		VkResult BeginFrame(uint32_t frame_index);
+
+		/// <summary>
+		/// Record items into secondary command buffers by worker threads and execute them in the current subpass.
+		/// Items are split into contiguous ranges,each range is recorded by one worker into one command buffer
+		/// and the command buffers are executed in the order of the ranges,so the order of items is kept.
+		/// Viewport and scissor of the render pass are set before the items are recorded.
+		/// The calling thread runs queued tasks of the thread pool while it waits for the workers
+		/// </summary>
+		/// <param name="content">render pass the items are drawn in</param>
+		/// <param name="item_count">count of items to record</param>
+		/// <param name="record">records an item into the command buffer,called from several threads</param>
+		/// <returns>VkResult of the recording</returns>
+		VkResult Record(RenderPassSecondaryContent& content, uint32_t item_count,
+			const std::function<void(VkCommandBuffer, uint32_t)>& record);
+
+		uint32_t GetWorkerCount();
+
+	private:
+		struct WorkerPool
+		{
+			ptr<CommandPool>			 pool;
+			//command buffers allocated from the pool,the first used ones are recorded in the frame
+			std::vector<VkCommandBuffer> cmd_buffers;
+			uint32_t					 used = 0;
+		};
+
+		SecondaryCommandRecorder(ptr<ThreadPool> thread_pool, std::vector<WorkerPool>&& pools, uint32_t worker_count);
+
+		VkResult RecordRange(WorkerPool& pool, const RenderPassSecondaryContent& content, uint32_t begin, uint32_t end,
+			const std::function<void(VkCommandBuffer, uint32_t)>& record, VkCommandBuffer* cmd_buffer);
+
+		ptr<ThreadPool>			m_ThreadPool;
+		//pools of frame i are m_Pools[i * worker_count,(i + 1) * worker_count)
+		std::vector<WorkerPool>	m_Pools;
+		uint32_t				m_WorkerCount;
+		uint32_t				m_FrameIndex = 0;
+	};
 }
 
 void GvkBindPipeline(VkCommandBuffer cmd, gvk::ptr<gvk::Pipeline> pipeline);
@@ -142,6 +350,126 @@ private:
 	VkCommandBuffer cmd;
 };
 
+//records commands into a command buffer and skips calls that wouldn't change the bound state.
+//descriptor sets,vertex buffers and push constants are recorded lazily and flushed before every draw/dispatch,
+//so consecutive sets/vertex bindings are bound by one call and push constants are pushed as one range.
+//only commands recorded through the recorder are tracked,call Invalidate after recording
+//state changing commands into the command buffer directly
+struct GvkCommandRecorder
+{
+	static constexpr uint32_t max_set_count = 16;
+	static constexpr uint32_t max_vertex_binding_count = 16;
+	static constexpr uint32_t max_dynamic_offset_count = 8;
+	static constexpr uint32_t max_push_constant_size = 256;
+
+	//counts of recorded and elided commands
+	struct Statistics
+	{
+		uint32_t pipeline_binds = 0;
+		uint32_t elided_pipeline_binds = 0;
+		uint32_t descriptor_set_binds = 0;
+		//sets requested but already bound
+		uint32_t elided_descriptor_sets = 0;
+		uint32_t vertex_buffer_binds = 0;
+		uint32_t elided_vertex_buffers = 0;
+		uint32_t index_buffer_binds = 0;
+		uint32_t elided_index_buffer_binds = 0;
+		uint32_t push_constant_updates = 0;
+		//bytes pushed with the values they already have
+		uint32_t elided_push_constant_bytes = 0;
+	};
+
+	GvkCommandRecorder(VkCommandBuffer cmd);
+
+	void BindPipeline(const gvk::ptr<gvk::Pipeline>& pipeline);
+
+	//the set is bound to the slot of its layout's set index with the layout of the last bound pipeline
+	void BindDescriptorSet(const gvk::ptr<gvk::DescriptorSet>& set, gvk::View<uint32_t> dynamic_offsets = gvk::View<uint32_t>());
+	void BindDescriptorSet(VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t set_index, VkDescriptorSet set,
+		gvk::View<uint32_t> dynamic_offsets = gvk::View<uint32_t>());
+
+	void BindVertexBuffer(uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0);
+	void BindVertexBuffer(uint32_t binding, const gvk::ptr<gvk::Buffer>& buffer, VkDeviceSize offset = 0);
+	void BindIndexBuffer(VkBuffer buffer, VkIndexType type, VkDeviceSize offset = 0);
+	void BindIndexBuffer(const gvk::ptr<gvk::Buffer>& buffer, VkIndexType type, VkDeviceSize offset = 0);
+
+	//pushed with the layout of the pipeline bound when the push constants are flushed,
+	//pushes of the same stages are merged into one range
+	void PushConstants(VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+	void PushConstants(const GvkPushConstant& push_constant, const void* data);
+
+	void Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+	void DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+	void DrawIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
+	void DrawIndexedIndirect(VkBuffer buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
+	void DrawMeshTasks(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+	void Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+	void DispatchIndirect(VkBuffer buffer, VkDeviceSize offset);
+
+	//record pending binds and push constants of a bind point,
+	//called by draws/dispatches and before recording commands directly into the command buffer
+	void Flush(VkPipelineBindPoint bind_point);
+
+	//forget the tracked state,the next binds are always recorded
+	void Invalidate();
+
+	VkCommandBuffer GetCommandBuffer();
+	const Statistics& GetStatistics();
+
+private:
+	struct SetState
+	{
+		VkDescriptorSet		set = NULL;
+		VkPipelineLayout	layout = NULL;
+		uint32_t			offset_count = 0;
+		std::array<uint32_t, max_dynamic_offset_count> offsets;
+
+		bool operator==(const SetState& other) const;
+	};
+
+	struct BindPointState
+	{
+		VkPipeline			pipeline = NULL;
+		VkPipelineLayout	layout = NULL;
+		std::array<SetState, max_set_count> bound;
+		std::array<SetState, max_set_count> pending;
+		uint32_t			pending_sets = 0;
+	};
+
+	BindPointState& GetBindPointState(VkPipelineBindPoint bind_point);
+	void			FlushDescriptorSets(VkPipelineBindPoint bind_point, BindPointState& state);
+	void			FlushVertexBuffers();
+	void			FlushPushConstants(VkPipelineLayout layout);
+
+	VkCommandBuffer cmd;
+
+	//graphics,compute and ray tracing
+	std::array<BindPointState, 3> bind_points;
+	VkPipelineBindPoint			  last_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+	std::array<VkBuffer, max_vertex_binding_count>		bound_vertex_buffers{};
+	std::array<VkDeviceSize, max_vertex_binding_count>	bound_vertex_offsets{};
+	std::array<VkBuffer, max_vertex_binding_count>		pending_vertex_buffers{};
+	std::array<VkDeviceSize, max_vertex_binding_count>	pending_vertex_offsets{};
+	uint32_t											pending_vertex_bindings = 0;
+
+	VkBuffer		index_buffer = NULL;
+	VkDeviceSize	index_offset = 0;
+	VkIndexType		index_type = VK_INDEX_TYPE_MAX_ENUM;
+
+	//latest values of push constants.known bytes are in the command buffer already,
+	//dirty bytes are pushed with push_constant_stages at the next flush
+	std::array<uint8_t, max_push_constant_size>				push_constants;
+	std::array<VkShaderStageFlags, max_push_constant_size>	push_constant_byte_stages;
+	std::bitset<max_push_constant_size>						push_constant_known;
+	std::bitset<max_push_constant_size>						push_constant_dirty;
+	VkShaderStageFlags										push_constant_stages = 0;
+	//layout the known bytes are pushed with
+	VkPipelineLayout										push_constant_layout = NULL;
+
+	Statistics stats;
+};
+
 struct GvkDebugMarker
 {
 	GvkDebugMarker(VkCommandBuffer cmd,const char* name);
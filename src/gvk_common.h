@@ -10,6 +10,7 @@
 #include <string>
 #include <array>
 #include <sstream>
+#include <atomic>
 
 
 
@@ -36,47 +37,59 @@ namespace gvk {
 	template<typename T>
 	class View {
 	public:
-		View():data(nullptr),start(0),end(0) {}
+		View():m_Data(nullptr),m_Start(0),m_End(0) {}
 		View(const T* data, uint32 start, uint32 end) :
-			data(data), start(start), end(end) {
+			m_Data(data), m_Start(start), m_End(end) {
 			gvk_assert(end >= start);
 		}
-		View(const std::vector<T>& arr) :data(arr.data()), start(0), end(arr.size()) {}
+		View(const std::vector<T>& arr) :m_Data(arr.data()), m_Start(0), m_End(arr.size()) {}
 		View(const View<T>& v) {
-			data = v.data; start = v.start; end = v.end;
+			m_Data = v.m_Data; m_Start = v.m_Start; m_End = v.m_End;
 		}
 
 		const View& operator=(const View<T>& v) {
-			data = v.data;
-			start = v.start;
-			end = v.end;
+			m_Data = v.m_Data;
+			m_Start = v.m_Start;
+			m_End = v.m_End;
 			return *this;
 		}
 
 		T& operator=(uint32 idx) {
-			gvk_assert(data != nullptr);
-			gvk_assert(start + idx < end);
-			return data[idx + start];
+			gvk_assert(m_Data != nullptr);
+			gvk_assert(m_Start + idx < m_End);
+			return m_Data[idx + m_Start];
 		}
 
 		const T& operator[](uint32 idx) const {
-			gvk_assert(data != nullptr);
-			gvk_assert(start + idx < end);
-			return data[idx + start];
+			gvk_assert(m_Data != nullptr);
+			gvk_assert(m_Start + idx < m_End);
+			return m_Data[idx + m_Start];
 		}
 
 		uint32 size() const {
-			return end - start;
+			return m_End - m_Start;
+		}
+
+		bool empty() const {
+			return m_End == m_Start;
+		}
+
+		const T* begin() const {
+			return m_Data + m_Start;
+		}
+
+		const T* end() const {
+			return m_Data + m_End;
 		}
 
 		const T* GetData()
 		{
-			return data;
+			return m_Data;
 		}
 
 	private:
-		const T* data;
-		uint32 start, end;
+		const T* m_Data;
+		uint32 m_Start, m_End;
 	};
 }
 
@@ -404,5 +417,18 @@ namespace gvk {
 	{
 		return ((target + alignment - 1) / alignment) * alignment;
 	}
+
+	//64 bit FNV-1a hash,pass the result of the last call as seed to hash discontinuous data
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
 }
 
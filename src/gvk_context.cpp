@@ -284,11 +284,22 @@ namespace gvk {
 		return true;
 	}
 
+	static std::atomic<uint64_t> g_context_count{ 0 };
+
+	std::weak_ptr<void> Context::GetThreadToken()
+	{
+		thread_local ptr<int> token = std::make_shared<int>(0);
+		return token;
+	}
+
 	Context::Context() {
+		m_ContextId = g_context_count++;
 		m_VkInstance = NULL;
 		m_Device = NULL;
 		m_PhyDevice = NULL;
 		memset(&m_AppInfo, 0, sizeof(m_AppInfo));
+		m_ReleaseQueue = ptr<ReleaseQueue>(new ReleaseQueue());
+		m_Jobs = std::make_shared<JobCounter>();
 	}
 
 	opt<VkSemaphore> Context::CreateVkSemaphore()
@@ -305,6 +316,24 @@ namespace gvk {
 		return semaphore;
 	}
 
+	opt<VkSemaphore> Context::CreateTimelineSemaphore(uint64_t initial_value)
+	{
+		VkSemaphoreTypeCreateInfo type_info{};
+		type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		type_info.initialValue = initial_value;
+
+		VkSemaphoreCreateInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		info.pNext = &type_info;
+		VkSemaphore semaphore;
+		if (vkCreateSemaphore(m_Device, &info, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			return std::nullopt;
+		}
+		return semaphore;
+	}
+
 	void Context::DestroyVkSemaphore(VkSemaphore semaphore)
 	{
 		gvk_assert(semaphore != NULL);
@@ -346,6 +375,8 @@ namespace gvk {
 	void Context::WaitForDeviceIdle()
 	{
 		vkDeviceWaitIdle(m_Device);
+		//nothing is in flight
+		m_ReleaseQueue->Flush();
 	}
 
 	void Context::DestroyFrameBuffer(VkFramebuffer frame_buffer)
@@ -424,7 +455,80 @@ namespace gvk {
 		return m_DummyDescriptorSetLayout;
 	}
 
+	ptr<ThreadPool> Context::GetThreadPool()
+	{
+		std::call_once(m_ThreadPoolCreated, [this]() { m_ThreadPool = std::make_shared<ThreadPool>(); });
+		return m_ThreadPool;
+	}
+
+	bool Context::AttachThreadPool(ptr<ThreadPool> pool)
+	{
+		gvk_assert(pool != nullptr);
+		bool attached = false;
+		std::call_once(m_ThreadPoolCreated, [&]() { m_ThreadPool = pool; attached = true; });
+		return attached;
+	}
+
+	bool Context::EnableShaderHotReload(std::string* error)
+	{
+		if (m_HotReloader != nullptr)
+		{
+			return true;
+		}
+		ptr<ShaderHotReloader> reloader(new ShaderHotReloader(this));
+		if (!reloader->Start(error))
+		{
+			return false;
+		}
+		m_HotReloader = reloader;
+		return true;
+	}
+
+	std::vector<std::string> Context::PollShaderReloadErrors()
+	{
+		if (m_HotReloader == nullptr)
+		{
+			return {};
+		}
+		return m_HotReloader->PollErrors();
+	}
+
+	std::vector<ptr<Pipeline>> Context::PollShaderReloadSwaps()
+	{
+		if (m_HotReloader == nullptr)
+		{
+			return {};
+		}
+		return m_HotReloader->PollSwaps();
+	}
+
 	Context::~Context() {
+		//stop watching before the reloads in flight are finished
+		if (m_HotReloader != nullptr)
+		{
+			m_HotReloader->Stop();
+		}
+		//finish the tasks may still use the context,
+		//dropping the pool only joins it if the context owns it
+		if (m_ThreadPool != nullptr)
+		{
+			m_ThreadPool->Wait(*m_Jobs);
+		}
+		m_ThreadPool = nullptr;
+		m_HotReloader = nullptr;
+		m_BindlessHeap = nullptr;
+		//waits for the frames in flight
+		m_FrameRing = nullptr;
+		//objects dropped later are destroyed immediately
+		if (m_Device != NULL)
+		{
+			vkDeviceWaitIdle(m_Device);
+		}
+		//command buffers of the thread pools have finished
+		m_ThreadDescriptorAllocators.clear();
+		m_ThreadCommandPools.clear();
+		m_ReleaseQueue->Close();
+
 		m_Window = nullptr;
 		m_PresentQueue = nullptr;
 
@@ -452,6 +556,14 @@ namespace gvk {
 		{
 			vkDestroyDescriptorSetLayout(m_Device , m_DummyDescriptorSetLayout, NULL);
 		}
+		if (m_PipelineCache != NULL)
+		{
+			if (!m_PipelineCacheFile.empty())
+			{
+				SavePipelineCache(NULL, NULL);
+			}
+			vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+		}
 
 		if (m_Device != NULL) {
 			vkDestroyDevice(m_Device, nullptr);
@@ -631,16 +743,39 @@ namespace gvk {
 		device_create.ppEnabledExtensionNames = create.required_extensions.data();
 		device_create.pEnabledFeatures = &create.required_features;
 
-		VkPhysicalDeviceFeatures2 features2{};
-		if (create.p_ext_features != nullptr)
+		//submissions of command queues are tracked by timeline semaphores,core since vulkan 1.2
+		if (m_AppInfo.apiVersion < VK_API_VERSION_1_2 || m_DevicePropertiesFeature.DeviceProperties().apiVersion < VK_API_VERSION_1_2)
 		{
-			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-			features2.pNext = create.p_ext_features;
-			features2.features = create.required_features;
-			device_create.pNext = &features2;
-
-			device_create.pEnabledFeatures = nullptr;
+			if (error != nullptr) *error = "gvk : vulkan 1.2 is required for timeline semaphores";
+			return false;
+		}
+		//a chain must not contain both VkPhysicalDeviceVulkan12Features and VkPhysicalDeviceTimelineSemaphoreFeatures,
+		//enable the feature in the caller's struct if there is one
+		bool timeline_enabled = false;
+		for (auto iter = (VkBaseOutStructure*)create.p_ext_features; iter != nullptr; iter = iter->pNext)
+		{
+			if (iter->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES)
+			{
+				((VkPhysicalDeviceVulkan12Features*)iter)->timelineSemaphore = VK_TRUE;
+				timeline_enabled = true;
+			}
+			else if (iter->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES)
+			{
+				((VkPhysicalDeviceTimelineSemaphoreFeatures*)iter)->timelineSemaphore = VK_TRUE;
+				timeline_enabled = true;
+			}
 		}
+		VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+		timeline_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		timeline_features.pNext = create.p_ext_features;
+		timeline_features.timelineSemaphore = VK_TRUE;
+
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = timeline_enabled ? create.p_ext_features : &timeline_features;
+		features2.features = create.required_features;
+		device_create.pNext = &features2;
+		device_create.pEnabledFeatures = nullptr;
 		//device_create.pNext = create.p_ext_features;
 
 		if (vkCreateDevice(m_PhyDevice, &device_create, nullptr, &m_Device) != VK_SUCCESS) {
@@ -701,14 +836,32 @@ namespace gvk {
 		volkLoadDevice(m_Device);
 
 
+		m_DescriptorBufferEnabled = DeviceExtensionEnabled(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+		if (m_DescriptorBufferEnabled)
+		{
+			m_DescriptorBufferProperties = {};
+			m_DescriptorBufferProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT;
+			VkPhysicalDeviceProperties2 properties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+			properties.pNext = &m_DescriptorBufferProperties;
+			vkGetPhysicalDeviceProperties2(m_PhyDevice, &properties);
+		}
+
 		VkDescriptorSetLayoutCreateInfo descSetLayoutCI{};
 		descSetLayoutCI.bindingCount = 0;
-		descSetLayoutCI.flags = 0;
+		//pipelines using descriptor buffers require every set layout to be a descriptor buffer layout
+		descSetLayoutCI.flags = m_DescriptorBufferEnabled ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
 		descSetLayoutCI.pBindings = NULL;
 		descSetLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 
 		vkCreateDescriptorSetLayout(m_Device, &descSetLayoutCI, NULL, &m_DummyDescriptorSetLayout);
 
+		m_PipelineCreationFeedback = m_AppInfo.apiVersion >= VK_API_VERSION_1_3 &&
+			m_DevicePropertiesFeature.DeviceProperties().apiVersion >= VK_API_VERSION_1_3;
+		if (!InitializePipelineCache(create.pipeline_cache_file, error))
+		{
+			return false;
+		}
+
 		return IntializeMemoryAllocation(addressable, m_AppInfo.apiVersion, error);
 	}
 
@@ -762,9 +915,131 @@ namespace gvk {
 		{
 			return std::nullopt;
 		}
+		if (m_HotReloader != nullptr)
+		{
+			m_HotReloader->WatchShader(shader, file, macros, include_directories, include_directory_count,
+				search_pathes, search_path_count);
+		}
 		return shader;
 	}
 
+	std::vector<opt<ptr<Shader>>> Context::CompileShaders(View<ShaderCompileInfo> infos, const char** include_directories, uint32 include_directory_count, const char** search_pathes, uint32 search_path_count, std::string* error)
+	{
+		struct CompileResult
+		{
+			opt<ptr<Shader>> shader;
+			std::string		 error;
+		};
+
+		//the caller's arrays stay alive until all tasks are waited
+		std::vector<std::future<CompileResult>> tasks;
+		for (uint32 i = 0; i < infos.size(); i++)
+		{
+			const ShaderCompileInfo* info = &infos[i];
+			tasks.push_back(GetThreadPool()->Submit([=]()
+				{
+					CompileResult result;
+					result.shader = CompileShader(info->file, info->macros, include_directories, include_directory_count,
+						search_pathes, search_path_count, &result.error);
+					return result;
+				}));
+		}
+
+		std::vector<opt<ptr<Shader>>> shaders;
+		std::string messages;
+		for (auto& task : tasks)
+		{
+			GetThreadPool()->Wait(task);
+			CompileResult result = task.get();
+			if (!result.shader.has_value() && !result.error.empty())
+			{
+				messages += result.error + "\n";
+			}
+			shaders.push_back(std::move(result.shader));
+		}
+		if (error) *error = messages;
+		return shaders;
+	}
+
+	opt<ptr<ShaderVariantArchive>> Context::CompileShaderVariants(const char* file, const ShaderPermutation& permutation, const ShaderMacros& macros, const char** include_directories, uint32 include_directory_count, const char** search_pathes, uint32 search_path_count, std::string* error)
+	{
+		struct CompileResult
+		{
+			opt<ptr<Shader>> shader;
+			std::string		 error;
+		};
+
+		ptr<ShaderVariantArchive> archive(new ShaderVariantArchive(permutation));
+
+		std::vector<uint32> masks;
+		std::vector<std::future<CompileResult>> tasks;
+		for (uint32 mask = 0; mask < archive->GetVariantCount(); mask++)
+		{
+			ShaderMacros variant_macros = macros;
+			if (!permutation.GetMacros(mask, variant_macros))
+			{
+				continue;
+			}
+			masks.push_back(mask);
+			tasks.push_back(GetThreadPool()->Submit([=]()
+				{
+					CompileResult result;
+					result.shader = Shader::Compile(file, variant_macros, include_directories, include_directory_count,
+						search_pathes, search_path_count, &result.error);
+					return result;
+				}));
+		}
+
+		std::string messages;
+		//unique shaders with the same SPIR-V hash
+		std::unordered_map<uint64_t, std::vector<uint32>> unique_shaders;
+		for (uint32 i = 0; i < tasks.size(); i++)
+		{
+			GetThreadPool()->Wait(tasks[i]);
+			CompileResult result = tasks[i].get();
+			if (!result.shader.has_value())
+			{
+				messages += result.error + "\n";
+				archive->m_FailedVariants.push_back({ masks[i], std::move(result.error) });
+				continue;
+			}
+
+			ptr<Shader> shader = result.shader.value();
+			uint64_t hash = HashBytes(shader->GetByteCode(), shader->GetByteCodeSize());
+			auto& candidates = unique_shaders[hash];
+			auto same = std::find_if(candidates.begin(), candidates.end(), [&](uint32 index)
+				{
+					ptr<Shader>& other = archive->m_Shaders[index];
+					return other->GetByteCodeSize() == shader->GetByteCodeSize() &&
+						memcmp(other->GetByteCode(), shader->GetByteCode(), shader->GetByteCodeSize()) == 0;
+				});
+			if (same != candidates.end())
+			{
+				archive->m_VariantShaderIndex[masks[i]] = *same;
+				continue;
+			}
+
+			if (!shader->CreateShaderModule(m_Device).has_value())
+			{
+				std::string module_error = "gvk : fail to create shader module for " + shader->Name();
+				messages += module_error + "\n";
+				archive->m_FailedVariants.push_back({ masks[i], std::move(module_error) });
+				continue;
+			}
+			candidates.push_back(archive->m_Shaders.size());
+			archive->m_VariantShaderIndex[masks[i]] = archive->m_Shaders.size();
+			archive->m_Shaders.push_back(shader);
+		}
+
+		//the successful variants are kept,the failed ones are reported through the error and the archive
+		if (error) *error = messages;
+		if (archive->m_Shaders.empty() && !tasks.empty())
+		{
+			return std::nullopt;
+		}
+		return archive;
+	}
+
 	opt<ptr<gvk::Shader>> Context::LoadShader(const char* file, const char** search_pathes, uint32 search_path_count, std::string* error)
 	{
 		ptr<Shader> shader;
@@ -1036,6 +1311,12 @@ namespace gvk {
 		gvk_assert(m_SwapChain != NULL);
 		uint32 timeout = _timeout < 0 ? UINT64_MAX : _timeout;
 		uint32 image_index;
+		//the acquire semaphore of the frame index may still be waited by the last frame using it
+		if (m_FrameRing != nullptr)
+		{
+			m_FrameRing->BeginFrame(m_CurrentFrameIndex);
+		}
+		m_ReleaseQueue->Collect();
 		VkResult vkres = vkAcquireNextImageKHR(m_Device, m_SwapChain, timeout, m_ImageAcquireSemaphore[m_CurrentFrameIndex],
 			fence, &image_index);
 		if (res != NULL) *res = vkres;
@@ -1088,13 +1369,26 @@ namespace gvk {
 		present_info.pSwapchains = &m_SwapChain;
 		present_info.swapchainCount = 1;
 		present_info.pImageIndices = &m_CurrentBackBufferImageIndex;
+		//presentation can only wait for binary semaphores
+		gvk_assert(std::all_of(semaphore.wait_values.begin(), semaphore.wait_values.end(), [](uint64_t v) { return v == 0; }));
 		present_info.pWaitSemaphores = semaphore.wait_semaphores.data();
 		present_info.waitSemaphoreCount = semaphore.wait_semaphores.size();
 		present_info.pResults = &vkrs;
+
+		VkResult end_rs = VK_SUCCESS;
+		if (m_FrameRing != nullptr)
+		{
+			end_rs = m_FrameRing->EndFrame(m_PresentQueue.get(), m_ReleaseQueue->GetUnfinishedSubmissions());
+		}
 		
 		VkResult present_rs = vkQueuePresentKHR(m_PresentQueue->m_CommandQueue, &present_info);
 
 		m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % m_BackBufferCount;
+		if (m_HotReloader != nullptr)
+		{
+			m_HotReloader->ApplyPendingSwaps();
+		}
+		if (end_rs != VK_SUCCESS) return end_rs;
 		if (vkrs != VK_SUCCESS) return vkrs;
 		return present_rs;
 	}
@@ -1164,6 +1458,17 @@ GvkDeviceCreateInfo& GvkDeviceCreateInfo::AddDeviceExtension(GVK_DEVICE_EXTENSIO
 	case GVK_DEVICE_EXTENSION_DEBUG_MARKER:
 		AddNotRepeatedElement(required_extensions, VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
 		break;
+	case GVK_DEVICE_EXTENSION_PUSH_DESCRIPTOR:
+		AddNotRepeatedElement(required_extensions, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		break;
+	case GVK_DEVICE_EXTENSION_DESCRIPTOR_BUFFER:
+		AddDeviceExtension(GVK_DEVICE_EXTENSION_BUFFER_DEVICE_ADDRESS);
+
+		AddNotRepeatedElement(required_extensions, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+		EnableFeature(this, descriptorBuffer);
+		descriptorBuffer.feature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+		descriptorBuffer.feature.descriptorBuffer = VK_TRUE;
+		break;
 	case GVK_DEVICE_EXTENSION_RAYTRACING:
 		AddDeviceExtension(GVK_DEVICE_EXTENSION_BUFFER_DEVICE_ADDRESS);
 
@@ -1281,6 +1586,9 @@ GvkDeviceCreateInfo& GvkDeviceCreateInfo::AddDeviceExtension(GVK_DEVICE_EXTENSIO
 		descriptorIndexingFeatures.feature.descriptorBindingStorageBufferUpdateAfterBind = true;
 		descriptorIndexingFeatures.feature.descriptorBindingStorageImageUpdateAfterBind = true;
 		descriptorIndexingFeatures.feature.descriptorBindingVariableDescriptorCount = true;
+		//resources in bindless arrays are indexed by nonuniformEXT
+		descriptorIndexingFeatures.feature.shaderSampledImageArrayNonUniformIndexing = true;
+		descriptorIndexingFeatures.feature.shaderStorageBufferArrayNonUniformIndexing = true;
 
 		descriptorIndexingFeatures.feature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
 		break;
@@ -6,6 +6,13 @@
 #include "gvk_pipeline.h"
 #include "gvk_shader.h"
 #include "gvk_raytracing.h"
+#include "gvk_job.h"
+#include "gvk_hot_reload.h"
+#include "gvk_bindless.h"
+#include "gvk_descriptor_buffer.h"
+#include "gvk_uniform_ring.h"
+#include "gvk_frame.h"
+#include "gvk_release.h"
 
 struct GVK_VERSION {
 	uint32_t v0, v1, v2;
@@ -41,6 +48,11 @@ enum GVK_DEVICE_EXTENSION
 	GVK_DEVICE_EXTENSION_ATOMIC_FLOAT,
 	GVK_DEVICE_EXTENSION_INT64,
 	GVK_DEVICE_EXTENSION_BINDLESS_IMAGE,
+	//push descriptor sets recorded directly into command buffers
+	GVK_DEVICE_EXTENSION_PUSH_DESCRIPTOR,
+	//descriptors are written into buffers instead of descriptor sets,
+	//requires buffer device address
+	GVK_DEVICE_EXTENSION_DESCRIPTOR_BUFFER,
 	
 	GVK_DEVICE_EXTENSION_COUNT
 };
@@ -92,9 +104,14 @@ struct GvkDeviceCreateInfo
 	Feature<VkPhysicalDeviceShaderAtomicInt64Features> atomicInt64;
 	Feature<VkPhysicalDeviceBufferDeviceAddressFeaturesKHR> deviceAddr;
 	Feature<VkPhysicalDeviceDescriptorIndexingFeaturesEXT> descriptorIndexingFeatures;
+	Feature<VkPhysicalDeviceDescriptorBufferFeaturesEXT> descriptorBuffer;
 
 	GvkDeviceCreateInfo& AddDeviceExtension(GVK_DEVICE_EXTENSION extension);
 
+	//if not empty,the pipeline cache will be loaded from this file when the device is created
+	//and written back to it when the context is destroyed
+	std::string pipeline_cache_file;
+
 	GvkDeviceCreateInfo() :required_features{} {}
 };
 
@@ -109,6 +126,14 @@ struct GvkInstanceCreateInfo
 	PFN_vkDebugReportCallbackEXT custom_debug_callback = NULL;
 };
 
+struct GvkPipelineCacheStatistics
+{
+	//pipelines whose creation was satisfied by the pipeline cache
+	uint32_t hit_count;
+	//pipelines compiled from scratch by the driver
+	uint32_t miss_count;
+};
+
 struct GvkSamplerCreateInfo : public VkSamplerCreateInfo 
 {
 	GvkSamplerCreateInfo(VkFilter magFilter,VkFilter minFilter,VkSamplerMipmapMode mode);
@@ -122,8 +147,16 @@ namespace gvk
 		uint64_t object, size_t location, int32_t message_code,
 		const char* layer_prefix, const char* message, void* /*user_data*/);
 
+	//threading contract:
+	//initialization (Initialize*,CreateSwapChain) and the swap chain loop (AcquireNextImage,Present) run on one render thread.
+	//functions creating or destroying device objects (CreateBuffer,CreateImage,CreateSampler,pipelines,layouts,
+	//queues,semaphores,fences...) can be called from any thread at the same time,
+	//shared state is guarded by its own lock,VMA and the pipeline cache are internally synchronized.
+	//objects returned are not thread safe unless their documents say so,
+	//e.g. a DescriptorAllocator or a CommandPool is used by one thread at a time
 	class Context {
 		friend class CommandQueue;
+		friend class ShaderHotReloader;
 	public:
 		static opt<ptr<Context>> CreateContext(const char* app_name,GVK_VERSION app_version,
 			uint32_t api_version,ptr<Window> window, std::string* error);
@@ -170,7 +203,8 @@ namespace gvk
 
 
 		/// <summary>
-		/// Create a shader, the binary code will be saved on disk with name "{file}.spv"
+		/// Create a shader, the binary code will be saved on disk with name "{file}.spv",
+		/// or "{file}.{hash of the macros}.spv" if macros are given so variants don't overwrite each other
 		/// </summary>
 		/// <param name="file">the source file of the shader</param>
 		/// <param name="macros">macros used to compile the shaders</param>
@@ -186,6 +220,42 @@ namespace gvk
 			const char** search_pathes, uint32_t search_path_count,
 			std::string* error);
 
+		/// <summary>
+		/// Compile several shaders on worker threads of the context's thread pool and create their shader modules.
+		/// This function returns after all shaders are compiled
+		/// </summary>
+		/// <param name="infos">files and macros of the shaders</param>
+		/// <param name="include_directories">the include directories shared by the shaders</param>
+		/// <param name="include_directory_count">count of include directories</param>
+		/// <param name="search_pathes">search pathes shared by the shaders</param>
+		/// <param name="search_path_count">count of search pathes</param>
+		/// <param name="error">error messages of the failed shaders, one per line</param>
+		/// <returns>compiled shaders in the order of infos,nullopt for shaders failed to compile</returns>
+		std::vector<opt<ptr<Shader>>> CompileShaders(View<ShaderCompileInfo> infos,
+			const char** include_directories, uint32 include_directory_count,
+			const char** search_pathes, uint32_t search_path_count,
+			std::string* error);
+
+		/// <summary>
+		/// Compile every variant of a shader on worker threads of the context's thread pool.
+		/// Variants compiled to identical SPIR-V share one shader module.
+		/// A variant failing to compile doesn't fail the others,it is recorded by ShaderVariantArchive::GetFailedVariants
+		/// </summary>
+		/// <param name="file">the source file of the shader</param>
+		/// <param name="permutation">macro axes of the shader</param>
+		/// <param name="macros">macros shared by all variants</param>
+		/// <param name="include_directories">the include directories of the shader</param>
+		/// <param name="include_directory_count">count of include directories</param>
+		/// <param name="search_pathes">search pathes of the shader</param>
+		/// <param name="search_path_count">count of search pathes of the shader</param>
+		/// <param name="error">error messages of the failed variants, one per line</param>
+		/// <returns>the archive of the compiled variants,nullopt if no variant compiles</returns>
+		opt<ptr<ShaderVariantArchive>> CompileShaderVariants(const char* file,
+			const ShaderPermutation& permutation, const ShaderMacros& macros,
+			const char** include_directories, uint32 include_directory_count,
+			const char** search_pathes, uint32_t search_path_count,
+			std::string* error);
+
 		/// <summary>
 		/// Load compiled shader binary code from file and create a shader module
 		/// </summary>
@@ -217,7 +287,8 @@ namespace gvk
 
 		/// <summary>
 		/// Create a command queue from pre-required command queues.
-		/// Return nullopt if no matching queue is found in pre-required command queues
+		/// Return nullopt if no matching queue is found in pre-required command queues.
+		/// Thread safe
 		/// </summary>
 		/// <param name="flags">the flags of the command queue</param>
 		/// <param name="priority">the priority of the command queue</param>
@@ -232,6 +303,16 @@ namespace gvk
 		/// <param name="queue"></param>
 		/// <returns></returns>
 		opt<ptr<CommandPool>> CreateCommandPool(const CommandQueue* queue);
+
+		/// <summary>
+		/// Create a recorder recording render passes from the threads of the context's thread pool.
+		/// Command buffers recorded by it should be executed by the queue
+		/// </summary>
+		/// <param name="queue">queue executing the recorded command buffers</param>
+		/// <param name="worker_count">count of threads recording at the same time,0 means the thread pool's thread count plus the calling thread</param>
+		/// <param name="frame_count">count of frames in flight,0 means the count of back buffers</param>
+		/// <returns>created recorder</returns>
+		opt<ptr<SecondaryCommandRecorder>> CreateSecondaryCommandRecorder(const CommandQueue* queue, uint32_t worker_count = 0, uint32_t frame_count = 0);
 		
 		/// <summary>
 		/// Return the present queue of current context.Should be called after device is initialized successfully
@@ -241,11 +322,19 @@ namespace gvk
 		ptr<CommandQueue> PresentQueue() { gvk_assert(m_PresentQueue != NULL); return m_PresentQueue; }
 
 		/// <summary>
-		/// Create a semaphore for synchronization between queues
+		/// Create a semaphore for synchronization between queues.
+		/// Thread safe
 		/// </summary>
 		/// <returns>The created semaphore</returns>
 		opt<VkSemaphore>  CreateVkSemaphore();
 
+		/// <summary>
+		/// Create a timeline semaphore.Its counter only increases and can be waited by host and queues
+		/// </summary>
+		/// <param name="initial_value">initial value of the counter</param>
+		/// <returns>The created semaphore</returns>
+		opt<VkSemaphore>  CreateTimelineSemaphore(uint64_t initial_value = 0);
+
 
 		/// <summary>
 		/// Destroy the semaphore
@@ -254,7 +343,8 @@ namespace gvk
 		void			  DestroyVkSemaphore(VkSemaphore semaphore);
 
 		/// <summary>
-		/// Create a fence from current device.Return nullopt if creation fails
+		/// Create a fence from current device.Return nullopt if creation fails.
+		/// Thread safe
 		/// </summary>
 		/// <param name="flags">the flags for the fence</param>
 		/// <returns>the created fence</returns>
@@ -294,7 +384,8 @@ namespace gvk
 
 
 		/// <summary>
-		/// Present a back buffer
+		/// Present a back buffer.
+		/// Not thread safe,call it on the thread calling AcquireNextImage
 		/// </summary>
 		/// <param name="semaphore">The semaphore to wait before the presentation</param>
 		/// <returns> Return VK_SUCCESS if success, otherwise return corresponding error message</returns>
@@ -302,7 +393,8 @@ namespace gvk
 
 
 		/// <summary>
-		/// Create a buffer from global allocator
+		/// Create a buffer from global allocator.
+		/// Thread safe
 		/// </summary>
 		/// <param name="buffer_usage">the usage of the buffer</param>
 		/// <param name="size">the size of the buffer</param>
@@ -311,26 +403,54 @@ namespace gvk
 		opt<ptr<Buffer>> CreateBuffer(VkBufferUsageFlags buffer_usage, uint64_t size, GVK_HOST_WRITE_PROPERTY write);
 
 		/// <summary>
-		/// Create a image from global allocator
+		/// Create a image from global allocator.
+		/// Thread safe
 		/// </summary>
 		/// <param name="info">the create info of the image</param>
 		/// <returns>created image</returns>
 		opt<ptr<Image>>  CreateImage(const GvkImageCreateInfo& info);
 
 		/// <summary>
-		/// Create a graphics pipeline
+		/// Create a graphics pipeline.
+		/// Thread safe
 		/// </summary>
 		/// <param name="create_info">the create info of the graphics pipeline</param>
 		/// <returns>created graphics pipeline</returns>
 		opt<ptr<Pipeline>>	CreateGraphicsPipeline(const GvkGraphicsPipelineCreateInfo& create_info);
 
 		/// <summary>
-		/// Create a compute pipeline
+		/// Create a compute pipeline.
+		/// Thread safe
 		/// </summary>
 		/// <param name="create_info">the create info of the compute pipeline</param>
 		/// <returns>created compute pipeline</returns>
 		opt<ptr<Pipeline>>	CreateComputePipeline(const GvkComputePipelineCreateInfo& create_info);
 
+		/// <summary>
+		/// Create several graphics pipelines with a single vkCreateGraphicsPipelines call
+		/// </summary>
+		/// <param name="create_infos">the create infos of the graphics pipelines</param>
+		/// <returns>created graphics pipelines in the order of create infos,nullopt for pipelines failed to create</returns>
+		std::vector<opt<ptr<Pipeline>>> CreateGraphicsPipelines(View<GvkGraphicsPipelineCreateInfo> create_infos);
+
+		/// <summary>
+		/// Create a graphics pipeline on worker threads of the context's thread pool.
+		/// The create info is copied so it can be released after this call.
+		/// The context must outlive the returned handle
+		/// </summary>
+		/// <param name="create_info">the create info of the graphics pipeline</param>
+		/// <returns>handle of the pipeline being created</returns>
+		ptr<AsyncPipeline>	CreateGraphicsPipelineAsync(const GvkGraphicsPipelineCreateInfo& create_info);
+
+		/// <summary>
+		/// Create a compute pipeline on worker threads of the context's thread pool.
+		/// The create info is copied so it can be released after this call.
+		/// The context must outlive the returned handle
+		/// </summary>
+		/// <param name="create_info">the create info of the compute pipeline</param>
+		/// <returns>handle of the pipeline being created</returns>
+		ptr<AsyncPipeline>	CreateComputePipelineAsync(const GvkComputePipelineCreateInfo& create_info);
+
 		/// <summary>
 		/// Create a raytracing pipeline
 		/// </summary>
@@ -343,7 +463,8 @@ namespace gvk
 		opt<ptr<BottomAccelerationStructure>> CreateBottomAccelerationStructure(View<GvkBottomAccelerationStructureGeometryTriangles> info);
 		
 		/// <summary>
-		/// Create a render pass
+		/// Create a render pass.
+		/// Thread safe
 		/// </summary>
 		/// <param name="info">the create info of render pass</param>
 		/// <returns>created render pass</returns>
@@ -352,21 +473,64 @@ namespace gvk
 		/// <summary>
 		/// Create a descriptor set layout of a set slot from several shaders.
 		/// It is important that the descriptor bindings inside the set in shaders should be compatiable with each other.
+		/// Thread safe
 		/// </summary>
 		/// <param name="target_shaders">the target shaders to create layout from</param>
 		/// <param name="target_binding">the target set slot to create descriptor set</param>
+		/// <param name="push_descriptor">create the layout for push descriptors,requires GVK_DEVICE_EXTENSION_PUSH_DESCRIPTOR.
+		/// Sets of push descriptor layouts are written by GvkPushDescriptorSet instead of being allocated</param>
+		/// <param name="dynamic_bindings">uniform/storage buffer bindings created as dynamic buffers.
+		/// Their offsets are given when binding sets by GvkDescriptorSetBindingUpdate,
+		/// pipelines should use the layout through GvkDescriptorLayoutHint</param>
 		/// <returns>created descriptor set layout</returns>
 		opt<ptr<DescriptorSetLayout>> CreateDescriptorSetLayout(const std::vector<ptr<Shader>>& target_shaders,
-			uint32_t target_set,std::string* error, uint32_t max_bindless_descriptor_cnt);
+			uint32_t target_set,std::string* error, uint32_t max_bindless_descriptor_cnt, bool push_descriptor = false,
+			const std::vector<uint32_t>& dynamic_bindings = {});
 
 		/// <summary>
-		/// Create a descriptor allocator
+		/// Create a descriptor update template updating every binding of a descriptor set layout at once.
+		/// Variable count bindless bindings are not included in the template
 		/// </summary>
+		/// <param name="layout">the layout descriptor sets updated by the template are allocated from</param>
+		/// <param name="error">error message if the creation fails</param>
+		/// <returns>created descriptor update template</returns>
+		opt<ptr<DescriptorUpdateTemplate>> CreateDescriptorUpdateTemplate(const ptr<DescriptorSetLayout>& layout, std::string* error);
+
+		/// <summary>
+		/// Create a descriptor allocator.
+		/// Thread safe,but the allocator returned is used by one thread at a time
+		/// </summary>
+		/// <param name="frame_count">count of frames in flight with their own transient pools,0 for the back buffer count</param>
 		/// <returns>created descriptor allocator</returns>
-		ptr<DescriptorAllocator>	  CreateDescriptorAllocator();
+		ptr<DescriptorAllocator>	  CreateDescriptorAllocator(uint32_t frame_count = 0);
+
+		/// <summary>
+		/// Get the descriptor allocator of the calling thread,it is created at the first call on every thread
+		/// and dropped by the context after the thread has exited.
+		/// Allocations from it need no lock as long as it is only used by that thread
+		/// </summary>
+		/// <returns>descriptor allocator of the calling thread</returns>
+		ptr<DescriptorAllocator>	  GetThreadDescriptorAllocator();
+
+		/// <summary>
+		/// Get the command pool of the calling thread for a queue family,it is created at the first call on every thread
+		/// and released by the context after the thread has exited.
+		/// Command buffers from it can be recorded without lock as long as the pool is only used by that thread
+		/// </summary>
+		/// <param name="queue">queue the command buffers are submitted to</param>
+		/// <returns>command pool of the calling thread,nullptr if it fails to create</returns>
+		ptr<CommandPool>			  GetThreadCommandPool(const CommandQueue* queue);
+
+		/// <summary>
+		/// Call BeginFrame of every thread descriptor allocator.
+		/// No thread should allocate from them during this call
+		/// </summary>
+		/// <param name="frame_index">index of the frame in flight</param>
+		void						  BeginDescriptorFrame(uint32_t frame_index);
 
 		/// <summary>
-		/// Create a frame buffer for render pass
+		/// Create a frame buffer for render pass.
+		/// Thread safe
 		/// </summary>
 		/// <param name="render_pass">target render pass</param>
 		/// <param name="views">array of attachments in the frame buffer, count of views in the array should equal to RenderPass::GetAttachmentCount() or 1</param>
@@ -380,7 +544,7 @@ namespace gvk
 
 
 		/// <summary>
-		/// equal to vkWaitForDeviceIdle
+		/// equal to vkWaitForDeviceIdle,then performs every release waiting in the release queue
 		/// </summary>
 		void						  WaitForDeviceIdle();
 
@@ -391,14 +555,16 @@ namespace gvk
 		void						  DestroyFrameBuffer(VkFramebuffer frame_buffer);
 
 		/// <summary>
-		/// create a sampler
+		/// create a sampler.
+		/// Thread safe
 		/// </summary>
 		/// <param name="sampler_info">the create info of the sampler</param>
 		/// <returns>created sampler</returns>
 		opt<VkSampler>					  CreateSampler(VkSamplerCreateInfo& sampler_info);
 
 		/// <summary>
-		/// Destroy the created sampler
+		/// Destroy the created sampler.
+		/// Thread safe
 		/// </summary>
 		/// <param name="sampler">a not null VkSampler</param>
 		void						  DestroySampler(VkSampler sampler);
@@ -427,8 +593,174 @@ namespace gvk
 
 		VkDescriptorSetLayout		  GetDummyDescriptorSetLayout();
 
+		/// <summary>
+		/// Get the pipeline cache shared by all pipeline creation of this context
+		/// </summary>
+		/// <returns>the pipeline cache</returns>
+		VkPipelineCache				  GetPipelineCache();
+
+		/// <summary>
+		/// Serialize the pipeline cache to a file.The data is written to a temporary file first and then renamed,
+		/// so an interrupted save never leaves a truncated cache behind.
+		/// Thread safe,saves are serialized and pipelines can be created during a save
+		/// </summary>
+		/// <param name="file">target file,if it is NULL the file in GvkDeviceCreateInfo::pipeline_cache_file is used</param>
+		/// <param name="error">error message if the operation fails</param>
+		/// <returns>if the pipeline cache is saved</returns>
+		bool						  SavePipelineCache(const char* file, std::string* error);
+
+		/// <summary>
+		/// Get the count of pipelines created from pipeline cache and the count of pipelines compiled from scratch.
+		/// Pipelines are only counted when the device supports pipeline creation feedback
+		/// </summary>
+		/// <returns>hit and miss count of the pipeline cache</returns>
+		GvkPipelineCacheStatistics	  GetPipelineCacheStatistics();
+
+		/// <summary>
+		/// Get the thread pool shared by the subsystems of this context.
+		/// The pool is created at the first call
+		/// </summary>
+		/// <returns>the thread pool</returns>
+		ptr<ThreadPool>				  GetThreadPool();
+
+		/// <summary>
+		/// Use a thread pool shared with the application instead of creating one.
+		/// It should be called before the first call of GetThreadPool.
+		/// The pool outlives the context,the context waits for the tasks it submitted before it is destroyed
+		/// </summary>
+		/// <param name="pool">the thread pool</param>
+		/// <returns>false if the context already has a thread pool</returns>
+		bool						  AttachThreadPool(ptr<ThreadPool> pool);
+
+		/// <summary>
+		/// Watch the source files of shaders compiled by CompileShader after this call.
+		/// When a source file or an included file is modified, the shaders are recompiled in background and
+		/// graphics/compute pipelines created from them are rebuilt and swapped in at the next Present.
+		/// Pipelines whose descriptor or push constant layout changed are not swapped, an error is reported instead.
+		/// Command buffers recorded with a swapped pipeline must be recorded again, see PollShaderReloadSwaps
+		/// </summary>
+		/// <param name="error">error message if hot reload fails to start</param>
+		/// <returns>if shader hot reload is enabled</returns>
+		bool						  EnableShaderHotReload(std::string* error);
+
+		/// <summary>
+		/// Get the errors of shader reloads in background since the last call,e.g. compile errors
+		/// </summary>
+		/// <returns>error messages,empty if hot reload is not enabled</returns>
+		std::vector<std::string>	  PollShaderReloadErrors();
+
+		/// <summary>
+		/// Get the pipelines swapped by shader reloads since the last call.
+		/// The old vulkan pipelines are kept alive until this call and released after the gpu work submitted before it,
+		/// so every command buffer that recorded a returned pipeline must be recorded again before its next submission.
+		/// Call it once a frame when hot reload is enabled,otherwise the old pipelines accumulate
+		/// </summary>
+		/// <returns>swapped pipelines,empty if hot reload is not enabled</returns>
+		std::vector<ptr<Pipeline>>	  PollShaderReloadSwaps();
+
+		/// <summary>
+		/// Create the context wide bindless heap.
+		/// The device should be created with GVK_DEVICE_EXTENSION_BINDLESS_IMAGE.
+		/// Released slots are recycled after the gpu work submitted before the release has finished
+		/// </summary>
+		/// <param name="info">capacity of every resource type</param>
+		/// <param name="error">error message if the heap fails to create</param>
+		/// <returns>if the heap is created</returns>
+		bool						  InitializeBindlessHeap(const GvkBindlessHeapCreateInfo& info, std::string* error);
+
+		/// <summary>
+		/// Get the bindless heap created by InitializeBindlessHeap
+		/// </summary>
+		/// <returns>the bindless heap,nullptr if it is not initialized</returns>
+		ptr<BindlessHeap>			  GetBindlessHeap();
+
+		/// <summary>
+		/// Create a descriptor buffer to allocate descriptor sets from.
+		/// The device should be created with GVK_DEVICE_EXTENSION_DESCRIPTOR_BUFFER,then every descriptor set layout
+		/// and pipeline of the context is created for descriptor buffers and descriptor pools can't be used
+		/// </summary>
+		/// <param name="size">size of the buffer in bytes</param>
+		/// <param name="error">error message if the buffer fails to create</param>
+		/// <returns>the descriptor buffer</returns>
+		opt<ptr<DescriptorBuffer>>	  CreateDescriptorBuffer(VkDeviceSize size, std::string* error);
+
+		/// <summary>
+		/// If the device is created with GVK_DEVICE_EXTENSION_DESCRIPTOR_BUFFER
+		/// </summary>
+		bool						  DescriptorBufferEnabled();
+
+		/// <summary>
+		/// Create a persistently mapped ring for per frame uniform data bound by dynamic offsets.
+		/// The ring holds one region of frame_size bytes for every frame in flight
+		/// </summary>
+		/// <param name="frame_size">size of the region of a frame,aligned to the dynamic offset alignment of the device</param>
+		/// <param name="frame_count">count of frames in flight,0 means the count of back buffers</param>
+		/// <param name="error">error message if the ring fails to create</param>
+		/// <returns>created uniform ring</returns>
+		opt<ptr<UniformRing>>		  CreateUniformRing(uint32_t frame_size, uint32_t frame_count = 0, std::string* error = nullptr);
+
+		/// <summary>
+		/// Create the frames in flight of the swap chain,one for every back buffer.
+		/// After it is initialized AcquireNextImage waits for the last frame with the current frame index and recycles its resources,
+		/// Present signals the fence of the frame after the work submitted to the present queue before it.
+		/// Command buffers of the frames are allocated for the present queue
+		/// </summary>
+		/// <param name="info">transient allocators created for the frames</param>
+		/// <param name="error">error message if the frames fail to create</param>
+		/// <returns>if the frame ring is created</returns>
+		bool						  InitializeFrameRing(const GvkFrameRingCreateInfo& info, std::string* error);
+
+		/// <summary>
+		/// Get the frame ring created by InitializeFrameRing
+		/// </summary>
+		/// <returns>the frame ring,nullptr if it is not initialized</returns>
+		ptr<FrameRing>				  GetFrameRing();
+
+		/// <summary>
+		/// Get the queue releasing objects after the gpu work submitted before they are dropped.
+		/// Buffers,images,pipelines and acceleration structures created by the context are released through it
+		/// </summary>
+		/// <returns>the release queue</returns>
+		ptr<ReleaseQueue>			  GetReleaseQueue();
+
 		~Context();
 	private:
+		//the object is deleted by the release queue when its last reference drops
+		template<typename T>
+		ptr<T>		 WrapDeferredRelease(T* object)
+		{
+			ptr<ReleaseQueue> queue = m_ReleaseQueue;
+			return ptr<T>(object, [queue](T* object) { queue->Release([object]() { delete object; }); });
+		}
+
+		//submit a task capturing the context,the context waits for it before it is destroyed
+		template<typename F>
+		auto		 SubmitJob(F&& task)
+		{
+			return GetThreadPool()->Submit(std::forward<F>(task), m_Jobs);
+		}
+
+		//object created for a thread,it is dropped after the thread has exited
+		template<typename T>
+		struct ThreadObject
+		{
+			std::weak_ptr<void> thread;
+			ptr<T>				object;
+		};
+
+		//expires when the calling thread exits
+		static std::weak_ptr<void> GetThreadToken();
+
+		//remove the objects of exited threads,they are returned so that they can be dropped out of the lock
+		template<typename T>
+		static std::vector<ThreadObject<T>> PruneThreadObjects(std::vector<ThreadObject<T>>& objects)
+		{
+			auto exited = std::stable_partition(objects.begin(), objects.end(),
+				[](const ThreadObject<T>& object) { return !object.thread.expired(); });
+			std::vector<ThreadObject<T>> pruned(std::make_move_iterator(exited), std::make_move_iterator(objects.end()));
+			objects.erase(exited, objects.end());
+			return pruned;
+		}
 		
 		bool IntializeMemoryAllocation(bool addressable, uint32_t vk_api_version, std::string* error);
 
@@ -507,7 +839,9 @@ namespace gvk
 		VkPhysicalDevice m_PhyDevice = NULL;
 		PhysicalDevicePropertiesAndFeatures m_DevicePropertiesFeature;
 		
+		//queues not created yet,queues destroyed return to it
 		std::vector<QueueInfo> m_RequiredQueueInfos;
+		std::mutex			   m_QueueInfoLock;
 
 		VkSwapchainCreateInfoKHR m_SwapChainCreateInfo;
 		ptr<CommandQueue> m_PresentQueue = NULL;
@@ -533,9 +867,57 @@ namespace gvk
 		bool		 m_DeviceAddressable;
 
 		opt<uint32_t> FindSuitableQueueIndex(VkFlags flags,float priority);
+		//called with m_QueueInfoLock held or during InitializeDevice
 		opt<ptr<CommandQueue>> ConsumePrequiredQueue(uint32_t idx);
 		void		 OnCommandQueueDestroy(CommandQueue* queue);
 
 		VkDescriptorSetLayout m_DummyDescriptorSetLayout;
+
+		//return a cached layout if a structurally identical one is alive,otherwise create a new one
+		opt<ptr<SharedDescriptorSetLayout>> AcquireDescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo& info,
+			const std::vector<VkDescriptorBindingFlags>& binding_flags);
+		//nullptr in set layouts is replaced by the dummy descriptor set layout
+		opt<ptr<SharedPipelineLayout>>		AcquirePipelineLayout(const std::vector<ptr<DescriptorSetLayout>>& set_layouts,
+			const std::vector<VkPushConstantRange>& push_constant_ranges);
+
+		std::mutex			  m_LayoutCacheLock;
+		std::unordered_map<std::string, std::weak_ptr<SharedDescriptorSetLayout>> m_DescriptorSetLayoutCache;
+		std::unordered_map<std::string, std::weak_ptr<SharedPipelineLayout>>	   m_PipelineLayoutCache;
+		size_t				  m_DescriptorSetLayoutCachePruneSize = 64;
+		size_t				  m_PipelineLayoutCachePruneSize = 64;
+
+		bool		 InitializePipelineCache(const std::string& file, std::string* error);
+		void		 RecordPipelineCreationFeedback(const VkPipelineCreationFeedback& feedback);
+
+		//created without VK_PIPELINE_CACHE_CREATE_EXTERNALLY_SYNCHRONIZED_BIT,
+		//so pipelines of several threads use it without lock
+		VkPipelineCache		  m_PipelineCache = NULL;
+		std::string			  m_PipelineCacheFile;
+		//saves of several threads would write the same temporary file
+		std::mutex			  m_PipelineCacheSaveLock;
+		//pipeline creation feedback is core since vulkan 1.3
+		bool				  m_PipelineCreationFeedback = false;
+		std::atomic<uint32_t> m_PipelineCacheHitCount{ 0 };
+		std::atomic<uint32_t> m_PipelineCacheMissCount{ 0 };
+
+		ptr<ThreadPool>		  m_ThreadPool;
+		std::once_flag		  m_ThreadPoolCreated;
+		//tasks of the context running on the thread pool,an attached pool may outlive the context
+		ptr<JobCounter>		  m_Jobs;
+
+		ptr<ShaderHotReloader> m_HotReloader;
+		ptr<BindlessHeap>	  m_BindlessHeap;
+		ptr<FrameRing>		  m_FrameRing;
+
+		//identifies the context in thread local storage,addresses of contexts may be reused
+		uint64_t			  m_ContextId;
+		std::mutex			  m_ThreadDescriptorAllocatorLock;
+		std::vector<ThreadObject<DescriptorAllocator>> m_ThreadDescriptorAllocators;
+		std::mutex			  m_ThreadCommandPoolLock;
+		std::vector<ThreadObject<CommandPool>> m_ThreadCommandPools;
+		//every set layout and pipeline is created for descriptor buffers if the extension is enabled
+		bool				  m_DescriptorBufferEnabled = false;
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT m_DescriptorBufferProperties{};
+		ptr<ReleaseQueue>	  m_ReleaseQueue;
 	};
 }
@@ -0,0 +1,227 @@
+#include "gvk_descriptor_buffer.h"
+#include "gvk_context.h"
+
+namespace gvk {
+
+	DescriptorBufferSet::DescriptorBufferSet(DescriptorBuffer* buffer, DescriptorBufferLayout* layout, VkDeviceSize offset)
+		:m_Buffer(buffer), m_Layout(layout), m_Offset(offset) {}
+
+	void DescriptorBufferSet::Write(uint32_t binding, uint32_t array_index, VkDescriptorGetInfoEXT& info)
+	{
+		auto iter = m_Layout->bindings.find(binding);
+		gvk_assert(iter != m_Layout->bindings.end());
+		info.type = iter->second.type;
+
+		//elements of an array binding are tightly packed by the descriptor size
+		size_t descriptor_size = m_Buffer->GetDescriptorSize(info.type);
+		uint8_t* dst = m_Buffer->m_Mapped + m_Offset + iter->second.offset + array_index * descriptor_size;
+		vkGetDescriptorEXT(m_Buffer->m_Device, &info, descriptor_size, dst);
+	}
+
+	DescriptorBufferSet& DescriptorBufferSet::BufferWrite(uint32_t binding, VkDeviceAddress address, VkDeviceSize range, uint32_t array_index)
+	{
+		VkDescriptorAddressInfoEXT address_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT };
+		address_info.address = address;
+		address_info.range = range;
+		address_info.format = VK_FORMAT_UNDEFINED;
+
+		VkDescriptorGetInfoEXT info{ VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
+		//every buffer member of the union points to an address info
+		info.data.pUniformBuffer = &address_info;
+		Write(binding, array_index, info);
+		return *this;
+	}
+
+	DescriptorBufferSet& DescriptorBufferSet::BufferWrite(const char* name, VkDeviceAddress address, VkDeviceSize range, uint32_t array_index)
+	{
+		if (auto iter = m_Layout->names.find(name); iter != m_Layout->names.end())
+		{
+			BufferWrite(iter->second, address, range, array_index);
+		}
+		return *this;
+	}
+
+	DescriptorBufferSet& DescriptorBufferSet::ImageWrite(uint32_t binding, VkSampler sampler, VkImageView image_view, VkImageLayout layout, uint32_t array_index)
+	{
+		VkDescriptorImageInfo image_info{};
+		image_info.sampler = sampler;
+		image_info.imageView = image_view;
+		image_info.imageLayout = layout;
+
+		VkDescriptorGetInfoEXT info{ VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
+		auto iter = m_Layout->bindings.find(binding);
+		gvk_assert(iter != m_Layout->bindings.end());
+		switch (iter->second.type)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+			info.data.pSampler = &image_info.sampler;
+			break;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			info.data.pCombinedImageSampler = &image_info;
+			break;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+			info.data.pSampledImage = &image_info;
+			break;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			info.data.pStorageImage = &image_info;
+			break;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			info.data.pInputAttachmentImage = &image_info;
+			break;
+		default:
+			gvk_assert(false);
+			return *this;
+		}
+		Write(binding, array_index, info);
+		return *this;
+	}
+
+	DescriptorBufferSet& DescriptorBufferSet::ImageWrite(const char* name, VkSampler sampler, VkImageView image_view, VkImageLayout layout, uint32_t array_index)
+	{
+		if (auto iter = m_Layout->names.find(name); iter != m_Layout->names.end())
+		{
+			ImageWrite(iter->second, sampler, image_view, layout, array_index);
+		}
+		return *this;
+	}
+
+	DescriptorBufferSet& DescriptorBufferSet::AccelerationStructureWrite(uint32_t binding, VkDeviceAddress tlas_address)
+	{
+		VkDescriptorGetInfoEXT info{ VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT };
+		info.data.accelerationStructure = tlas_address;
+		Write(binding, 0, info);
+		return *this;
+	}
+
+	void DescriptorBufferSet::Bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout)
+	{
+		//the descriptor buffer is bound at index 0 by DescriptorBuffer::Bind
+		uint32_t buffer_index = 0;
+		vkCmdSetDescriptorBufferOffsetsEXT(cmd, bind_point, layout, GetSetIndex(), 1, &buffer_index, &m_Offset);
+	}
+
+	uint32_t DescriptorBufferSet::GetSetIndex()
+	{
+		return m_Layout->layout->GetSetID();
+	}
+
+	VkDeviceSize DescriptorBufferSet::GetOffset()
+	{
+		return m_Offset;
+	}
+
+	DescriptorBuffer::DescriptorBuffer(ptr<Buffer> buffer, uint8_t* mapped, const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties, VkDevice device)
+		:m_Buffer(buffer), m_Mapped(mapped), m_Properties(properties), m_Device(device)
+	{
+		m_Properties.pNext = NULL;
+	}
+
+	size_t DescriptorBuffer::GetDescriptorSize(VkDescriptorType type)
+	{
+		switch (type)
+		{
+		case VK_DESCRIPTOR_TYPE_SAMPLER:					return m_Properties.samplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:		return m_Properties.combinedImageSamplerDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:				return m_Properties.sampledImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:				return m_Properties.storageImageDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:		return m_Properties.uniformTexelBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:		return m_Properties.storageTexelBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:				return m_Properties.uniformBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:				return m_Properties.storageBufferDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:			return m_Properties.inputAttachmentDescriptorSize;
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: return m_Properties.accelerationStructureDescriptorSize;
+		default:
+			//dynamic buffers are rejected when descriptor buffer layouts are created
+			gvk_assert(false);
+			return 0;
+		}
+	}
+
+	opt<DescriptorBufferSet> DescriptorBuffer::Allocate(const ptr<DescriptorSetLayout>& layout)
+	{
+		VkDescriptorSetLayout vk_layout = layout->GetLayout();
+		auto iter = m_Layouts.find(vk_layout);
+		if (iter == m_Layouts.end())
+		{
+			DescriptorBufferLayout info;
+			info.layout = layout;
+			vkGetDescriptorSetLayoutSizeEXT(m_Device, vk_layout, &info.size);
+			for (auto binding : layout->GetDescriptorSetBindings())
+			{
+				DescriptorBufferLayout::Binding binding_info;
+				binding_info.type = layout->GetDescriptorType(binding->binding);
+				vkGetDescriptorSetLayoutBindingOffsetEXT(m_Device, vk_layout, binding->binding, &binding_info.offset);
+				info.bindings[binding->binding] = binding_info;
+				info.names[binding->Name()] = binding->binding;
+			}
+			iter = m_Layouts.emplace(vk_layout, std::move(info)).first;
+		}
+
+		VkDeviceSize offset = (m_UsedSize + m_Properties.descriptorBufferOffsetAlignment - 1) /
+			m_Properties.descriptorBufferOffsetAlignment * m_Properties.descriptorBufferOffsetAlignment;
+		if (offset + iter->second.size > m_Buffer->GetSize())
+		{
+			return std::nullopt;
+		}
+		m_UsedSize = offset + iter->second.size;
+		return DescriptorBufferSet(this, &iter->second, offset);
+	}
+
+	void DescriptorBuffer::Reset()
+	{
+		m_UsedSize = 0;
+	}
+
+	void DescriptorBuffer::Bind(VkCommandBuffer cmd)
+	{
+		VkDescriptorBufferBindingInfoEXT binding_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT };
+		binding_info.address = m_Buffer->GetAddress();
+		binding_info.usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+		vkCmdBindDescriptorBuffersEXT(cmd, 1, &binding_info);
+	}
+
+	VkDeviceSize DescriptorBuffer::GetSize()
+	{
+		return m_Buffer->GetSize();
+	}
+
+	VkDeviceSize DescriptorBuffer::GetUsedSize()
+	{
+		return m_UsedSize;
+	}
+
+	ptr<Buffer> DescriptorBuffer::GetBuffer()
+	{
+		return m_Buffer;
+	}
+
+	opt<ptr<DescriptorBuffer>> Context::CreateDescriptorBuffer(VkDeviceSize size, std::string* error)
+	{
+		if (!m_DescriptorBufferEnabled)
+		{
+			if (error) *error = "gvk : fail to create descriptor buffer, the device is not created with GVK_DEVICE_EXTENSION_DESCRIPTOR_BUFFER";
+			return std::nullopt;
+		}
+
+		auto buffer = CreateBuffer(VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, size, GVK_HOST_WRITE_RANDOM);
+		if (!buffer.has_value())
+		{
+			if (error) *error = "gvk : fail to create buffer for descriptor buffer";
+			return std::nullopt;
+		}
+		auto mapped = buffer.value()->Map();
+		if (!mapped.has_value())
+		{
+			if (error) *error = "gvk : fail to map descriptor buffer";
+			return std::nullopt;
+		}
+
+		return ptr<DescriptorBuffer>(new DescriptorBuffer(buffer.value(), (uint8_t*)mapped.value(), m_DescriptorBufferProperties, m_Device));
+	}
+
+	bool Context::DescriptorBufferEnabled()
+	{
+		return m_DescriptorBufferEnabled;
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_pipeline.h"
+#include "gvk_resource.h"
+
+namespace gvk {
+	class DescriptorBuffer;
+
+	//sizes and binding offsets of a set layout queried from the driver
+	struct DescriptorBufferLayout
+	{
+		struct Binding
+		{
+			VkDeviceSize	 offset;
+			VkDescriptorType type;
+		};
+
+		//keep the layout alive so that its handle is not reused by another layout
+		ptr<DescriptorSetLayout>					 layout;
+		VkDeviceSize								 size;
+		std::unordered_map<uint32_t, Binding>		 bindings;
+		std::unordered_map<std::string, uint32_t>	 names;
+	};
+
+	//a descriptor set stored in a descriptor buffer,valid until the buffer is reset.
+	//descriptors are written straight into the mapped memory of the buffer
+	class DescriptorBufferSet
+	{
+		friend class DescriptorBuffer;
+	public:
+		DescriptorBufferSet& BufferWrite(uint32_t binding, VkDeviceAddress address, VkDeviceSize range, uint32_t array_index = 0);
+		DescriptorBufferSet& BufferWrite(const char* name, VkDeviceAddress address, VkDeviceSize range, uint32_t array_index = 0);
+
+		DescriptorBufferSet& ImageWrite(uint32_t binding, VkSampler sampler, VkImageView image_view, VkImageLayout layout, uint32_t array_index = 0);
+		DescriptorBufferSet& ImageWrite(const char* name, VkSampler sampler, VkImageView image_view, VkImageLayout layout, uint32_t array_index = 0);
+
+		DescriptorBufferSet& AccelerationStructureWrite(uint32_t binding, VkDeviceAddress tlas_address);
+
+		/// <summary>
+		/// Bind the set to a pipeline layout,the descriptor buffer should be bound by DescriptorBuffer::Bind first
+		/// </summary>
+		void				 Bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout);
+
+		uint32_t			 GetSetIndex();
+		VkDeviceSize		 GetOffset();
+
+	private:
+		DescriptorBufferSet(DescriptorBuffer* buffer, DescriptorBufferLayout* layout, VkDeviceSize offset);
+
+		void				 Write(uint32_t binding, uint32_t array_index, VkDescriptorGetInfoEXT& info);
+
+		DescriptorBuffer*	 m_Buffer;
+		DescriptorBufferLayout*	 m_Layout;
+		VkDeviceSize		 m_Offset;
+	};
+
+	//host visible buffer holding descriptor sets,it replaces descriptor pools when descriptor buffers are enabled.
+	//sets are sub-allocated linearly and released together by Reset,
+	//so one descriptor buffer per frame in flight is usually used
+	class DescriptorBuffer
+	{
+		friend class Context;
+		friend class DescriptorBufferSet;
+	public:
+		/// <summary>
+		/// Allocate a set from the buffer.The layout must be created by a context with descriptor buffers enabled
+		/// </summary>
+		/// <param name="layout">layout of the set</param>
+		/// <returns>allocated set,nullopt if the buffer is full</returns>
+		opt<DescriptorBufferSet> Allocate(const ptr<DescriptorSetLayout>& layout);
+
+		/// <summary>
+		/// Release all sets allocated from the buffer,the gpu work using them must have finished
+		/// </summary>
+		void					 Reset();
+
+		/// <summary>
+		/// Bind the descriptor buffer to a command buffer at index 0
+		/// </summary>
+		void					 Bind(VkCommandBuffer cmd);
+
+		VkDeviceSize			 GetSize();
+		VkDeviceSize			 GetUsedSize();
+		ptr<Buffer>				 GetBuffer();
+
+	private:
+		DescriptorBuffer(ptr<Buffer> buffer, uint8_t* mapped, const VkPhysicalDeviceDescriptorBufferPropertiesEXT& properties, VkDevice device);
+
+		size_t					 GetDescriptorSize(VkDescriptorType type);
+
+		ptr<Buffer>				 m_Buffer;
+		uint8_t*				 m_Mapped;
+		VkDeviceSize			 m_UsedSize = 0;
+		VkPhysicalDeviceDescriptorBufferPropertiesEXT m_Properties;
+		VkDevice				 m_Device;
+
+		std::unordered_map<VkDescriptorSetLayout, DescriptorBufferLayout> m_Layouts;
+	};
+}
@@ -0,0 +1,220 @@
+#include "gvk_frame.h"
+#include "gvk_context.h"
+
+namespace gvk {
+
+	FrameContext::FrameContext(VkDevice device, uint32_t index, VkFence fence, ptr<CommandPool> pool,
+		ptr<DescriptorAllocator> allocator, ptr<UniformRing> uniform_ring)
+		:m_Device(device), m_Index(index), m_Fence(fence), m_CommandPool(pool),
+		m_DescriptorAllocator(allocator), m_UniformRing(uniform_ring) {}
+
+	uint32_t FrameContext::GetIndex()
+	{
+		return m_Index;
+	}
+
+	VkFence FrameContext::GetFence()
+	{
+		return m_Fence;
+	}
+
+	ptr<CommandPool> FrameContext::GetCommandPool()
+	{
+		return m_CommandPool;
+	}
+
+	opt<VkCommandBuffer> FrameContext::AllocateCommandBuffer(VkCommandBufferLevel level)
+	{
+		gvk_assert(level == VK_COMMAND_BUFFER_LEVEL_PRIMARY || level == VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		auto& buffers = m_CommandBuffers[level];
+		auto& used = m_UsedCommandBuffers[level];
+		if (used < buffers.size())
+		{
+			return buffers[used++];
+		}
+		auto cmd = m_CommandPool->CreateCommandBuffer(level);
+		if (!cmd.has_value())
+		{
+			return std::nullopt;
+		}
+		buffers.push_back(cmd.value());
+		used++;
+		return cmd;
+	}
+
+	opt<VkDescriptorSet> FrameContext::AllocateDescriptorSet(ptr<DescriptorSetLayout> layout)
+	{
+		gvk_assert(m_DescriptorAllocator != nullptr);
+		return m_DescriptorAllocator->AllocateTransient(layout);
+	}
+
+	opt<uint32_t> FrameContext::PushUniform(const void* data, uint32_t size)
+	{
+		gvk_assert(m_UniformRing != nullptr);
+		return m_UniformRing->Push(data, size);
+	}
+
+	ptr<UniformRing> FrameContext::GetUniformRing()
+	{
+		return m_UniformRing;
+	}
+
+	void FrameContext::Begin()
+	{
+		//only the last frame with the same index is waited for,later frames keep running
+		vkWaitForFences(m_Device, 1, &m_Fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(m_Device, 1, &m_Fence);
+
+		//command buffers of the pool return to the initial state,they are handed out again
+		m_CommandPool->Reset();
+		m_UsedCommandBuffers[0] = 0;
+		m_UsedCommandBuffers[1] = 0;
+
+		if (m_DescriptorAllocator != nullptr)
+		{
+			m_DescriptorAllocator->BeginFrame(m_Index);
+		}
+		if (m_UniformRing != nullptr)
+		{
+			m_UniformRing->BeginFrame(m_Index);
+		}
+	}
+
+	FrameContext::~FrameContext()
+	{
+		//command buffers are freed with the pool
+		m_CommandPool = nullptr;
+		vkDestroyFence(m_Device, m_Fence, nullptr);
+	}
+
+	FrameRing::FrameRing(VkDevice device, std::vector<ptr<FrameContext>>&& frames)
+		:m_Device(device), m_Frames(std::move(frames)) {}
+
+	FrameContext& FrameRing::GetCurrentFrame()
+	{
+		return *m_Frames[m_CurrentFrame];
+	}
+
+	FrameContext& FrameRing::GetFrame(uint32_t index)
+	{
+		gvk_assert(index < m_Frames.size());
+		return *m_Frames[index];
+	}
+
+	uint32_t FrameRing::GetFrameCount()
+	{
+		return m_Frames.size();
+	}
+
+	void FrameRing::BeginFrame(uint32_t frame_index)
+	{
+		gvk_assert(frame_index < m_Frames.size());
+		//acquire may be retried after the swap chain is resized
+		if (m_FrameBegun)
+		{
+			gvk_assert(frame_index == m_CurrentFrame);
+			return;
+		}
+		m_CurrentFrame = frame_index;
+		m_Frames[frame_index]->Begin();
+		m_FrameBegun = true;
+	}
+
+	VkResult FrameRing::EndFrame(CommandQueue* queue, const std::vector<std::pair<CommandQueue*, uint64_t>>& submissions)
+	{
+		if (!m_FrameBegun)
+		{
+			return VK_SUCCESS;
+		}
+		m_FrameBegun = false;
+		//the fence of an empty submission signals after every submission before it on the queue,
+		//submissions of other queues are waited through their timeline semaphores
+		SemaphoreInfo waits;
+		for (auto& [other, submission] : submissions)
+		{
+			if (other != queue)
+			{
+				waits.Wait(other, submission, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			}
+		}
+		VkResult result;
+		queue->Submit(nullptr, 0, waits, m_Frames[m_CurrentFrame]->m_Fence, false, &result);
+		return result;
+	}
+
+	FrameRing::~FrameRing()
+	{
+		for (uint32 i = 0; i < m_Frames.size(); i++)
+		{
+			//the fence of a frame begun but not presented is never signaled
+			if (m_FrameBegun && i == m_CurrentFrame) continue;
+			VkFence fence = m_Frames[i]->m_Fence;
+			vkWaitForFences(m_Device, 1, &fence, VK_TRUE, UINT64_MAX);
+		}
+		m_Frames.clear();
+	}
+
+	bool Context::InitializeFrameRing(const GvkFrameRingCreateInfo& info, std::string* error)
+	{
+		gvk_assert(m_FrameRing == nullptr);
+		gvk_assert(m_PresentQueue != nullptr);
+		if (info.transient_descriptors && m_DescriptorBufferEnabled)
+		{
+			if (error) *error = "gvk : transient descriptors of frames are allocated from descriptor pools, they can't be used with descriptor buffers";
+			return false;
+		}
+
+		ptr<DescriptorAllocator> allocator;
+		if (info.transient_descriptors)
+		{
+			allocator = CreateDescriptorAllocator(m_BackBufferCount);
+		}
+		ptr<UniformRing> uniform_ring;
+		if (info.uniform_ring_size != 0)
+		{
+			auto ring = CreateUniformRing(info.uniform_ring_size, m_BackBufferCount, error);
+			if (!ring.has_value())
+			{
+				return false;
+			}
+			uniform_ring = ring.value();
+		}
+
+		std::vector<ptr<FrameContext>> frames;
+		for (uint32 i = 0; i < m_BackBufferCount; i++)
+		{
+			//signaled so the first use of every frame doesn't wait
+			auto fence = CreateFence(VK_FENCE_CREATE_SIGNALED_BIT);
+			if (!fence.has_value())
+			{
+				if (error) *error = "gvk : fail to create fence for frame in flight";
+				return false;
+			}
+
+			//command buffers are reset with the pool,not one by one.
+			//they are submitted to queues of the present queue's family,the fence of the frame covers the other queues
+			VkCommandPoolCreateInfo pool_info{};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			pool_info.queueFamilyIndex = m_PresentQueue->QueueFamily();
+			VkCommandPool vk_pool;
+			if (vkCreateCommandPool(m_Device, &pool_info, nullptr, &vk_pool) != VK_SUCCESS)
+			{
+				DestroyFence(fence.value());
+				if (error) *error = "gvk : fail to create command pool for frame in flight";
+				return false;
+			}
+			ptr<CommandPool> pool(new CommandPool(vk_pool, m_PresentQueue->QueueFamily(), m_Device));
+
+			frames.push_back(ptr<FrameContext>(new FrameContext(m_Device, i, fence.value(), pool, allocator, uniform_ring)));
+		}
+
+		m_FrameRing = ptr<FrameRing>(new FrameRing(m_Device, std::move(frames)));
+		return true;
+	}
+
+	ptr<FrameRing> Context::GetFrameRing()
+	{
+		return m_FrameRing;
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_command.h"
+#include "gvk_pipeline.h"
+#include "gvk_uniform_ring.h"
+
+struct GvkFrameRingCreateInfo
+{
+	//size of the uniform ring region of every frame,no uniform ring is created if it is 0
+	uint32_t uniform_ring_size	   = 0;
+	//create a descriptor allocator for transient descriptor sets,not available with descriptor buffers
+	bool	 transient_descriptors = true;
+};
+
+namespace gvk {
+
+	//resources owned by one frame in flight.
+	//they are recycled when the frame index comes round again and the fence of the frame has signaled.
+	//objects used by the frame are released through Context::GetReleaseQueue
+	class FrameContext
+	{
+		friend class FrameRing;
+		friend class Context;
+	public:
+		/// <summary>
+		/// Index of the frame in flight,equal to Context::CurrentFrameIndex while the frame is recorded
+		/// </summary>
+		uint32_t			 GetIndex();
+
+		/// <summary>
+		/// Fence signaled when every submission to the queues of the context before the frame is presented has finished
+		/// </summary>
+		VkFence				 GetFence();
+
+		/// <summary>
+		/// Get the command pool of the frame for the present queue's family.It is reset wholesale when the frame begins
+		/// </summary>
+		ptr<CommandPool>	 GetCommandPool();
+
+		/// <summary>
+		/// Get a command buffer from the pool of the frame.
+		/// Command buffers are reused by the next frame with the same index,so they must not be freed
+		/// </summary>
+		/// <param name="level">level of the command buffer</param>
+		/// <returns>a command buffer in the initial state</returns>
+		opt<VkCommandBuffer> AllocateCommandBuffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+		/// <summary>
+		/// Allocate a descriptor set valid until the frame index comes round again.
+		/// The frame ring should be created with transient_descriptors
+		/// </summary>
+		opt<VkDescriptorSet> AllocateDescriptorSet(ptr<DescriptorSetLayout> layout);
+
+		/// <summary>
+		/// Copy uniform data into the region of the frame.
+		/// The frame ring should be created with uniform_ring_size
+		/// </summary>
+		/// <returns>offset of the data in the buffer of the uniform ring,nullopt if the region is full</returns>
+		opt<uint32_t>		 PushUniform(const void* data, uint32_t size);
+
+		template<typename T>
+		opt<uint32_t>		 PushUniform(const T& data)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "uniform data must be trivially copyable");
+			return PushUniform(&data, sizeof(T));
+		}
+
+		ptr<UniformRing>	 GetUniformRing();
+
+		~FrameContext();
+	private:
+		FrameContext(VkDevice device, uint32_t index, VkFence fence, ptr<CommandPool> pool,
+			ptr<DescriptorAllocator> allocator, ptr<UniformRing> uniform_ring);
+
+		//wait for the last gpu work of the frame and recycle its resources
+		void				 Begin();
+
+		VkDevice					m_Device;
+		uint32_t					m_Index;
+		VkFence						m_Fence;
+		ptr<CommandPool>			m_CommandPool;
+		//shared by every frame of the ring,each frame uses its own pools and region
+		ptr<DescriptorAllocator>	m_DescriptorAllocator;
+		ptr<UniformRing>			m_UniformRing;
+
+		//command buffers allocated from the pool,the first used counts are handed out in the frame
+		std::vector<VkCommandBuffer> m_CommandBuffers[2];
+		uint32_t					m_UsedCommandBuffers[2] = { 0, 0 };
+	};
+
+	//frames in flight of the swap chain,one for every back buffer.
+	//Context::AcquireNextImage begins the current frame,waiting only for the frame that used the same index,
+	//and Context::Present signals its fence after the work submitted to every queue of the context.
+	//so the cpu records frame N+1 while the gpu executes frame N
+	class FrameRing
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Get the frame of Context::CurrentFrameIndex
+		/// </summary>
+		FrameContext&		GetCurrentFrame();
+		FrameContext&		GetFrame(uint32_t index);
+		uint32_t			GetFrameCount();
+
+		~FrameRing();
+	private:
+		FrameRing(VkDevice device, std::vector<ptr<FrameContext>>&& frames);
+
+		//called by AcquireNextImage,does nothing if the frame has begun
+		void				BeginFrame(uint32_t frame_index);
+		//called by Present before the presentation,the fence of the frame waits for the submissions of other queues
+		VkResult			EndFrame(CommandQueue* queue, const std::vector<std::pair<CommandQueue*, uint64_t>>& submissions);
+
+		VkDevice						m_Device;
+		std::vector<ptr<FrameContext>>	m_Frames;
+		uint32_t						m_CurrentFrame = 0;
+		bool							m_FrameBegun = false;
+	};
+}
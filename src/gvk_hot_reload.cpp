@@ -0,0 +1,386 @@
+#include "gvk_hot_reload.h"
+#include "gvk_context.h"
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace gvk {
+
+	//pipelines created while reloading replace tracked pipelines,they are not tracked themselves
+	static thread_local bool g_reloading = false;
+
+	ShaderHotReloader::ShaderHotReloader(Context* context)
+		:m_Context(context) {}
+
+	bool ShaderHotReloader::IsExpired(const WatchedShader& shader)
+	{
+		return std::all_of(shader.versions.begin(), shader.versions.end(),
+			[](const std::weak_ptr<Shader>& version) { return version.expired(); });
+	}
+
+	ShaderHotReloader::~ShaderHotReloader()
+	{
+		Stop();
+	}
+
+	bool ShaderHotReloader::Start(std::string* error)
+	{
+#ifdef __linux__
+		m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_Notify < 0)
+		{
+			if (error) *error = "gvk : fail to initialize inotify for shader hot reload";
+			return false;
+		}
+		m_WatchThread = std::thread([this]() { WatchLoop(); });
+		return true;
+#else
+		if (error) *error = "gvk : shader hot reload is only supported on linux";
+		return false;
+#endif
+	}
+
+	void ShaderHotReloader::Stop()
+	{
+		m_Stop = true;
+		if (m_WatchThread.joinable())
+		{
+			m_WatchThread.join();
+		}
+#ifdef __linux__
+		if (m_Notify >= 0)
+		{
+			close(m_Notify);
+			m_Notify = -1;
+		}
+#endif
+	}
+
+	void ShaderHotReloader::WatchShader(const ptr<Shader>& shader, const char* file, const ShaderMacros& macros,
+		const char** include_directories, uint32 include_directory_count,
+		const char** search_pathes, uint32 search_path_count)
+	{
+		ptr<WatchedShader> watched = std::make_shared<WatchedShader>();
+		watched->versions.push_back(shader);
+		watched->file = file;
+		for (uint32 i = 0; i < macros.name.size(); i++)
+		{
+			watched->macro_names.push_back(macros.name[i]);
+			watched->macro_values.push_back(macros.value[i] != nullptr ? opt<std::string>(macros.value[i]) : std::nullopt);
+		}
+		watched->include_directories.assign(include_directories, include_directories + include_directory_count);
+		watched->search_pathes.assign(search_pathes, search_pathes + search_path_count);
+		watched->source_files = shader->GetSourceFiles();
+
+		for (auto& source : watched->source_files)
+		{
+			WatchDirectory(fs::path(source).parent_path().string());
+		}
+
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Shaders.erase(std::remove_if(m_Shaders.begin(), m_Shaders.end(),
+			[](const ptr<WatchedShader>& shader) { return IsExpired(*shader); }), m_Shaders.end());
+		m_Shaders.push_back(watched);
+	}
+
+	void ShaderHotReloader::TrackPipeline(const ptr<Pipeline>& pipeline, const GvkGraphicsPipelineCreateInfo& info)
+	{
+		if (g_reloading) return;
+		TrackedPipeline tracked;
+		tracked.pipeline = pipeline;
+		tracked.graphics = info;
+
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pipelines.erase(std::remove_if(m_Pipelines.begin(), m_Pipelines.end(),
+			[](const TrackedPipeline& pipeline) { return pipeline.pipeline.expired(); }), m_Pipelines.end());
+		m_Pipelines.push_back(std::move(tracked));
+	}
+
+	void ShaderHotReloader::TrackPipeline(const ptr<Pipeline>& pipeline, const GvkComputePipelineCreateInfo& info)
+	{
+		if (g_reloading) return;
+		TrackedPipeline tracked;
+		tracked.pipeline = pipeline;
+		tracked.compute = info;
+
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Pipelines.erase(std::remove_if(m_Pipelines.begin(), m_Pipelines.end(),
+			[](const TrackedPipeline& pipeline) { return pipeline.pipeline.expired(); }), m_Pipelines.end());
+		m_Pipelines.push_back(std::move(tracked));
+	}
+
+	void ShaderHotReloader::ApplyPendingSwaps()
+	{
+		std::vector<PendingSwap> swaps;
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			swaps.swap(m_PendingSwaps);
+		}
+		std::vector<PendingSwap> applied;
+		for (auto& swap : swaps)
+		{
+			auto target = swap.target.lock();
+			if (target == nullptr) continue;
+			target->Swap(*swap.replacement);
+
+			//the tracked create info follows the live pipeline,later reloads start from it
+			std::lock_guard<std::mutex> lock(m_Lock);
+			for (auto& tracked : m_Pipelines)
+			{
+				if (tracked.pipeline.lock() == target)
+				{
+					tracked.graphics = swap.tracked.graphics;
+					tracked.compute = swap.tracked.compute;
+				}
+			}
+			applied.push_back(std::move(swap));
+		}
+		//the replacements hold the old vulkan objects now,they are kept until the swaps are polled
+		std::lock_guard<std::mutex> lock(m_Lock);
+		for (auto& swap : applied)
+		{
+			m_AppliedSwaps.push_back(std::move(swap));
+		}
+	}
+
+	std::vector<ptr<Pipeline>> ShaderHotReloader::PollSwaps()
+	{
+		std::vector<PendingSwap> swaps;
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			swaps.swap(m_AppliedSwaps);
+		}
+		std::vector<ptr<Pipeline>> pipelines;
+		for (auto& swap : swaps)
+		{
+			auto target = swap.target.lock();
+			if (target != nullptr && std::find(pipelines.begin(), pipelines.end(), target) == pipelines.end())
+			{
+				pipelines.push_back(target);
+			}
+		}
+		//dropping the replacements hands the old objects to the release queue,
+		//so they are destroyed after the commands submitted with them have finished
+		swaps.clear();
+		return pipelines;
+	}
+
+	std::vector<std::string> ShaderHotReloader::PollErrors()
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		std::vector<std::string> errors;
+		errors.swap(m_Errors);
+		return errors;
+	}
+
+	void ShaderHotReloader::ReportError(const std::string& error)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		m_Errors.push_back(error);
+	}
+
+	void ShaderHotReloader::WatchDirectory(const std::string& directory)
+	{
+#ifdef __linux__
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if (m_Notify < 0 || m_WatchedDirectorySet.count(directory))
+		{
+			return;
+		}
+		//editors often save by writing a new file and renaming it,so the directory is watched instead of the file
+		int wd = inotify_add_watch(m_Notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd < 0)
+		{
+			return;
+		}
+		m_WatchedDirectories[wd] = directory;
+		m_WatchedDirectorySet.insert(directory);
+#endif
+	}
+
+	void ShaderHotReloader::WatchLoop()
+	{
+#ifdef __linux__
+		std::unordered_set<std::string> changed_files;
+		while (!m_Stop)
+		{
+			pollfd fd{ m_Notify, POLLIN, 0 };
+			int rs = poll(&fd, 1, 100);
+			if (rs > 0 && (fd.revents & POLLIN))
+			{
+				alignas(inotify_event) char buffer[4096];
+				ssize_t length;
+				while ((length = read(m_Notify, buffer, sizeof(buffer))) > 0)
+				{
+					std::lock_guard<std::mutex> lock(m_Lock);
+					for (char* iter = buffer; iter < buffer + length;)
+					{
+						inotify_event* event = (inotify_event*)iter;
+						//binaries,reflections and temporary files written beside the sources by the compiler are not sources
+						std::string extension = event->len > 0 ? fs::path(event->name).extension().string() : "";
+						bool compiler_output = extension == ".spv" || extension == ".refl" || extension == ".tmp";
+						if (event->len > 0 && !compiler_output && m_WatchedDirectories.count(event->wd))
+						{
+							changed_files.insert((fs::path(m_WatchedDirectories[event->wd]) / event->name).lexically_normal().string());
+						}
+						iter += sizeof(inotify_event) + event->len;
+					}
+				}
+			}
+			//a save usually produces several events,reload after they have settled
+			else if (!changed_files.empty())
+			{
+				m_Context->SubmitJob([this, changed_files]() { Reload(changed_files); });
+				changed_files.clear();
+			}
+		}
+#endif
+	}
+
+	void ShaderHotReloader::Reload(const std::unordered_set<std::string>& changed_files)
+	{
+		std::lock_guard<std::mutex> reload_lock(m_ReloadLock);
+
+		std::vector<ptr<WatchedShader>> affected;
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			for (auto& watched : m_Shaders)
+			{
+				if (IsExpired(*watched)) continue;
+				for (auto& source : watched->source_files)
+				{
+					if (changed_files.count(source))
+					{
+						affected.push_back(watched);
+						break;
+					}
+				}
+			}
+		}
+		if (affected.empty())
+		{
+			return;
+		}
+
+		//recompile the shaders,a shader failing to compile keeps its old version.
+		//every live version of a recompiled shader is replaced,pipelines may hold different versions
+		std::unordered_map<Shader*, ptr<Shader>> replaced;
+		std::vector<ptr<Shader>> old_versions;
+		for (auto& watched : affected)
+		{
+			ShaderMacros macros;
+			for (uint32 i = 0; i < watched->macro_names.size(); i++)
+			{
+				macros.D(watched->macro_names[i].c_str(), watched->macro_values[i].has_value() ? watched->macro_values[i]->c_str() : nullptr);
+			}
+			std::vector<const char*> include_directories, search_pathes;
+			for (auto& directory : watched->include_directories) include_directories.push_back(directory.c_str());
+			for (auto& path : watched->search_pathes) search_pathes.push_back(path.c_str());
+
+			std::string error;
+			auto shader = Shader::Compile(watched->file.c_str(), macros, include_directories.data(), include_directories.size(),
+				search_pathes.data(), search_pathes.size(), &error);
+			if (!shader.has_value() || !shader.value()->CreateShaderModule(m_Context->GetDevice()).has_value())
+			{
+				ReportError("gvk : fail to reload shader " + watched->file + "\n" + error);
+				continue;
+			}
+
+			for (auto& source : shader.value()->GetSourceFiles())
+			{
+				WatchDirectory(fs::path(source).parent_path().string());
+			}
+			std::lock_guard<std::mutex> lock(m_Lock);
+			for (auto& version : watched->versions)
+			{
+				if (auto old_shader = version.lock())
+				{
+					replaced[old_shader.get()] = shader.value();
+					old_versions.push_back(old_shader);
+				}
+			}
+			//the new version lives as long as a pipeline using it is swapped in
+			watched->versions.erase(std::remove_if(watched->versions.begin(), watched->versions.end(),
+				[](const std::weak_ptr<Shader>& version) { return version.expired(); }), watched->versions.end());
+			watched->versions.push_back(shader.value());
+			watched->source_files = shader.value()->GetSourceFiles();
+		}
+		if (replaced.empty())
+		{
+			return;
+		}
+
+		auto replace = [&](ptr<Shader>& shader)
+		{
+			if (shader == nullptr) return false;
+			auto iter = replaced.find(shader.get());
+			if (iter == replaced.end()) return false;
+			shader = iter->second;
+			return true;
+		};
+
+		//build the create infos of the pipelines using the shaders on copies,
+		//the tracked infos are only updated when the rebuilt pipelines are swapped in
+		std::vector<TrackedPipeline> rebuilt;
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			for (auto& tracked : m_Pipelines)
+			{
+				auto target = tracked.pipeline.lock();
+				if (target == nullptr) continue;
+				//a swap not applied yet carries the newest create info of the pipeline
+				TrackedPipeline copy = tracked;
+				for (auto& swap : m_PendingSwaps)
+				{
+					if (swap.target.lock() == target) copy = swap.tracked;
+				}
+				bool changed = false;
+				if (copy.graphics.has_value())
+				{
+					auto& info = copy.graphics.value();
+					changed |= replace(info.vertex_shader);
+					changed |= replace(info.geometry_shader);
+					changed |= replace(info.fragment_shader);
+					changed |= replace(info.task_shader);
+					changed |= replace(info.mesh_shader);
+				}
+				if (copy.compute.has_value())
+				{
+					changed |= replace(copy.compute.value().shader);
+				}
+				if (changed) rebuilt.push_back(std::move(copy));
+			}
+		}
+
+		g_reloading = true;
+		for (auto& tracked : rebuilt)
+		{
+			opt<ptr<Pipeline>> pipeline = tracked.graphics.has_value() ?
+				m_Context->CreateGraphicsPipeline(tracked.graphics.value()) :
+				m_Context->CreateComputePipeline(tracked.compute.value());
+			if (!pipeline.has_value())
+			{
+				ReportError("gvk : fail to rebuild pipeline after reloading shaders");
+				continue;
+			}
+			//pipeline layouts are cached,an unchanged layout is the same vulkan object
+			auto target = tracked.pipeline.lock();
+			if (target == nullptr) continue;
+			if (target->GetPipelineLayout() != pipeline.value()->GetPipelineLayout())
+			{
+				ReportError("gvk : the descriptor or push constant layout of a pipeline changed after reloading shaders,"
+					"the pipeline is not swapped,create it again to use the new layout");
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_PendingSwaps.push_back(PendingSwap{ tracked.pipeline, pipeline.value(), std::move(tracked) });
+		}
+		g_reloading = false;
+	}
+}
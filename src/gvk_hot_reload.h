@@ -0,0 +1,96 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_shader.h"
+#include "gvk_pipeline.h"
+#include <thread>
+#include <mutex>
+#include <unordered_set>
+
+namespace gvk {
+	class Context;
+
+	//watches the source files of shaders compiled by Context::CompileShader.
+	//when a source or an included file changes,the shaders depending on it are recompiled on worker threads
+	//and every pipeline created from them is rebuilt.
+	//rebuilt pipelines are swapped in by Context::Present,the vulkan pipeline of a swapped Pipeline object changes.
+	//command buffers recorded with the old vulkan pipeline stay valid until the swap is acknowledged by
+	//Context::PollShaderReloadSwaps,which hands the old objects to the release queue.
+	//so every command buffer that recorded a swapped pipeline must be recorded again before it is submitted after the poll.
+	//a pipeline whose pipeline layout changed is not swapped,prerecorded commands and descriptor sets depend on it.
+	//create infos of tracked pipelines only change when the rebuilt pipeline is swapped in
+	class ShaderHotReloader {
+		friend class Context;
+	public:
+		~ShaderHotReloader();
+	private:
+		ShaderHotReloader(Context* context);
+
+		bool Start(std::string* error);
+		void Stop();
+
+		void WatchShader(const ptr<Shader>& shader, const char* file, const ShaderMacros& macros,
+			const char** include_directories, uint32 include_directory_count,
+			const char** search_pathes, uint32 search_path_count);
+		void TrackPipeline(const ptr<Pipeline>& pipeline, const GvkGraphicsPipelineCreateInfo& info);
+		void TrackPipeline(const ptr<Pipeline>& pipeline, const GvkComputePipelineCreateInfo& info);
+
+		//called at frame boundaries
+		void ApplyPendingSwaps();
+		//pipelines swapped since the last call,their old vulkan objects are released
+		std::vector<ptr<Pipeline>> PollSwaps();
+		//errors of the reloads since the last call
+		std::vector<std::string> PollErrors();
+		void ReportError(const std::string& error);
+
+		void WatchDirectory(const std::string& directory);
+		void WatchLoop();
+		void Reload(const std::unordered_set<std::string>& changed_files);
+
+		struct WatchedShader {
+			//every version compiled from the source,the versions in use are held by the create infos of tracked pipelines
+			std::vector<std::weak_ptr<Shader>> versions;
+			std::string				 file;
+			std::vector<std::string> macro_names;
+			std::vector<opt<std::string>> macro_values;
+			std::vector<std::string> include_directories;
+			std::vector<std::string> search_pathes;
+			std::vector<std::string> source_files;
+		};
+
+		struct TrackedPipeline {
+			std::weak_ptr<Pipeline>				pipeline;
+			//the shaders of the live pipeline are held here
+			opt<GvkGraphicsPipelineCreateInfo>	graphics;
+			opt<GvkComputePipelineCreateInfo>	compute;
+		};
+
+		struct PendingSwap {
+			std::weak_ptr<Pipeline> target;
+			//holds the old vulkan objects after the swap
+			ptr<Pipeline>			replacement;
+			//committed to the tracked pipeline when the swap is applied
+			TrackedPipeline			tracked;
+		};
+
+		static bool IsExpired(const WatchedShader& shader);
+
+		Context*					 m_Context;
+
+		std::mutex					 m_Lock;
+		std::vector<ptr<WatchedShader>> m_Shaders;
+		std::vector<TrackedPipeline> m_Pipelines;
+		std::vector<PendingSwap>	 m_PendingSwaps;
+		//swaps applied but not polled,the old vulkan objects are kept alive for prerecorded command buffers
+		std::vector<PendingSwap>	 m_AppliedSwaps;
+		std::vector<std::string>	 m_Errors;
+		std::unordered_map<int, std::string> m_WatchedDirectories;
+		std::unordered_set<std::string>		 m_WatchedDirectorySet;
+
+		//reloads are processed one at a time in the order of the changes
+		std::mutex					 m_ReloadLock;
+
+		int							 m_Notify = -1;
+		std::thread					 m_WatchThread;
+		std::atomic<bool>			 m_Stop{ false };
+	};
+}
@@ -0,0 +1,220 @@
+#include "gvk_job.h"
+
+namespace gvk {
+
+	//the pool and the index of the worker running on this thread
+	static thread_local ThreadPool* g_current_pool = nullptr;
+	static thread_local uint32		g_worker_index = 0;
+
+	void JobCounter::Add()
+	{
+		m_Value++;
+	}
+
+	std::vector<std::function<void()>> JobCounter::Finish()
+	{
+		std::vector<std::function<void()>> continuations;
+		if (--m_Value == 0)
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			//the value may be increased again by other threads
+			if (m_Value == 0)
+			{
+				continuations.swap(m_Continuations);
+			}
+			m_Condition.notify_all();
+		}
+		return continuations;
+	}
+
+	bool JobCounter::AddContinuation(std::function<void()>& task)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if (m_Value == 0)
+		{
+			return false;
+		}
+		m_Continuations.push_back(std::move(task));
+		return true;
+	}
+
+	void JobCounter::WaitFor(std::chrono::microseconds duration)
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_Condition.wait_for(lock, duration, [this]() { return m_Value == 0; });
+	}
+
+	ThreadPool::ThreadPool(uint32 thread_count)
+		:m_Stop(false)
+	{
+		if (thread_count == 0)
+		{
+			//leave one core to the thread submitting tasks
+			uint32 hardware_threads = std::thread::hardware_concurrency();
+			thread_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+		}
+
+		//every deque exists before any worker starts stealing
+		for (uint32 i = 0; i < thread_count; i++)
+		{
+			m_Workers.push_back(std::make_shared<Worker>());
+		}
+		for (uint32 i = 0; i < thread_count; i++)
+		{
+			m_Threads.emplace_back([this, i]() { WorkerLoop(i); });
+		}
+	}
+
+	void ThreadPool::Wait(JobCounter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (!RunPendingTask())
+			{
+				counter.WaitFor(idle_wait);
+			}
+		}
+	}
+
+	bool ThreadPool::RunPendingTask()
+	{
+		std::function<void()> task;
+		if (!TakeTask(task))
+		{
+			return false;
+		}
+		task();
+		return true;
+	}
+
+	opt<uint32> ThreadPool::GetWorkerIndex()
+	{
+		if (g_current_pool != this)
+		{
+			return std::nullopt;
+		}
+		return g_worker_index;
+	}
+
+	uint32 ThreadPool::GetThreadCount()
+	{
+		return m_Threads.size();
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Stop = true;
+		}
+		m_Condition.notify_all();
+		//tasks already submitted are finished before the workers exit
+		for (auto& thread : m_Threads)
+		{
+			thread.join();
+		}
+	}
+
+	void ThreadPool::Push(std::function<void()> task)
+	{
+		//counted before it is visible,so the count never drops below the tasks taken
+		m_PendingCount++;
+		if (g_current_pool == this)
+		{
+			//tasks spawned by a worker are likely to use the data it just touched
+			Worker& worker = *m_Workers[g_worker_index];
+			std::lock_guard<std::mutex> lock(worker.lock);
+			worker.tasks.push_back(std::move(task));
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			m_Tasks.push_back(std::move(task));
+		}
+		{
+			//a worker checking the count before it sleeps holds the lock
+			std::lock_guard<std::mutex> lock(m_Lock);
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::Finish(JobCounter& counter)
+	{
+		for (auto& continuation : counter.Finish())
+		{
+			Push(std::move(continuation));
+		}
+	}
+
+	bool ThreadPool::TakeTask(std::function<void()>& task)
+	{
+		if (m_PendingCount == 0)
+		{
+			return false;
+		}
+
+		bool found = false;
+		uint32 worker_count = m_Workers.size();
+		uint32 first_victim = 0;
+		if (g_current_pool == this)
+		{
+			//the newest task of the worker's own deque
+			Worker& worker = *m_Workers[g_worker_index];
+			std::lock_guard<std::mutex> lock(worker.lock);
+			if (!worker.tasks.empty())
+			{
+				task = std::move(worker.tasks.back());
+				worker.tasks.pop_back();
+				found = true;
+			}
+			first_victim = g_worker_index + 1;
+		}
+		if (!found)
+		{
+			std::lock_guard<std::mutex> lock(m_Lock);
+			if (!m_Tasks.empty())
+			{
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop_front();
+				found = true;
+			}
+		}
+		//steal the oldest task of another worker
+		for (uint32 i = 0; !found && i < worker_count; i++)
+		{
+			Worker& victim = *m_Workers[(first_victim + i) % worker_count];
+			std::lock_guard<std::mutex> lock(victim.lock);
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				found = true;
+			}
+		}
+
+		if (found)
+		{
+			m_PendingCount--;
+		}
+		return found;
+	}
+
+	void ThreadPool::WorkerLoop(uint32 index)
+	{
+		g_current_pool = this;
+		g_worker_index = index;
+		while (true)
+		{
+			if (RunPendingTask())
+			{
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(m_Lock);
+			m_Condition.wait(lock, [this]() { return m_Stop || m_PendingCount != 0; });
+			if (m_Stop && m_PendingCount == 0)
+			{
+				return;
+			}
+		}
+	}
+}
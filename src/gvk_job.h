@@ -0,0 +1,154 @@
+#pragma once
+#include "gvk_common.h"
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+
+namespace gvk {
+
+	//counts the unfinished tasks submitted with it.
+	//tasks can be submitted to start after a counter drops to zero,which expresses dependencies between tasks
+	class JobCounter
+	{
+		friend class ThreadPool;
+	public:
+		bool	IsDone() const { return m_Value == 0; }
+		uint32	GetValue() const { return m_Value; }
+
+	private:
+		void	Add();
+		//returns the tasks waiting for the counter if it drops to zero
+		std::vector<std::function<void()>> Finish();
+		//returns false if the counter is zero and the task can start now
+		bool	AddContinuation(std::function<void()>& task);
+		void	WaitFor(std::chrono::microseconds duration);
+
+		std::atomic<uint32>					m_Value{ 0 };
+		std::mutex							m_Lock;
+		std::condition_variable				m_Condition;
+		std::vector<std::function<void()>>	m_Continuations;
+	};
+
+	//work-stealing worker threads shared by the subsystems of the library (pipeline creation, shader compilation,recording...)
+	//every worker owns a deque,tasks submitted by a worker are pushed to its own deque and run last in first out,
+	//tasks submitted by other threads go to a shared queue.idle workers steal the oldest tasks of the other workers.
+	//threads waiting for tasks should use Wait,which runs queued tasks instead of blocking,
+	//so tasks can wait for their subtasks without deadlocking the pool
+	class ThreadPool
+	{
+	public:
+		/// <summary>
+		/// Create a thread pool
+		/// </summary>
+		/// <param name="thread_count">count of worker threads,if it is 0 the count is decided by the hardware concurrency</param>
+		ThreadPool(uint32 thread_count = 0);
+
+		/// <summary>
+		/// Submit a task to worker threads
+		/// </summary>
+		/// <param name="task">the task to execute</param>
+		/// <returns>the future of the task's result</returns>
+		template<typename F>
+		auto Submit(F&& task) -> std::future<decltype(task())>
+		{
+			return Submit(std::forward<F>(task), nullptr);
+		}
+
+		/// <summary>
+		/// Submit a task counted by a counter,optionally starting after another counter drops to zero
+		/// </summary>
+		/// <param name="task">the task to execute</param>
+		/// <param name="counter">increased now and decreased after the task finishes,can be null</param>
+		/// <param name="dependency">the task starts after it drops to zero,can be null</param>
+		/// <returns>the future of the task's result</returns>
+		template<typename F>
+		auto Submit(F&& task, const ptr<JobCounter>& counter, const ptr<JobCounter>& dependency = nullptr) -> std::future<decltype(task())>
+		{
+			using R = decltype(task());
+			//std::function requires copyable objects,std::packaged_task is move only
+			auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+			std::future<R> future = packaged->get_future();
+			if (counter != nullptr)
+			{
+				counter->Add();
+			}
+			std::function<void()> job = [this, packaged, counter]()
+			{
+				(*packaged)();
+				if (counter != nullptr)
+				{
+					Finish(*counter);
+				}
+			};
+			if (dependency == nullptr || !dependency->AddContinuation(job))
+			{
+				Push(std::move(job));
+			}
+			return future;
+		}
+
+		/// <summary>
+		/// Wait for a counter to drop to zero,running queued tasks on the calling thread meanwhile
+		/// </summary>
+		void	Wait(JobCounter& counter);
+
+		/// <summary>
+		/// Wait for the result of a task,running queued tasks on the calling thread meanwhile
+		/// </summary>
+		template<typename T>
+		void	Wait(const std::future<T>& future)
+		{
+			while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				if (!RunPendingTask())
+				{
+					future.wait_for(idle_wait);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Run one queued task on the calling thread
+		/// </summary>
+		/// <returns>if a task is run</returns>
+		bool	RunPendingTask();
+
+		/// <summary>
+		/// Get the index of the calling thread in the worker threads
+		/// </summary>
+		/// <returns>index of the worker,nullopt if the calling thread is not a worker of this pool</returns>
+		opt<uint32> GetWorkerIndex();
+
+		uint32	GetThreadCount();
+
+		~ThreadPool();
+	private:
+		//waiting threads check for new tasks at this interval
+		static constexpr std::chrono::microseconds idle_wait{ 100 };
+
+		struct Worker
+		{
+			std::deque<std::function<void()>> tasks;
+			std::mutex						  lock;
+		};
+
+		void Push(std::function<void()> task);
+		void Finish(JobCounter& counter);
+		bool TakeTask(std::function<void()>& task);
+		void WorkerLoop(uint32 index);
+
+		std::vector<std::thread>			m_Threads;
+		std::vector<ptr<Worker>>			m_Workers;
+		//tasks submitted by threads not in the pool
+		std::deque<std::function<void()>>	m_Tasks;
+		std::mutex							m_Lock;
+		std::condition_variable				m_Condition;
+		//count of tasks in the queues,workers sleep if it is zero
+		std::atomic<uint32>					m_PendingCount{ 0 };
+		bool								m_Stop;
+	};
+}
@@ -1,8 +1,11 @@
 #include "gvk_pipeline.h"
 #include "gvk_context.h"
 #include "gvk_raytracing.h"
+#include "gvk_bindless.h"
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
 
 
 namespace gvk {
@@ -18,7 +21,8 @@ namespace gvk {
 
 		//descriptor set layouts
 		std::vector<std::vector<ptr<Shader>>>	descriptor_layout_shaders;
-		std::vector<VkDescriptorSetLayout>		descriptor_layouts;
+		//layouts of every set slot,holes are filled by nullptr and replaced with the dummy layout
+		std::vector<ptr<DescriptorSetLayout>>	descriptor_layouts;
 		//a bit map check whether the precluded descriptor layouts is included to descriptor layouts for pipeline creation
 		std::vector<bool> layout_included;
 		std::vector<ptr<DescriptorSetLayout>> internal_layout;
@@ -34,30 +38,42 @@ namespace gvk {
 		{
 			if (shader == nullptr) return false;
 
-			std::vector<SpvReflectDescriptorSet*> sets;
-			if (auto v = shader->GetDescriptorSets(); v.has_value())
-			{
-				sets = std::move(v.value());
-			}
-			else
-			{
-				return false;
-			}
+			View<ShaderDescriptorSet> sets = shader->GetDescriptorSets();
 
 			// find largest descriptor set
 			uint32_t lastDescriptorSet = descriptor_layouts.size();
-			for (auto set : sets)
+			for (auto& set : sets)
 			{
-				lastDescriptorSet = lastDescriptorSet > (set->set + 1) ? lastDescriptorSet : (set->set + 1);
+				lastDescriptorSet = lastDescriptorSet > (set.set + 1) ? lastDescriptorSet : (set.set + 1);
+			}
+			for (auto& fixed : hint.fixed_descriptor_layouts)
+			{
+				lastDescriptorSet = lastDescriptorSet > (fixed.first + 1) ? lastDescriptorSet : (fixed.first + 1);
 			}
 			// fill the holes by dummy descriptor sets
-			descriptor_layouts.resize(lastDescriptorSet, context.GetDummyDescriptorSetLayout());
+			descriptor_layouts.resize(lastDescriptorSet, nullptr);
 			descriptor_layout_shaders.resize(lastDescriptorSet, {});
 			internal_layout.resize(lastDescriptorSet, nullptr);
 
+			//fixed layouts are in the pipeline layout even if the shader doesn't use their sets,
+			//e.g. BindlessHeap::Bind binds every heap whichever of them the shader reads
+			for (auto& fixed : hint.fixed_descriptor_layouts)
+			{
+				descriptor_layouts[fixed.first] = fixed.second;
+			}
+
 			//collect descriptor set layout information
-			for (auto set : sets)
+			for (auto& descriptor_set : sets)
 			{
+				const ShaderDescriptorSet* set = &descriptor_set;
+				auto fixed = std::find_if(hint.fixed_descriptor_layouts.begin(), hint.fixed_descriptor_layouts.end(),
+					[&](const std::pair<uint32_t, ptr<DescriptorSetLayout>>& layout) { return layout.first == set->set; });
+				if (fixed != hint.fixed_descriptor_layouts.end())
+				{
+					descriptor_layouts[set->set] = fixed->second;
+					continue;
+				}
+
 				bool is_layout_precluded = false;
 				for (uint32 i = 0; i < layout_included.size(); i++)
 				{
@@ -68,7 +84,7 @@ namespace gvk {
 						//this layout is not included in layout list
 						if (!layout_included[i])
 						{
-							descriptor_layouts[set->set] = layout->GetLayout();
+							descriptor_layouts[set->set] = layout;
 							layout_included[i] = true;
 							is_layout_precluded = true;
 							break;
@@ -79,7 +95,7 @@ namespace gvk {
 				{
 					if (!descriptor_layout_shaders[set->set].empty())
 					{
-						descriptor_layouts[set->set] = NULL;
+						descriptor_layouts[set->set] = nullptr;
 						internal_layout[set->set] = nullptr;
 					}
 					descriptor_layout_shaders[set->set].push_back(shader);
@@ -90,37 +106,28 @@ namespace gvk {
 					gvk_assert(opt_layout.has_value());
 					internal_layout[set->set] = opt_layout.value();
 
-					descriptor_layouts[set->set] = opt_layout.value()->GetLayout();
+					descriptor_layouts[set->set] = opt_layout.value();
 				}
 			}
 
 			//collect push constant information
-			std::vector<SpvReflectBlockVariable*> push_constants;
-			if (auto v = shader->GetPushConstants(); v.has_value())
-			{
-				push_constants = std::move(v.value());
-			}
-			else
-			{
-				return false;
-			}
+			View<ShaderPushConstant> push_constants = shader->GetPushConstants();
 
 			//if the shader has push constant
 			if (!push_constants.empty())
 			{
 				//in glsl only one push_constant block is supported
-				auto push_constant = push_constants[0];
+				const ShaderPushConstant* push_constant = &push_constants[0];
 
-				for (uint32 i = 0; i < push_constant->member_count; i++)
+				for (auto& member : push_constant->Members())
 				{
-					auto member = push_constant->members[i];
-					if (!push_constant_table.count(member.name))
+					if (!push_constant_table.count(member.Name()))
 					{
-						push_constant_table[member.name] = { VkPushConstantRange{ (VkShaderStageFlags)shader->GetStage(),member.offset,member.size } };
+						push_constant_table[member.Name()] = { VkPushConstantRange{ (VkShaderStageFlags)shader->GetStage(),member.offset,member.size } };
 					}
 					else
 					{
-						auto& push_constant = push_constant_table[member.name];
+						auto& push_constant = push_constant_table[member.Name()];
 						//variables with the same name in different push constants should be consistent to each other
 						if (member.offset == push_constant.offset && member.size == push_constant.size)
 						{
@@ -161,16 +168,37 @@ namespace gvk {
 	};
 
 	
-	DescriptorSetLayout::DescriptorSetLayout(VkDescriptorSetLayout layout, const std::vector<ptr<gvk::Shader>>& shaders,
-		const std::vector<SpvReflectDescriptorBinding*>& descriptor_set_bindings, uint32 sets,VkDevice device,
-		uint32_t maxBindlessBindingCount, bool isBindless):
-	m_Shader(shaders),m_DescriptorSetBindings(descriptor_set_bindings),m_Set(sets),m_Layout(layout) ,m_Device(device),m_ShaderStages(0)
-	,m_MaxBindlessBindingCount(maxBindlessBindingCount), m_IsBindless(isBindless)
+	SharedDescriptorSetLayout::~SharedDescriptorSetLayout()
+	{
+		vkDestroyDescriptorSetLayout(device, layout, nullptr);
+	}
+
+	SharedPipelineLayout::~SharedPipelineLayout()
+	{
+		vkDestroyPipelineLayout(device, layout, nullptr);
+	}
+
+	DescriptorSetLayout::DescriptorSetLayout(const ptr<SharedDescriptorSetLayout>& layout, const std::vector<ptr<gvk::Shader>>& shaders,
+		const std::vector<const ShaderDescriptorBinding*>& descriptor_set_bindings, uint32 sets,VkDevice device,
+		uint32_t maxBindlessBindingCount, bool isBindless, bool isPushDescriptor, const std::vector<uint32_t>& dynamic_bindings):
+	m_Shader(shaders),m_DescriptorSetBindings(descriptor_set_bindings),m_Set(sets),m_Layout(layout->layout),m_SharedLayout(layout),m_Device(device),m_ShaderStages(0)
+	,m_MaxBindlessBindingCount(maxBindlessBindingCount), m_IsBindless(isBindless), m_IsPushDescriptor(isPushDescriptor)
 	{
 		for (auto shader : shaders) 
 		{
 			m_ShaderStages |= shader->GetStage();
 		}
+		for (auto binding : descriptor_set_bindings)
+		{
+			VkDescriptorType type = (VkDescriptorType)binding->descriptor_type;
+			if (std::find(dynamic_bindings.begin(), dynamic_bindings.end(), binding->binding) != dynamic_bindings.end())
+			{
+				type = type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+				//every array element of a dynamic binding takes one offset
+				m_DynamicOffsetCount += binding->count;
+			}
+			m_DescriptorTypes.push_back(type);
+		}
 	}
 
 	uint32 DescriptorSetLayout::GetSetID()
@@ -183,9 +211,9 @@ namespace gvk {
 		return m_Layout;
 	}
 
-	View<SpvReflectDescriptorBinding*> DescriptorSetLayout::GetDescriptorSetBindings() 
+	View<const ShaderDescriptorBinding*> DescriptorSetLayout::GetDescriptorSetBindings() 
 	{
-		return View<SpvReflectDescriptorBinding*>(m_DescriptorSetBindings);
+		return View<const ShaderDescriptorBinding*>(m_DescriptorSetBindings);
 	}
 
 	VkShaderStageFlags DescriptorSetLayout::GetShaderStageBits()
@@ -203,9 +231,33 @@ namespace gvk {
 		return m_IsBindless;
 	}
 
+	bool DescriptorSetLayout::IsPushDescriptor()
+	{
+		return m_IsPushDescriptor;
+	}
+
+	VkDescriptorType DescriptorSetLayout::GetDescriptorType(uint32_t binding)
+	{
+		for (uint32 i = 0; i < m_DescriptorSetBindings.size(); i++)
+		{
+			if (m_DescriptorSetBindings[i]->binding == binding)
+			{
+				return m_DescriptorTypes[i];
+			}
+		}
+		gvk_assert(false);
+		return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	}
+
+	uint32_t DescriptorSetLayout::GetDynamicOffsetCount()
+	{
+		return m_DynamicOffsetCount;
+	}
+
 	DescriptorSetLayout::~DescriptorSetLayout()
 	{
-		vkDestroyDescriptorSetLayout(m_Device, m_Layout, nullptr);
+		//the vulkan layout is destroyed with the last shared reference
+		m_SharedLayout = nullptr;
 	}
 
 	bool DescriptorSetLayout::CreatedFromShader(const ptr<gvk::Shader>& _shader, uint32 set)
@@ -216,42 +268,34 @@ namespace gvk {
 		return false;
 	}
 
-	opt<ptr<DescriptorSetLayout>> Context::CreateDescriptorSetLayout(const std::vector<ptr<Shader>>& target_shaders, uint32 target_set,std::string* error, uint32_t max_bindless_descriptor_cnt)
+	opt<ptr<DescriptorSetLayout>> Context::CreateDescriptorSetLayout(const std::vector<ptr<Shader>>& target_shaders, uint32 target_set,std::string* error, uint32_t max_bindless_descriptor_cnt, bool push_descriptor,
+		const std::vector<uint32_t>& dynamic_bindings)
 	{
-		std::vector<SpvReflectDescriptorBinding*> bindings;
+		std::vector<const ShaderDescriptorBinding*> bindings;
 		std::vector<VkShaderStageFlags> binding_stage_flags;
 		for (auto& shader : target_shaders) {
-			SpvReflectDescriptorSet* matching_set;
-			if (auto v = shader->GetDescriptorSets(); v.has_value())
+			View<ShaderDescriptorSet> sets = shader->GetDescriptorSets();
+			auto find_res = std::find_if(sets.begin(), sets.end(), 
+				[&](const ShaderDescriptorSet& set) {
+					return set.set == target_set;
+				}
+			);
+			if (find_res == sets.end()) 
 			{
-				auto sets = std::move(v.value());
-				auto find_res = std::find_if(sets.begin(), sets.end(), 
-					[&](SpvReflectDescriptorSet* set) {
-						return set->set == target_set;
-					}
-				);
-				if (find_res == sets.end()) 
+				if (error) 
 				{
-					if (error) 
-					{
-						*error = "gvk : fail to create descriptor binding layout, in shader " + shader->Name() +
-							" set " + std::to_string(target_set) + " doesn't exists";
-					}
-					return std::nullopt;
+					*error = "gvk : fail to create descriptor binding layout, in shader " + shader->Name() +
+						" set " + std::to_string(target_set) + " doesn't exists";
 				}
-				matching_set = *find_res;
-			}
-			else 
-			{
-				if(error) *error = "gvk : fail to get descriptor set from shader " + shader->Name();
 				return std::nullopt;
 			}
+			const ShaderDescriptorSet* matching_set = find_res;
 			
 			for (uint32 i = 0; i < matching_set->binding_count;i++) 
 			{
-				SpvReflectDescriptorBinding* binding = matching_set->bindings[i];
+				const ShaderDescriptorBinding* binding = &matching_set->Bindings()[i];
 				auto res = std::find_if(bindings.begin(), bindings.end(),
-					[&](SpvReflectDescriptorBinding* set_binding) 
+					[&](const ShaderDescriptorBinding* set_binding) 
 					{
 						return binding->binding == set_binding->binding;
 					});
@@ -264,7 +308,7 @@ namespace gvk {
 				//descriptor format
 				else 
 				{
-					SpvReflectDescriptorBinding* set_binding = *res;
+					const ShaderDescriptorBinding* set_binding = *res;
 					//check if the shader's binding is compatible with existing bindings
 					if (set_binding->descriptor_type != binding->descriptor_type) 
 					{
@@ -287,10 +331,10 @@ namespace gvk {
 						return std::nullopt;
 					}
 					
-					bool array_dims_equal = set_binding->array.dims_count == binding->array.dims_count;
-					for (uint32 j = 0; j < set_binding->array.dims_count && array_dims_equal;j++) 
+					bool array_dims_equal = set_binding->array_dims_count == binding->array_dims_count;
+					for (uint32 j = 0; j < set_binding->array_dims_count && array_dims_equal;j++) 
 					{
-						array_dims_equal = set_binding->array.dims[j] == binding->array.dims[j];
+						array_dims_equal = set_binding->array_dims[j] == binding->array_dims[j];
 					}
 					if (!array_dims_equal) 
 					{
@@ -329,15 +373,47 @@ namespace gvk {
 			//TODO : currently we don't support immutable samplers
 			vk_bindings[i].pImmutableSamplers = NULL;
 			vk_bindings[i].stageFlags = binding_stage_flags[i];
+			if (std::find(dynamic_bindings.begin(), dynamic_bindings.end(), bindings[i]->binding) != dynamic_bindings.end())
+			{
+				if (bindings[i]->count == 0 || push_descriptor ||
+					(vk_bindings[i].descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && vk_bindings[i].descriptorType != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER))
+				{
+					if (error) *error = "gvk : fail to create descriptor layout at (set " + std::to_string(target_set) +
+						", binding " + std::to_string(bindings[i]->binding) + ") only uniform/storage buffers of fixed count can be dynamic "
+						"and push descriptors can't be dynamic";
+					return std::nullopt;
+				}
+				vk_bindings[i].descriptorType = vk_bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ?
+					VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+			}
+			if (m_DescriptorBufferEnabled && !push_descriptor &&
+				(vk_bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+				 vk_bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC))
+			{
+				if (error) *error = "gvk : fail to create descriptor layout at (set " + std::to_string(target_set) +
+					", binding " + std::to_string(bindings[i]->binding) + ") dynamic buffers can't be stored in descriptor buffers";
+				return std::nullopt;
+			}
 			if (bindings[i]->count != 0)
 			{
 				vk_bindings[i].descriptorCount = bindings[i]->count;
 			}
 			else
 			{
+				if (push_descriptor)
+				{
+					if (error) *error = "gvk : fail to create descriptor layout at (set " + std::to_string(target_set) +
+						", binding " + std::to_string(bindings[i]->binding) + ") bindless descriptors can't be pushed";
+					return std::nullopt;
+				}
 				vk_bindings[i].descriptorCount = max_bindless_descriptor_cnt;
-				info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
-				bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+				bindingFlags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT;
+				//descriptor buffers can be written at any time,update after bind only applies to descriptor pools
+				if (!m_DescriptorBufferEnabled)
+				{
+					info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+					bindingFlags[i] |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+				}
 				bindingFlagSet = true;
 			}
 		}
@@ -347,27 +423,398 @@ namespace gvk {
 		extFlagCI.pBindingFlags = bindingFlags.data();
 
 
+		if (push_descriptor)
+		{
+			info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+		}
+		else if (m_DescriptorBufferEnabled)
+		{
+			info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+		}
+
 		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		info.pNext = bindingFlagSet ? &extFlagCI : NULL;
 		info.pBindings = vk_bindings.data();
-		VkDescriptorSetLayout layout;
-		VkResult rs = vkCreateDescriptorSetLayout(m_Device, &info, nullptr, &layout);
-		if (rs != VK_SUCCESS)
+		auto layout = AcquireDescriptorSetLayout(info, bindingFlags);
+		if (!layout.has_value())
 		{
 			if (error) *error = "gvk : fail to create descriptor set layout";
 			return std::nullopt;
 		}
 
-		return ptr<DescriptorSetLayout>(new DescriptorSetLayout(layout, target_shaders, bindings, target_set,m_Device, max_bindless_descriptor_cnt, bindingFlagSet));
+		return ptr<DescriptorSetLayout>(new DescriptorSetLayout(layout.value(), target_shaders, bindings, target_set,m_Device, max_bindless_descriptor_cnt, bindingFlagSet, push_descriptor, dynamic_bindings));
 	}
 
+	template<typename T>
+	static void AppendKey(std::string& key, const T& value)
+	{
+		key.append((const char*)&value, sizeof(T));
+	}
 
-	opt<ptr<Pipeline>> Context::CreateGraphicsPipeline(const GvkGraphicsPipelineCreateInfo& info) {
- 		bool mesh_shader_enabled = info.mesh_shader != nullptr;
+	//find a live layout in a cache of weak references
+	template<typename T>
+	static ptr<T> FindCachedLayout(std::unordered_map<std::string, std::weak_ptr<T>>& cache, const std::string& key)
+	{
+		if (auto iter = cache.find(key); iter != cache.end())
+		{
+			return iter->second.lock();
+		}
+		return nullptr;
+	}
+
+	//expired entries are removed every time the cache doubles its size
+	template<typename T>
+	static void InsertCachedLayout(std::unordered_map<std::string, std::weak_ptr<T>>& cache, size_t& prune_size,
+		const std::string& key, const ptr<T>& layout)
+	{
+		cache[key] = layout;
+		if (cache.size() < prune_size)
+		{
+			return;
+		}
+		for (auto iter = cache.begin(); iter != cache.end();)
+		{
+			if (iter->second.expired()) iter = cache.erase(iter);
+			else iter++;
+		}
+		prune_size = std::max<size_t>(cache.size() * 2, 64);
+	}
+
+	opt<ptr<SharedDescriptorSetLayout>> Context::AcquireDescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo& info,
+		const std::vector<VkDescriptorBindingFlags>& binding_flags)
+	{
+		//bindings are normalized by their binding index,the order in shaders doesn't matter
+		std::vector<uint32> order(info.bindingCount);
+		for (uint32 i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](uint32 lhs, uint32 rhs)
+			{
+				return info.pBindings[lhs].binding < info.pBindings[rhs].binding;
+			});
+
+		std::string key;
+		AppendKey(key, info.flags);
+		for (uint32 i : order)
+		{
+			const VkDescriptorSetLayoutBinding& binding = info.pBindings[i];
+			AppendKey(key, binding.binding);
+			AppendKey(key, binding.descriptorType);
+			AppendKey(key, binding.descriptorCount);
+			AppendKey(key, binding.stageFlags);
+			AppendKey(key, i < binding_flags.size() ? binding_flags[i] : (VkDescriptorBindingFlags)0);
+		}
+
+		std::lock_guard<std::mutex> lock(m_LayoutCacheLock);
+		if (auto layout = FindCachedLayout(m_DescriptorSetLayoutCache, key); layout != nullptr)
+		{
+			return layout;
+		}
+
+		VkDescriptorSetLayout vk_layout;
+		if (vkCreateDescriptorSetLayout(m_Device, &info, nullptr, &vk_layout) != VK_SUCCESS)
+		{
+			return std::nullopt;
+		}
+		auto layout = std::make_shared<SharedDescriptorSetLayout>(vk_layout, m_Device);
+		InsertCachedLayout(m_DescriptorSetLayoutCache, m_DescriptorSetLayoutCachePruneSize, key, layout);
+		return layout;
+	}
+
+	opt<ptr<SharedPipelineLayout>> Context::AcquirePipelineLayout(const std::vector<ptr<DescriptorSetLayout>>& set_layouts,
+		const std::vector<VkPushConstantRange>& push_constant_ranges)
+	{
+		std::vector<VkDescriptorSetLayout> vk_set_layouts(set_layouts.size());
+		std::vector<ptr<SharedDescriptorSetLayout>> shared_set_layouts(set_layouts.size());
+		std::string key;
+		for (uint32 i = 0; i < set_layouts.size(); i++)
+		{
+			if (set_layouts[i] != nullptr)
+			{
+				vk_set_layouts[i] = set_layouts[i]->GetLayout();
+				shared_set_layouts[i] = set_layouts[i]->m_SharedLayout;
+			}
+			else
+			{
+				vk_set_layouts[i] = m_DummyDescriptorSetLayout;
+			}
+			AppendKey(key, (uint64_t)vk_set_layouts[i]);
+		}
+		for (auto& range : push_constant_ranges)
+		{
+			AppendKey(key, range.stageFlags);
+			AppendKey(key, range.offset);
+			AppendKey(key, range.size);
+		}
+
+		std::lock_guard<std::mutex> lock(m_LayoutCacheLock);
+		if (auto layout = FindCachedLayout(m_PipelineLayoutCache, key); layout != nullptr)
+		{
+			return layout;
+		}
+
+		VkPipelineLayoutCreateInfo info{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+		info.flags = 0;
+		info.setLayoutCount = vk_set_layouts.size();
+		info.pSetLayouts = vk_set_layouts.data();
+		info.pushConstantRangeCount = push_constant_ranges.size();
+		info.pPushConstantRanges = push_constant_ranges.data();
+
+		VkPipelineLayout vk_layout;
+		if (vkCreatePipelineLayout(m_Device, &info, nullptr, &vk_layout) != VK_SUCCESS)
+		{
+			return std::nullopt;
+		}
+		auto layout = std::make_shared<SharedPipelineLayout>(vk_layout, shared_set_layouts, m_Device);
+		InsertCachedLayout(m_PipelineLayoutCache, m_PipelineLayoutCachePruneSize, key, layout);
+		return layout;
+	}
+
+
+	//header written in front of the driver's pipeline cache data.
+	//vulkan's own cache header doesn't contain the driver version,but a driver update may change the binaries
+	struct PipelineCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendor_id;
+		uint32_t device_id;
+		uint32_t driver_version;
+		uint8_t  pipeline_cache_uuid[VK_UUID_SIZE];
+		uint64_t data_size;
+		uint64_t data_hash;
+	};
+
+	constexpr uint32_t pipeline_cache_file_magic = 0x43505647; //"GVPC"
+	constexpr uint32_t pipeline_cache_file_version = 1;
+
+	//return an empty array if the file doesn't exist or is not created from this device and driver
+	static std::vector<uint8_t> LoadPipelineCacheData(const std::string& file, const VkPhysicalDeviceProperties& props)
+	{
+		std::ifstream in(file, std::ios::binary);
+		if (!in.is_open())
+		{
+			return {};
+		}
+
+		PipelineCacheFileHeader header{};
+		if (!in.read((char*)&header, sizeof(header)))
+		{
+			return {};
+		}
+		if (header.magic != pipeline_cache_file_magic || header.version != pipeline_cache_file_version ||
+			header.vendor_id != props.vendorID || header.device_id != props.deviceID ||
+			header.driver_version != props.driverVersion ||
+			memcmp(header.pipeline_cache_uuid, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return {};
+		}
+
+		std::vector<uint8_t> data(header.data_size);
+		if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne) || !in.read((char*)data.data(), data.size()))
+		{
+			return {};
+		}
+		//the file may be truncated or modified
+		if (HashBytes(data.data(), data.size()) != header.data_hash)
+		{
+			return {};
+		}
+
+		//validate the driver's own header as well
+		VkPipelineCacheHeaderVersionOne vk_header;
+		memcpy(&vk_header, data.data(), sizeof(vk_header));
+		if (vk_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+			vk_header.vendorID != props.vendorID || vk_header.deviceID != props.deviceID ||
+			memcmp(vk_header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return {};
+		}
+
+		return data;
+	}
+
+	bool Context::InitializePipelineCache(const std::string& file, std::string* error)
+	{
+		m_PipelineCacheFile = file;
+
+		std::vector<uint8_t> initial_data;
+		if (!file.empty())
+		{
+			initial_data = LoadPipelineCacheData(file, m_DevicePropertiesFeature.DeviceProperties());
+		}
+
+		VkPipelineCacheCreateInfo info{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		info.initialDataSize = initial_data.size();
+		info.pInitialData = initial_data.empty() ? NULL : initial_data.data();
+
+		VkResult rs = vkCreatePipelineCache(m_Device, &info, nullptr, &m_PipelineCache);
+		if (rs != VK_SUCCESS && !initial_data.empty())
+		{
+			//driver refuses the data,start from an empty cache
+			info.initialDataSize = 0;
+			info.pInitialData = NULL;
+			rs = vkCreatePipelineCache(m_Device, &info, nullptr, &m_PipelineCache);
+		}
+		if (rs != VK_SUCCESS)
+		{
+			m_PipelineCache = NULL;
+			if (error) *error = "gvk : fail to create pipeline cache";
+			return false;
+		}
+		return true;
+	}
+
+	bool Context::SavePipelineCache(const char* file, std::string* error)
+	{
+		gvk_assert(m_PipelineCache != NULL);
+		std::string target = file != NULL ? file : m_PipelineCacheFile;
+		if (target.empty())
+		{
+			if (error) *error = "gvk : no file is specified for pipeline cache";
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(m_PipelineCacheSaveLock);
+		//pipelines created by other threads may grow the cache between the two queries
+		std::vector<uint8_t> data;
+		VkResult rs;
+		do
+		{
+			size_t data_size = 0;
+			if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &data_size, NULL) != VK_SUCCESS)
+			{
+				if (error) *error = "gvk : fail to get pipeline cache data";
+				return false;
+			}
+			data.resize(data_size);
+			rs = vkGetPipelineCacheData(m_Device, m_PipelineCache, &data_size, data.data());
+			data.resize(data_size);
+		} while (rs == VK_INCOMPLETE);
+		if (rs != VK_SUCCESS)
+		{
+			if (error) *error = "gvk : fail to get pipeline cache data";
+			return false;
+		}
+
+		const VkPhysicalDeviceProperties& props = m_DevicePropertiesFeature.DeviceProperties();
+		PipelineCacheFileHeader header{};
+		header.magic = pipeline_cache_file_magic;
+		header.version = pipeline_cache_file_version;
+		header.vendor_id = props.vendorID;
+		header.device_id = props.deviceID;
+		header.driver_version = props.driverVersion;
+		memcpy(header.pipeline_cache_uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+		header.data_size = data.size();
+		header.data_hash = HashBytes(data.data(), data.size());
+
+		//write to a temporary file and rename it to the target,
+		//the old cache stays intact if the process dies in the middle of writing
+		std::string temp_file = target + ".tmp";
+		{
+			std::ofstream out(temp_file, std::ios::binary | std::ios::trunc);
+			if (!out.is_open())
+			{
+				if (error) *error = "gvk : fail to open file " + temp_file;
+				return false;
+			}
+			out.write((const char*)&header, sizeof(header));
+			out.write((const char*)data.data(), data.size());
+			out.flush();
+			if (!out)
+			{
+				out.close();
+				std::error_code ec;
+				std::filesystem::remove(temp_file, ec);
+				if (error) *error = "gvk : fail to write pipeline cache to " + temp_file;
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(temp_file, target, ec);
+		if (ec)
+		{
+			std::filesystem::remove(temp_file, ec);
+			if (error) *error = "gvk : fail to replace pipeline cache file " + target;
+			return false;
+		}
+		return true;
+	}
+
+	VkPipelineCache Context::GetPipelineCache()
+	{
+		return m_PipelineCache;
+	}
+
+	GvkPipelineCacheStatistics Context::GetPipelineCacheStatistics()
+	{
+		GvkPipelineCacheStatistics statistics;
+		statistics.hit_count = m_PipelineCacheHitCount.load();
+		statistics.miss_count = m_PipelineCacheMissCount.load();
+		return statistics;
+	}
+
+	void Context::RecordPipelineCreationFeedback(const VkPipelineCreationFeedback& feedback)
+	{
+		//the driver may not provide the feedback
+		if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT))
+		{
+			return;
+		}
+		if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT)
+		{
+			m_PipelineCacheHitCount++;
+		}
+		else
+		{
+			m_PipelineCacheMissCount++;
+		}
+	}
+
+	//states referenced by VkGraphicsPipelineCreateInfo
+	//they must stay alive and unmoved until vkCreateGraphicsPipelines returns
+	struct GraphicsPipelineBuildState
+	{
+		GraphicsPipelineBuildState(const GvkGraphicsPipelineCreateInfo& info, Context& context)
+			:info(info), descriptor_helper(info.descriptor_layuot_hint, context, info.max_bindless_binding_count) {}
+
+		const GvkGraphicsPipelineCreateInfo& info;
+
+		VkGraphicsPipelineCreateInfo vk_create_info{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+		//By default we will set scissor and viewport as dynamic state
+		VkDynamicState dynamic_states[2] = {
+			VK_DYNAMIC_STATE_SCISSOR,
+			VK_DYNAMIC_STATE_VIEWPORT
+		};
+		VkPipelineDynamicStateCreateInfo dynamic_state_info{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+		VkPipelineViewportStateCreateInfo viewport_state{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		std::vector<VkVertexInputBindingDescription> bindings;
+		VkPipelineVertexInputStateCreateInfo vertex_input_state{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+
+		std::vector<VkPipelineShaderStageCreateInfo> shader_stage_infos;
+		std::vector<ptr<Shader>> stage_shaders;
+		std::vector<std::vector<VkSpecializationMapEntry>> specialization_entries;
+		std::vector<VkSpecializationInfo> specialization_infos;
+		DescriptorLayoutInfoHelper descriptor_helper;
+
+		VkPipelineCreationFeedback creation_feedback{};
+		VkPipelineCreationFeedbackCreateInfo feedback_info{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+
+		ptr<RenderPass> target_pass;
+		uint32 subpass_index = 0;
+		ptr<SharedPipelineLayout> pipeline_layout;
+	};
+
+	//fill the VkGraphicsPipelineCreateInfo in state except its pipeline layout
+	static bool PrepareGraphicsPipeline(Context& context, GraphicsPipelineBuildState& state, bool creation_feedback)
+	{
+		const GvkGraphicsPipelineCreateInfo& info = state.info;
+		VkGraphicsPipelineCreateInfo& vk_create_info = state.vk_create_info;
+
+		bool mesh_shader_enabled = info.mesh_shader != nullptr;
 		bool fragment_shader_enabled = info.fragment_shader != nullptr;
 		
-		VkGraphicsPipelineCreateInfo vk_create_info{};
-		vk_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		vk_create_info.pNext = NULL;
 		vk_create_info.pColorBlendState = &info.frame_buffer_blend_state.create_info;
 
@@ -382,49 +829,36 @@ namespace gvk {
 			vk_create_info.pDepthStencilState = NULL;
 		}
 
-		//By default we will set scissor and viewport as dynamic state
-		VkDynamicState dynamic_states[] = {
-			VK_DYNAMIC_STATE_SCISSOR,
-			VK_DYNAMIC_STATE_VIEWPORT
-		};
-		VkPipelineDynamicStateCreateInfo dynamic_state_info{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
-		dynamic_state_info.dynamicStateCount = gvk_count_of(dynamic_states);
-		dynamic_state_info.pDynamicStates = dynamic_states;
+		state.dynamic_state_info.dynamicStateCount = gvk_count_of(state.dynamic_states);
+		state.dynamic_state_info.pDynamicStates = state.dynamic_states;
 		
-		vk_create_info.pDynamicState = &dynamic_state_info;
+		vk_create_info.pDynamicState = &state.dynamic_state_info;
 		vk_create_info.pMultisampleState = &info.multi_sample_state;
 		vk_create_info.pRasterizationState = &info.rasterization_state;
 		vk_create_info.pInputAssemblyState = !mesh_shader_enabled ? &info.input_assembly_state : NULL;
 	
 		//view port state
-		VkPipelineViewportStateCreateInfo viewport_state{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-		viewport_state.scissorCount = 1;
-		viewport_state.viewportCount = 1;
-		vk_create_info.pViewportState = &viewport_state;
-
-		std::vector<SpvReflectInterfaceVariable*> vertex_input;
-		std::vector<VkVertexInputAttributeDescription> attributes;
-		
-		VkPipelineVertexInputStateCreateInfo vertex_input_state{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
-		std::vector<VkVertexInputBindingDescription> bindings;
+		state.viewport_state.scissorCount = 1;
+		state.viewport_state.viewportCount = 1;
+		vk_create_info.pViewportState = &state.viewport_state;
 
 		if (!mesh_shader_enabled) 
 		{
+			std::vector<const ShaderInterfaceVariable*> vertex_input;
+			VkPipelineVertexInputStateCreateInfo& vertex_input_state = state.vertex_input_state;
+			std::vector<VkVertexInputAttributeDescription>& attributes = state.attributes;
+
 			//input vertex attributes
 			//TODO : currently we don't support multiple vertex bindings
 			vertex_input_state.flags = 0;
 
-			if (auto v = info.vertex_shader->GetInputVariables(); v.has_value())
-			{
-				vertex_input = std::move(v.value());
-			}
-			else
+			for (auto& variable : info.vertex_shader->GetInputVariables())
 			{
-				return std::nullopt;
+				vertex_input.push_back(&variable);
 			}
 
 			std::sort(vertex_input.begin(), vertex_input.end(),
-				[](SpvReflectInterfaceVariable* lhs, SpvReflectInterfaceVariable* rhs) {
+				[](const ShaderInterfaceVariable* lhs, const ShaderInterfaceVariable* rhs) {
 					return lhs->location < rhs->location;
 				}
 			);
@@ -432,7 +866,7 @@ namespace gvk {
 			//get rid of gl preserved words
 			for (auto iter = vertex_input.begin(); iter < vertex_input.end();)
 			{
-				std::string name = (*iter)->name;
+				std::string name = (*iter)->Name();
 				if (name.substr(0, 3) == "gl_")
 				{
 					iter = vertex_input.erase(iter);
@@ -469,7 +903,7 @@ namespace gvk {
 			vertex_input_state.pVertexAttributeDescriptions = attributes.data();
 			vertex_input_state.vertexAttributeDescriptionCount = attributes.size();
 
-			bindings.push_back(binding);
+			state.bindings.push_back(binding);
 
 			//TODO : currently we only support 1 binding
 			if (attributes.size() == 0)
@@ -479,8 +913,8 @@ namespace gvk {
 			}
 			else
 			{
-				vertex_input_state.pVertexBindingDescriptions = bindings.data();
-				vertex_input_state.vertexBindingDescriptionCount = bindings.size();
+				vertex_input_state.pVertexBindingDescriptions = state.bindings.data();
+				vertex_input_state.vertexBindingDescriptionCount = state.bindings.size();
 			}
 
 			vk_create_info.pVertexInputState = &vertex_input_state;
@@ -492,7 +926,7 @@ namespace gvk {
 
 
 		//shader stages
-		std::vector<VkPipelineShaderStageCreateInfo> shader_stage_infos;
+		std::vector<VkPipelineShaderStageCreateInfo>& shader_stage_infos = state.shader_stage_infos;
 		
 		auto create_shader_stage = [&](ptr<Shader> shader) 
 		{
@@ -511,12 +945,13 @@ namespace gvk {
 			}
 
 			shader_stage_info.pName = shader->GetEntryPointName();
-			//we don't define any specialization
+			//specialization infos are filled after all stages are collected
 			//for details see https://registry.khronos.org/vulkan/specs/1.3-extensions/html/vkspec.html#VkSpecializationInfo
 			shader_stage_info.pSpecializationInfo = NULL;
 			shader_stage_info.stage = shader->GetStage();
 			
 			shader_stage_infos.push_back(shader_stage_info);
+			state.stage_shaders.push_back(shader);
 			return true;
 		};
 
@@ -525,13 +960,13 @@ namespace gvk {
 		{
 			if (!create_shader_stage(info.vertex_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 			if (info.geometry_shader != nullptr)
 			{
 				if (!create_shader_stage(info.geometry_shader))
 				{
-					return std::nullopt;
+					return false;
 				}
 			}
 		}
@@ -541,12 +976,12 @@ namespace gvk {
 			{
 				if (!create_shader_stage(info.task_shader))
 				{
-					return std::nullopt;
+					return false;
 				}
 			}
 			if (!create_shader_stage(info.mesh_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 		}
 
@@ -554,26 +989,34 @@ namespace gvk {
 		{
 			if (!create_shader_stage(info.fragment_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 		}
 		
 
+		state.specialization_entries.resize(shader_stage_infos.size());
+		state.specialization_infos.resize(shader_stage_infos.size());
+		for (uint32 i = 0; i < shader_stage_infos.size(); i++)
+		{
+			shader_stage_infos[i].pSpecializationInfo = info.specialization_constants.Fill(state.stage_shaders[i].get(),
+				state.specialization_entries[i], state.specialization_infos[i]);
+		}
+
 		vk_create_info.pStages = shader_stage_infos.data();
 		vk_create_info.stageCount = shader_stage_infos.size();
 
-		DescriptorLayoutInfoHelper descriptor_helper(info.descriptor_layuot_hint, *this, info.max_bindless_binding_count);
+		DescriptorLayoutInfoHelper& descriptor_helper = state.descriptor_helper;
 		if (!mesh_shader_enabled) 
 		{
 			if (!descriptor_helper.CollectDescriptorLayoutInfo(info.vertex_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 			if (info.geometry_shader != nullptr)
 			{
 				if (!descriptor_helper.CollectDescriptorLayoutInfo(info.geometry_shader))
 				{
-					return std::nullopt;
+					return false;
 				}
 			}
 		}
@@ -583,13 +1026,13 @@ namespace gvk {
 			{
 				if (!descriptor_helper.CollectDescriptorLayoutInfo(info.task_shader))
 				{
-					return std::nullopt;
+					return false;
 				}
 			}
 
 			if (!descriptor_helper.CollectDescriptorLayoutInfo(info.mesh_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 		}
 		
@@ -597,54 +1040,146 @@ namespace gvk {
 		{
 			if (!descriptor_helper.CollectDescriptorLayoutInfo(info.fragment_shader))
 			{
-				return std::nullopt;
+				return false;
 			}
 		}
 
 		//Render passes
-		ptr<RenderPass> target_pass;
-		uint32 subpass_index;
 		if (info.target_pass != nullptr)
 		{
-			target_pass   = info.target_pass;
-			subpass_index = info.subpass_index;
+			state.target_pass   = info.target_pass;
+			state.subpass_index = info.subpass_index;
 
-			vk_create_info.subpass = subpass_index;
-			vk_create_info.renderPass = target_pass->GetRenderPass();
+			vk_create_info.subpass = state.subpass_index;
+			vk_create_info.renderPass = state.target_pass->GetRenderPass();
 		}
 		else
 		{
 			//render passes should be created externally
-			return std::nullopt;
+			return false;
 		}
 
-		// pipeline layouts
-		//We create internal descriptor sets for every shader 
-		VkPipelineLayoutCreateInfo pipeline_layout_create_info{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-		pipeline_layout_create_info.flags = 0;
-		pipeline_layout_create_info.pSetLayouts				= descriptor_helper.descriptor_layouts.data();
-		pipeline_layout_create_info.setLayoutCount			= descriptor_helper.descriptor_layouts.size();
-		pipeline_layout_create_info.pPushConstantRanges		= descriptor_helper.push_constant_ranges.data();
-		pipeline_layout_create_info.pushConstantRangeCount	= descriptor_helper.push_constant_ranges.size();
 
-		VkPipelineLayout pipeline_layout;
-		if (vkCreatePipelineLayout(m_Device, &pipeline_layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+		state.feedback_info.pPipelineCreationFeedback = &state.creation_feedback;
+		if (creation_feedback)
 		{
-			return std::nullopt;
+			state.feedback_info.pNext = vk_create_info.pNext;
+			vk_create_info.pNext = &state.feedback_info;
 		}
 
-		vk_create_info.layout = pipeline_layout;
+		return true;
+	}
 
-		VkPipeline pipeline;
-		if (vkCreateGraphicsPipelines(m_Device,NULL,1,&vk_create_info,nullptr,&pipeline) != VK_SUCCESS) 
+	opt<ptr<Pipeline>> Context::CreateGraphicsPipeline(const GvkGraphicsPipelineCreateInfo& info) {
+		return CreateGraphicsPipelines(View<GvkGraphicsPipelineCreateInfo>(&info, 0, 1))[0];
+	}
+
+	std::vector<opt<ptr<Pipeline>>> Context::CreateGraphicsPipelines(View<GvkGraphicsPipelineCreateInfo> infos)
+	{
+		std::vector<opt<ptr<Pipeline>>> pipelines(infos.size(), std::nullopt);
+
+		std::vector<std::unique_ptr<GraphicsPipelineBuildState>> states;
+		std::vector<VkGraphicsPipelineCreateInfo> vk_create_infos;
+		//index of every prepared pipeline in infos
+		std::vector<uint32> info_indices;
+		for (uint32 i = 0; i < infos.size(); i++)
 		{
-			vkDestroyPipelineLayout(m_Device, pipeline_layout, nullptr);
-			return std::nullopt;
+			auto state = std::make_unique<GraphicsPipelineBuildState>(infos[i], *this);
+			if (!PrepareGraphicsPipeline(*this, *state, m_PipelineCreationFeedback))
+			{
+				continue;
+			}
+			//We create internal descriptor sets for every shader 
+			if (auto v = AcquirePipelineLayout(state->descriptor_helper.descriptor_layouts, state->descriptor_helper.push_constant_ranges); v.has_value())
+			{
+				state->pipeline_layout = v.value();
+			}
+			else
+			{
+				continue;
+			}
+			state->vk_create_info.layout = state->pipeline_layout->layout;
+			if (m_DescriptorBufferEnabled)
+			{
+				state->vk_create_info.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+			}
+			vk_create_infos.push_back(state->vk_create_info);
+			info_indices.push_back(i);
+			states.push_back(std::move(state));
 		}
-		
-		return ptr<Pipeline>(new Pipeline(pipeline,pipeline_layout,
-			descriptor_helper.GetRearrangedInternalLayouts(), descriptor_helper.push_constant_table,
-			target_pass,subpass_index,VK_PIPELINE_BIND_POINT_GRAPHICS,m_Device));
+
+		if (vk_create_infos.empty())
+		{
+			return pipelines;
+		}
+
+		//pipelines failed to create are set to NULL by the driver,the others are still valid
+		std::vector<VkPipeline> vk_pipelines(vk_create_infos.size(), NULL);
+		vkCreateGraphicsPipelines(m_Device, m_PipelineCache, vk_create_infos.size(), vk_create_infos.data(), nullptr, vk_pipelines.data());
+
+		for (uint32 i = 0; i < vk_pipelines.size(); i++)
+		{
+			GraphicsPipelineBuildState& state = *states[i];
+			if (vk_pipelines[i] == NULL)
+			{
+				continue;
+			}
+			RecordPipelineCreationFeedback(state.creation_feedback);
+
+			pipelines[info_indices[i]] = WrapDeferredRelease(new Pipeline(vk_pipelines[i], state.pipeline_layout,
+				state.descriptor_helper.GetRearrangedInternalLayouts(), state.descriptor_helper.push_constant_table,
+				state.target_pass, state.subpass_index, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Device));
+			if (m_HotReloader != nullptr)
+			{
+				m_HotReloader->TrackPipeline(pipelines[info_indices[i]].value(), infos[info_indices[i]]);
+			}
+		}
+
+		return pipelines;
+	}
+
+	ptr<AsyncPipeline> Context::CreateGraphicsPipelineAsync(const GvkGraphicsPipelineCreateInfo& create_info)
+	{
+		//the create info is copied,shaders and render pass are kept alive by the copy
+		auto future = SubmitJob([this, info = create_info]() 
+			{
+				return CreateGraphicsPipeline(info);
+			}
+		);
+		return ptr<AsyncPipeline>(new AsyncPipeline(future.share()));
+	}
+
+	ptr<AsyncPipeline> Context::CreateComputePipelineAsync(const GvkComputePipelineCreateInfo& create_info)
+	{
+		auto future = SubmitJob([this, info = create_info]()
+			{
+				return CreateComputePipeline(info);
+			}
+		);
+		return ptr<AsyncPipeline>(new AsyncPipeline(future.share()));
+	}
+
+	AsyncPipeline::AsyncPipeline(std::shared_future<opt<ptr<Pipeline>>> future)
+		:m_Future(future) {}
+
+	bool AsyncPipeline::IsReady()
+	{
+		return m_Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	opt<ptr<Pipeline>> AsyncPipeline::Wait()
+	{
+		return m_Future.get();
+	}
+
+	ptr<Pipeline> AsyncPipeline::GetOr(const ptr<Pipeline>& placeholder)
+	{
+		if (!IsReady())
+		{
+			return placeholder;
+		}
+		const opt<ptr<Pipeline>>& pipeline = m_Future.get();
+		return pipeline.has_value() ? pipeline.value() : placeholder;
 	}
 
 	opt<ptr<gvk::Pipeline>> Context::CreateComputePipeline(const GvkComputePipelineCreateInfo& info)
@@ -662,6 +1197,11 @@ namespace gvk {
 		create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
 		create_info.stage.pName = info.shader->GetEntryPointName();
+
+		std::vector<VkSpecializationMapEntry> specialization_entries;
+		VkSpecializationInfo specialization_info{};
+		create_info.stage.pSpecializationInfo = info.specialization_constants.Fill(info.shader.get(),
+			specialization_entries, specialization_info);
 		
 		DescriptorLayoutInfoHelper helper(info.descriptor_layuot_hint, *this, info.max_bindless_binding_count);
 		if (!helper.CollectDescriptorLayoutInfo(info.shader)) 
@@ -669,30 +1209,44 @@ namespace gvk {
 			return std::nullopt;
 		}
 
-		VkPipelineLayoutCreateInfo pipeline_layout_create{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-		pipeline_layout_create.setLayoutCount = helper.descriptor_layouts.size();
-		pipeline_layout_create.pSetLayouts = helper.descriptor_layouts.data();
-		pipeline_layout_create.pushConstantRangeCount = helper.push_constant_ranges.size();
-		pipeline_layout_create.pPushConstantRanges = helper.push_constant_ranges.data();
-		pipeline_layout_create.flags = 0;
-
-		VkPipelineLayout layout;
-		if (vkCreatePipelineLayout(m_Device,&pipeline_layout_create,nullptr,&layout) != VK_SUCCESS) 
+		ptr<SharedPipelineLayout> layout;
+		if (auto v = AcquirePipelineLayout(helper.descriptor_layouts, helper.push_constant_ranges); v.has_value())
+		{
+			layout = v.value();
+		}
+		else
 		{
 			return std::nullopt;
 		}
-		create_info.layout = layout;
+		create_info.layout = layout->layout;
+		if (m_DescriptorBufferEnabled)
+		{
+			create_info.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+		}
+
+		VkPipelineCreationFeedback creation_feedback{};
+		VkPipelineCreationFeedbackCreateInfo feedback_info{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+		feedback_info.pPipelineCreationFeedback = &creation_feedback;
+		if (m_PipelineCreationFeedback)
+		{
+			create_info.pNext = &feedback_info;
+		}
 
 		VkPipeline compute_pipeline;
-		if (vkCreateComputePipelines(m_Device,NULL,1,&create_info,nullptr,&compute_pipeline) != VK_SUCCESS) 
+		if (vkCreateComputePipelines(m_Device,m_PipelineCache,1,&create_info,nullptr,&compute_pipeline) != VK_SUCCESS) 
 		{
-			vkDestroyPipelineLayout(m_Device, layout, nullptr);
 			return std::nullopt;
 		}
+		RecordPipelineCreationFeedback(creation_feedback);
 
-		return ptr<Pipeline>(new Pipeline(compute_pipeline, layout,
+		ptr<Pipeline> pipeline = WrapDeferredRelease(new Pipeline(compute_pipeline, layout,
 			helper.GetRearrangedInternalLayouts(), helper.push_constant_table,
 			nullptr,0,VK_PIPELINE_BIND_POINT_COMPUTE, m_Device));
+		if (m_HotReloader != nullptr)
+		{
+			m_HotReloader->TrackPipeline(pipeline, info);
+		}
+		return pipeline;
 	}
 
 	extern VkPhysicalDeviceRayTracingPipelinePropertiesKHR& GetRayTracingProperties(gvk::Context* ctx);
@@ -700,6 +1254,7 @@ namespace gvk {
 	opt<ptr<RaytracingPipeline>> Context::CreateRaytracingPipeline(const RayTracingPieplineCreateInfo& create_info)
 	{
 		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+		std::vector<ptr<Shader>> stageShaders;
 		std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups;
 		std::unordered_map<uint64_t, uint32_t> shaderStageMap;
 
@@ -720,6 +1275,7 @@ namespace gvk {
 			shaderStageCI.stage = stage;
 			uint32_t id = shaderStages.size();
 			shaderStages.push_back(shaderStageCI);
+			stageShaders.push_back(shader);
 			shaderStageMap[shaderAddress] = id;
 
 			return id;
@@ -801,15 +1357,12 @@ namespace gvk {
 
 		uint32_t shaderHandleCount = rayGenCount + missCount + hitCount + callableCount;
 
-		VkPipelineLayoutCreateInfo pipeline_layout_create{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-		pipeline_layout_create.setLayoutCount = helper.descriptor_layouts.size();
-		pipeline_layout_create.pSetLayouts = helper.descriptor_layouts.data();
-		pipeline_layout_create.pushConstantRangeCount = helper.push_constant_ranges.size();
-		pipeline_layout_create.pPushConstantRanges = helper.push_constant_ranges.data();
-		pipeline_layout_create.flags = 0;
-
-		VkPipelineLayout layout;
-		if (vkCreatePipelineLayout(m_Device, &pipeline_layout_create, nullptr, &layout) != VK_SUCCESS)
+		ptr<SharedPipelineLayout> layout;
+		if (auto v = AcquirePipelineLayout(helper.descriptor_layouts, helper.push_constant_ranges); v.has_value())
+		{
+			layout = v.value();
+		}
+		else
 		{
 			return std::nullopt;
 		}
@@ -817,13 +1370,38 @@ namespace gvk {
 		VkRayTracingPipelineCreateInfoKHR rayTracingCI{ VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR };
 		rayTracingCI.groupCount = shaderGroups.size();
 		rayTracingCI.pGroups = shaderGroups.data();
+
+		std::vector<std::vector<VkSpecializationMapEntry>> specializationEntries(shaderStages.size());
+		std::vector<VkSpecializationInfo> specializationInfos(shaderStages.size());
+		for (uint32_t i = 0; i < shaderStages.size(); i++)
+		{
+			shaderStages[i].pSpecializationInfo = create_info.specializationConstants.Fill(stageShaders[i].get(),
+				specializationEntries[i], specializationInfos[i]);
+		}
+
 		rayTracingCI.pStages = shaderStages.data();
 		rayTracingCI.stageCount = shaderStages.size();
 		rayTracingCI.maxPipelineRayRecursionDepth = create_info.maxRecursiveDepth;
-		rayTracingCI.layout = layout;
+		rayTracingCI.layout = layout->layout;
+		if (m_DescriptorBufferEnabled)
+		{
+			rayTracingCI.flags |= VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+		}
+
+		VkPipelineCreationFeedback creationFeedback{};
+		VkPipelineCreationFeedbackCreateInfo feedbackCI{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+		feedbackCI.pPipelineCreationFeedback = &creationFeedback;
+		if (m_PipelineCreationFeedback)
+		{
+			rayTracingCI.pNext = &feedbackCI;
+		}
 
 		VkPipeline pipeline;
-		vkCreateRayTracingPipelinesKHR(m_Device, {}, {}, 1, &rayTracingCI, NULL, &pipeline);
+		if (vkCreateRayTracingPipelinesKHR(m_Device, NULL, m_PipelineCache, 1, &rayTracingCI, NULL, &pipeline) != VK_SUCCESS)
+		{
+			return std::nullopt;
+		}
+		RecordPipelineCreationFeedback(creationFeedback);
 
 
 		// TODO create STB table
@@ -909,7 +1487,7 @@ namespace gvk {
 		);
 		
 
-		auto rtPipeline = ptr<RaytracingPipeline>(new RaytracingPipeline(pipeline, layout,
+		auto rtPipeline = WrapDeferredRelease(new RaytracingPipeline(pipeline, layout,
 			helper.GetRearrangedInternalLayouts(), helper.push_constant_table,
 			nullptr, 0, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_Device, create_info));
 		rtPipeline->m_SBT = SBT;
@@ -979,7 +1557,23 @@ namespace gvk {
 		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 		vkCmdSetScissor(command_buffer, 0, 1, &sissor);
 
-		return RenderPassInlineContent(framebuffer, command_buffer);
+		return RenderPassInlineContent(framebuffer, command_buffer);
+	}
+
+	RenderPassSecondaryContent RenderPass::BeginSecondary(VkFramebuffer framebuffer, VkClearValue* clear_values, VkRect2D render_area,
+		VkViewport viewport, VkRect2D sissor, VkCommandBuffer command_buffer)
+	{
+		VkRenderPassBeginInfo begin{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+		begin.clearValueCount = m_AttachmentCount;
+		begin.pClearValues = clear_values;
+		begin.framebuffer = framebuffer;
+		begin.renderArea = render_area;
+		begin.renderPass = m_Pass;
+
+		//the primary command buffer can only execute secondary command buffers in the subpasses
+		vkCmdBeginRenderPass(command_buffer, &begin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		return RenderPassSecondaryContent(m_Pass, framebuffer, command_buffer, viewport, sissor);
 	}
 
 	RenderPass::~RenderPass()
@@ -1053,15 +1647,26 @@ namespace gvk {
 
 	Pipeline::~Pipeline()
 	{
-		vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
 		vkDestroyPipeline(m_Device, m_Pipeline, nullptr);
+		//the pipeline layout may be shared by other pipelines
+		m_SharedPipelineLayout = nullptr;
 	}
 
-	Pipeline::Pipeline(VkPipeline pipeline, VkPipelineLayout layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string,VkPushConstantRange>& push_constants, ptr<RenderPass> render_pass,uint32 subpass_index,VkPipelineBindPoint bind_point,VkDevice device) 
-		:m_Pipeline(pipeline),m_PipelineLayout(layout),m_InternalDescriptorSetLayouts(descriptor_set_layouts),m_PushConstants(push_constants),
+	Pipeline::Pipeline(VkPipeline pipeline, const ptr<SharedPipelineLayout>& layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string,VkPushConstantRange>& push_constants, ptr<RenderPass> render_pass,uint32 subpass_index,VkPipelineBindPoint bind_point,VkDevice device) 
+		:m_Pipeline(pipeline),m_PipelineLayout(layout->layout),m_SharedPipelineLayout(layout),m_InternalDescriptorSetLayouts(descriptor_set_layouts),m_PushConstants(push_constants),
 	m_RenderPass(render_pass),m_SubpassIndex(subpass_index),m_Device(device),m_BindPoint(bind_point) 
 	{}
 
+	void Pipeline::Swap(Pipeline& other)
+	{
+		gvk_assert(m_BindPoint == other.m_BindPoint && m_Device == other.m_Device);
+		std::swap(m_Pipeline, other.m_Pipeline);
+		std::swap(m_PipelineLayout, other.m_PipelineLayout);
+		std::swap(m_SharedPipelineLayout, other.m_SharedPipelineLayout);
+		std::swap(m_InternalDescriptorSetLayouts, other.m_InternalDescriptorSetLayouts);
+		std::swap(m_PushConstants, other.m_PushConstants);
+	}
+
 	VkDescriptorSet DescriptorSet::GetDescriptorSet()
 	{
 		return m_Set;
@@ -1072,12 +1677,17 @@ namespace gvk {
 		return m_Layout->GetSetID();
 	}
 
-	opt<SpvReflectDescriptorBinding*> DescriptorSet::FindBinding(const char* name)
+	ptr<DescriptorSetLayout> DescriptorSet::GetLayout()
+	{
+		return m_Layout;
+	}
+
+	opt<const ShaderDescriptorBinding*> DescriptorSet::FindBinding(const char* name)
 	{
 		auto bindings = m_Layout->GetDescriptorSetBindings();
 		for (uint32 i = 0; i < bindings.size(); i++)
 		{
-			if (strcmp(bindings[i]->name, name) == 0)
+			if (strcmp(bindings[i]->Name(), name) == 0)
 			{
 				return bindings[i];
 			}
@@ -1101,88 +1711,151 @@ namespace gvk {
 
 	DescriptorSet::~DescriptorSet()
 	{
-		//descriptor set will be released automatically when descriptor pool is released
-		if (m_Layout->IsBindless())
-		{
-			m_Alloc->OnBindlessDescriptorSetDestroy(m_Set);
-		}
+		//the set is recycled by its allocator,it is released with the pools when the allocator is destroyed
+		m_Alloc->OnDescriptorSetDestroy(m_Layout, m_Set);
 	}
 
-	DescriptorSet::DescriptorSet(VkDevice device, VkDescriptorSet set, ptr<DescriptorSetLayout> layout, DescriptorAllocator* alloc)
+	DescriptorSet::DescriptorSet(VkDevice device, VkDescriptorSet set, ptr<DescriptorSetLayout> layout, ptr<DescriptorAllocator> alloc)
 		:m_Device(device),m_Set(set),m_Layout(layout),m_Alloc(alloc)
 	{}
 
-	opt<ptr<gvk::DescriptorSet>> DescriptorAllocator::Allocate(ptr<DescriptorSetLayout> layout)
+	//size of the descriptor info consumed by an update template entry,0 if the type can't be updated by templates
+	static uint32 GetDescriptorInfoSize(VkDescriptorType type)
 	{
-		auto bindings = layout->GetDescriptorSetBindings();
-		//check if this layout contains a bindless binding
-		if (layout->IsBindless())
+		switch (type)
 		{
-			return AllocateBindless(layout);
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return sizeof(VkDescriptorImageInfo);
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			return sizeof(VkDescriptorBufferInfo);
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			return sizeof(VkBufferView);
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+			return sizeof(VkAccelerationStructureKHR);
+		default:
+			return 0;
 		}
+	}
 
-		//collect descriptor informations
-		for (uint32 i = 0;i < bindings.size();i++) 
+	opt<ptr<DescriptorUpdateTemplate>> Context::CreateDescriptorUpdateTemplate(const ptr<DescriptorSetLayout>& layout, std::string* error)
+	{
+		std::vector<const ShaderDescriptorBinding*> bindings;
+		for (auto binding : layout->GetDescriptorSetBindings())
 		{
-			VkDescriptorPoolSize* poolSize = nullptr;
-			for (uint32_t j = 0;j < m_PoolSize.size();j++)
+			//the count of variable count bindings is only known when the set is allocated
+			if (binding->count == 0) continue;
+			bindings.push_back(binding);
+		}
+		std::sort(bindings.begin(), bindings.end(), [](const ShaderDescriptorBinding* lhs, const ShaderDescriptorBinding* rhs)
 			{
-				if (bindings[i]->descriptor_type == m_PoolSize[j].type)
-				{
-					poolSize = &m_PoolSize[j];
-					break;
-				}
-			}
-
-			if (poolSize == nullptr)
+				return lhs->binding < rhs->binding;
+			});
+
+		std::vector<VkDescriptorUpdateTemplateEntry> entries;
+		std::unordered_map<uint32, uint32> binding_offsets;
+		std::unordered_map<std::string, uint32> name_offsets;
+		uint32 data_size = 0;
+		for (auto binding : bindings)
+		{
+			VkDescriptorType type = layout->GetDescriptorType(binding->binding);
+			uint32 info_size = GetDescriptorInfoSize(type);
+			if (info_size == 0)
 			{
+				if (error) *error = "gvk : fail to create descriptor update template, descriptor type of (set " + std::to_string(layout->GetSetID()) +
+					", binding " + std::to_string(binding->binding) + ") " + binding->Name() + " is not supported";
 				return std::nullopt;
 			}
-			poolSize->descriptorCount += bindings[i]->count;
+			//every descriptor info is 8 bytes aligned,so the block is packed like a plain struct
+			data_size = Align(data_size, alignof(VkDescriptorBufferInfo));
+
+			VkDescriptorUpdateTemplateEntry entry{};
+			entry.dstBinding = binding->binding;
+			entry.dstArrayElement = 0;
+			entry.descriptorCount = binding->count;
+			entry.descriptorType = type;
+			entry.offset = data_size;
+			entry.stride = info_size;
+			entries.push_back(entry);
+
+			binding_offsets[binding->binding] = data_size;
+			name_offsets[binding->Name()] = data_size;
+			data_size += info_size * binding->count;
 		}
-		m_MaxSetCount++;
 
-		//allocate descriptor set
-		VkDescriptorSetLayout layouts[] = {layout->GetLayout()};
-		VkDescriptorSetAllocateInfo alloc_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-		alloc_info.descriptorPool = m_CurrentDescriptorPool;
-		alloc_info.descriptorSetCount = gvk_count_of(layouts);
-		alloc_info.pSetLayouts = layouts;
+		if (entries.empty())
+		{
+			if (error) *error = "gvk : fail to create descriptor update template, the layout has no binding to update";
+			return std::nullopt;
+		}
 
-		VkDescriptorSet set;
-		if (vkAllocateDescriptorSets(m_Device,&alloc_info,&set) != VK_SUCCESS) 
-		// current pool may run out of space
-		// create a new one
+		VkDescriptorUpdateTemplateCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO };
+		info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		info.descriptorSetLayout = layout->GetLayout();
+		info.descriptorUpdateEntryCount = entries.size();
+		info.pDescriptorUpdateEntries = entries.data();
+
+		VkDescriptorUpdateTemplate update_template;
+		if (vkCreateDescriptorUpdateTemplate(m_Device, &info, nullptr, &update_template) != VK_SUCCESS)
 		{
-			m_UsedDescriptorPool.push_back(m_CurrentDescriptorPool);
-			if (auto v = CreatePool(); !v.has_value()) 
-			{
-				m_CurrentDescriptorPool = v.value();
-			}
-			else
-			{
-				return std::nullopt;
-			}
-			auto vkrs = vkAllocateDescriptorSets(m_Device, &alloc_info, &set);
-			gvk_assert(vkrs == VK_SUCCESS);
+			if (error) *error = "gvk : fail to create descriptor update template";
+			return std::nullopt;
 		}
 
-		return ptr<DescriptorSet>( new DescriptorSet(m_Device, set, layout, this));
+		return ptr<DescriptorUpdateTemplate>(new DescriptorUpdateTemplate(update_template, layout,
+			std::move(binding_offsets), std::move(name_offsets), data_size, m_Device));
 	}
 
-	ptr<gvk::DescriptorAllocator> Context::CreateDescriptorAllocator()
+	DescriptorUpdateTemplate::DescriptorUpdateTemplate(VkDescriptorUpdateTemplate update_template, const ptr<DescriptorSetLayout>& layout,
+		std::unordered_map<uint32, uint32>&& binding_offsets, std::unordered_map<std::string, uint32>&& name_offsets,
+		uint32 data_size, VkDevice device)
+		:m_Template(update_template), m_Layout(layout), m_BindingOffsets(std::move(binding_offsets)),
+		m_NameOffsets(std::move(name_offsets)), m_DataSize(data_size), m_Device(device)
+	{}
+
+	uint32 DescriptorUpdateTemplate::GetDataSize()
 	{
+		return m_DataSize;
+	}
 
-		return ptr<gvk::DescriptorAllocator>(new DescriptorAllocator(m_Device, DeviceExtensionEnabled(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME)));
+	opt<uint32> DescriptorUpdateTemplate::GetOffset(uint32 binding)
+	{
+		if (auto iter = m_BindingOffsets.find(binding); iter != m_BindingOffsets.end())
+		{
+			return iter->second;
+		}
+		return std::nullopt;
 	}
 
-	DescriptorAllocator::~DescriptorAllocator()
+	opt<uint32> DescriptorUpdateTemplate::GetOffset(const char* name)
 	{
-		for (auto pool : m_UsedDescriptorPool) 
+		if (auto iter = m_NameOffsets.find(name); iter != m_NameOffsets.end())
 		{
-			vkDestroyDescriptorPool(m_Device, pool, nullptr);
+			return iter->second;
 		}
-		vkDestroyDescriptorPool(m_Device, m_CurrentDescriptorPool, nullptr);
+		return std::nullopt;
+	}
+
+	void DescriptorUpdateTemplate::Update(VkDescriptorSet set, const void* data)
+	{
+		vkUpdateDescriptorSetWithTemplate(m_Device, set, m_Template, data);
+	}
+
+	VkDescriptorUpdateTemplate DescriptorUpdateTemplate::GetTemplate()
+	{
+		return m_Template;
+	}
+
+	DescriptorUpdateTemplate::~DescriptorUpdateTemplate()
+	{
+		vkDestroyDescriptorUpdateTemplate(m_Device, m_Template, nullptr);
 	}
 
 	constexpr uint32 pool_size = 1024;
@@ -1206,139 +1879,287 @@ namespace gvk {
 		{VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, pool_size / 4}
 	};
 
-	DescriptorAllocator::DescriptorAllocator(VkDevice device, bool rtSupport)
-		:m_Device(device) 
+	//slot of a descriptor type in DescriptorAllocator::PoolUsage
+	static opt<uint32> GetPoolUsageSlot(VkDescriptorType type)
 	{
-		std::vector<VkDescriptorPoolSize> poolSize = g_pool_sizes;
-		if (rtSupport)
-		{
-			poolSize.insert(poolSize.begin(), g_rt_pool_sizes.begin(), g_rt_pool_sizes.end());
-		}
+		if (type <= VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT) return (uint32)type;
+		if (type == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR) return 11;
+		return std::nullopt;
+	}
 
-		m_MaxSetCount = pool_size / 4;
-		m_PoolSize = poolSize;
-		auto pool = CreatePool();
-		gvk_assert(pool.has_value());
-		m_CurrentDescriptorPool = pool.value();
+	static VkDescriptorType GetPoolUsageType(uint32 slot)
+	{
+		return slot == 11 ? VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR : (VkDescriptorType)slot;
 	}
 
-	void DescriptorAllocator::OnBindlessDescriptorSetDestroy(VkDescriptorSet set)
+	void DescriptorAllocator::PoolUsage::Add(const PoolUsage& usage)
 	{
-		if (auto var = std::find( m_AllocatedBindlessSet.begin(), m_AllocatedBindlessSet.end(), set) ;var != m_AllocatedBindlessSet.end())
-		{
-			uint32_t idx = var - m_AllocatedBindlessSet.begin();
-			vkDestroyDescriptorPool(m_Device, m_AllocatedBindlessPool[idx], NULL);
+		sets += usage.sets;
+		for (uint32 i = 0; i < type_count; i++) descriptors[i] += usage.descriptors[i];
+	}
 
-			m_AllocatedBindlessSet.erase(var);
-			m_AllocatedBindlessPool.erase(m_AllocatedBindlessPool.begin() + idx);
-		}
-		else
+	void DescriptorAllocator::PoolUsage::Max(const PoolUsage& usage)
+	{
+		sets = std::max(sets, usage.sets);
+		for (uint32 i = 0; i < type_count; i++) descriptors[i] = std::max(descriptors[i], usage.descriptors[i]);
+	}
+
+	ptr<gvk::DescriptorAllocator> Context::CreateDescriptorAllocator(uint32 frame_count)
+	{
+		//descriptor buffer layouts can't be allocated from descriptor pools
+		gvk_assert(!m_DescriptorBufferEnabled);
+		//the pools are destroyed after the gpu has finished with the sets allocated from them
+		return WrapDeferredRelease(new DescriptorAllocator(m_Device, DeviceExtensionEnabled(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME),
+			frame_count != 0 ? frame_count : m_BackBufferCount, m_ReleaseQueue));
+	}
+
+	ptr<DescriptorAllocator> Context::GetThreadDescriptorAllocator()
+	{
+		//allocators are owned by the context,threads only keep weak references
+		thread_local std::unordered_map<uint64_t, std::weak_ptr<DescriptorAllocator>> thread_allocators;
+		if (auto iter = thread_allocators.find(m_ContextId); iter != thread_allocators.end())
 		{
-			gvk_assert(false);
+			if (auto allocator = iter->second.lock())
+			{
+				return allocator;
+			}
 		}
 
+		auto allocator = CreateDescriptorAllocator();
+		std::vector<ThreadObject<DescriptorAllocator>> exited;
+		{
+			std::lock_guard<std::mutex> lock(m_ThreadDescriptorAllocatorLock);
+			exited = PruneThreadObjects(m_ThreadDescriptorAllocators);
+			m_ThreadDescriptorAllocators.push_back(ThreadObject<DescriptorAllocator>{ GetThreadToken(), allocator });
+		}
+		thread_allocators[m_ContextId] = allocator;
+		return allocator;
 	}
 
-	opt<ptr<DescriptorSet>> DescriptorAllocator::AllocateBindless(ptr<DescriptorSetLayout> layout)
+	void Context::BeginDescriptorFrame(uint32 frame_index)
 	{
-		uint32_t descriptorCount[10] = { 0 };
-		uint32_t asDescriptorCount = 0;
-		auto bindings = layout->GetDescriptorSetBindings();
-		uint32_t maxBinding = 0;
-
-		for (uint32_t i = 0;i < bindings.size();i++)
+		//allocators of exited threads are dropped out of the lock,their sets keep them alive
+		std::vector<ThreadObject<DescriptorAllocator>> exited;
+		std::lock_guard<std::mutex> lock(m_ThreadDescriptorAllocatorLock);
+		exited = PruneThreadObjects(m_ThreadDescriptorAllocators);
+		for (auto& allocator : m_ThreadDescriptorAllocators)
 		{
-			uint32_t highestBindingIdx = bindings[i]->binding + (bindings[i]->count == 0 ? layout->GetMaxBindlessDescriptorSetCount() : 
-				bindings[i]->count) - 1;
+			allocator.object->BeginFrame(frame_index);
+		}
+	}
 
-			maxBinding = max(maxBinding, highestBindingIdx);
+	DescriptorAllocator::DescriptorAllocator(VkDevice device, bool rtSupport, uint32 frame_count, ptr<ReleaseQueue> release_queue)
+		:m_Device(device), m_RtSupport(rtSupport), m_ReleaseQueue(release_queue)
+	{
+		gvk_assert(frame_count != 0);
+		m_FramePools.resize(frame_count);
+		m_BindlessPools.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	}
 
-			if (bindings[i]->descriptor_type < 10)
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		auto destroy_chain = [&](PoolChain& chain)
+		{
+			for (auto pool : chain.pools)
 			{
-				descriptorCount[bindings[i]->descriptor_type] += bindings[i]->count == 0 ? layout->GetMaxBindlessDescriptorSetCount() : bindings[i]->count;
+				vkDestroyDescriptorPool(m_Device, pool, nullptr);
 			}
-			else if(bindings[i]->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR)
+		};
+		destroy_chain(m_PersistentPools);
+		destroy_chain(m_BindlessPools);
+		for (auto& chain : m_FramePools)
+		{
+			destroy_chain(chain);
+		}
+	}
+
+	DescriptorAllocator::PoolUsage DescriptorAllocator::GetLayoutUsage(DescriptorSetLayout* layout)
+	{
+		PoolUsage usage;
+		usage.sets = 1;
+		for (auto binding : layout->GetDescriptorSetBindings())
+		{
+			auto slot = GetPoolUsageSlot(layout->GetDescriptorType(binding->binding));
+			gvk_assert(slot.has_value());
+			//variable count bindings are allocated with the max bindless count
+			usage.descriptors[slot.value()] += binding->count != 0 ? binding->count : layout->GetMaxBindlessDescriptorSetCount();
+		}
+		return usage;
+	}
+
+	opt<VkDescriptorPool> DescriptorAllocator::CreatePool(const PoolUsage& usage, VkDescriptorPoolCreateFlags flags)
+	{
+		//the default sizes are the lower bound,types never used stay small
+		PoolUsage size;
+		for (auto& pool_size : g_pool_sizes)
+		{
+			size.descriptors[GetPoolUsageSlot(pool_size.type).value()] = pool_size.descriptorCount;
+		}
+		if (m_RtSupport)
+		{
+			for (auto& pool_size : g_rt_pool_sizes)
 			{
-				asDescriptorCount += bindings[i]->count;
+				size.descriptors[GetPoolUsageSlot(pool_size.type).value()] = pool_size.descriptorCount;
 			}
 		}
+		size.sets = pool_size / 4;
 
+		//leave room for the usage to grow
+		PoolUsage grown;
+		grown.sets = usage.sets * 2;
+		for (uint32 i = 0; i < PoolUsage::type_count; i++) grown.descriptors[i] = usage.descriptors[i] * 2;
+		size.Max(grown);
 
-		std::vector<VkDescriptorPoolSize> poolSizes;
-		for (uint32_t i = 0;i < 10;i++)
+		std::vector<VkDescriptorPoolSize> pool_sizes;
+		for (uint32 i = 0; i < PoolUsage::type_count; i++)
 		{
-			if (descriptorCount[i] != 0)
+			if (size.descriptors[i] != 0)
 			{
-				poolSizes.push_back({ (VkDescriptorType)i, descriptorCount[i] });
+				pool_sizes.push_back(VkDescriptorPoolSize{ GetPoolUsageType(i), size.descriptors[i] });
 			}
 		}
-		if (asDescriptorCount != 0) poolSizes.push_back({ VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, asDescriptorCount});
 
-		VkDescriptorPoolCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-		info.poolSizeCount = poolSizes.size();
-		info.pPoolSizes = poolSizes.data();
-		info.maxSets = 1;
-		info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		VkDescriptorPoolCreateInfo info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+		info.flags = flags;
+		info.poolSizeCount = pool_sizes.size();
+		info.pPoolSizes = pool_sizes.data();
+		info.maxSets = size.sets;
 
-		VkDescriptorPool bindlessDescPool;
-		if (vkCreateDescriptorPool(m_Device, &info, NULL, &bindlessDescPool) != VK_SUCCESS) 
+		VkDescriptorPool pool;
+		if (vkCreateDescriptorPool(m_Device, &info, nullptr, &pool) != VK_SUCCESS)
 		{
 			return std::nullopt;
 		}
 
-		VkDescriptorSetLayout layouts[] = { layout->GetLayout() };
+		return pool;
+	}
+
+	opt<VkDescriptorSet> DescriptorAllocator::AllocateFromChain(PoolChain& chain, DescriptorSetLayout* layout)
+	{
+		PoolUsage usage = GetLayoutUsage(layout);
+		chain.usage.Add(usage);
 
+		VkDescriptorSetLayout layouts[] = { layout->GetLayout() };
 		VkDescriptorSetAllocateInfo alloc_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-		alloc_info.descriptorPool = bindlessDescPool;
-		alloc_info.descriptorSetCount = 1;
+		alloc_info.descriptorSetCount = gvk_count_of(layouts);
 		alloc_info.pSetLayouts = layouts;
 
 		VkDescriptorSetVariableDescriptorCountAllocateInfoEXT count_info{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT };
-		uint32_t max_binding = maxBinding;
-		count_info.descriptorSetCount = 1;
-		// This number is the max allocatable count
-		count_info.pDescriptorCounts = &max_binding;
-		alloc_info.pNext = &count_info;
+		uint32 variable_count = layout->GetMaxBindlessDescriptorSetCount();
+		if (layout->IsBindless())
+		{
+			count_info.descriptorSetCount = 1;
+			count_info.pDescriptorCounts = &variable_count;
+			alloc_info.pNext = &count_info;
+		}
 
-		VkDescriptorSet bindlessDescriptorSet;
-		if (vkAllocateDescriptorSets(m_Device, &alloc_info, &bindlessDescriptorSet) != VK_SUCCESS)
+		VkDescriptorSet set;
+		//pools that are out of space are skipped until the chain is reset
+		for (; chain.current < chain.pools.size(); chain.current++)
+		{
+			alloc_info.descriptorPool = chain.pools[chain.current];
+			if (vkAllocateDescriptorSets(m_Device, &alloc_info, &set) == VK_SUCCESS)
+			{
+				return set;
+			}
+		}
+
+		//current pools may run out of space,create a new one sized by the usage observed so far
+		PoolUsage expected = chain.usage;
+		expected.Max(chain.peak);
+		auto pool = CreatePool(expected, chain.flags);
+		if (!pool.has_value())
+		{
+			return std::nullopt;
+		}
+		chain.pools.push_back(pool.value());
+		alloc_info.descriptorPool = pool.value();
+		if (vkAllocateDescriptorSets(m_Device, &alloc_info, &set) != VK_SUCCESS)
 		{
-			vkDestroyDescriptorPool(m_Device, bindlessDescPool, NULL);
 			return std::nullopt;
 		}
+		return set;
+	}
+
+	opt<ptr<gvk::DescriptorSet>> DescriptorAllocator::Allocate(ptr<DescriptorSetLayout> layout)
+	{
+		//push descriptor sets are never allocated
+		gvk_assert(!layout->IsPushDescriptor());
+		//reuse a set released by a set of the same layout
+		if (auto iter = m_FreeSets.find(layout->GetLayout()); iter != m_FreeSets.end() && !iter->second.sets.empty())
+		{
+			VkDescriptorSet set = iter->second.sets.back();
+			iter->second.sets.pop_back();
+			return ptr<DescriptorSet>(new DescriptorSet(m_Device, set, layout, shared_from_this()));
+		}
 
-		m_AllocatedBindlessPool.push_back(bindlessDescPool);
-		m_AllocatedBindlessSet.push_back(bindlessDescriptorSet);
+		auto set = AllocateFromChain(layout->IsBindless() ? m_BindlessPools : m_PersistentPools, layout.get());
+		if (!set.has_value())
+		{
+			return std::nullopt;
+		}
+		return ptr<DescriptorSet>(new DescriptorSet(m_Device, set.value(), layout, shared_from_this()));
+	}
 
-		return ptr<DescriptorSet>(new DescriptorSet(m_Device, bindlessDescriptorSet, layout, this));
+	opt<VkDescriptorSet> DescriptorAllocator::AllocateTransient(ptr<DescriptorSetLayout> layout)
+	{
+		gvk_assert(!layout->IsBindless() && !layout->IsPushDescriptor());
+		return AllocateFromChain(m_FramePools[m_FrameIndex], layout.get());
 	}
 
-	opt<VkDescriptorPool> DescriptorAllocator::CreatePool()
+	void DescriptorAllocator::BeginFrame(uint32 frame_index)
 	{
-		std::vector<VkDescriptorPoolSize> target_pools;
-		for (auto& size : m_PoolSize) 
+		gvk_assert(frame_index < m_FramePools.size());
+		m_FrameIndex = frame_index;
+
+		PoolChain& chain = m_FramePools[frame_index];
+		chain.peak.Max(chain.usage);
+		if (chain.pools.size() > 1)
 		{
-			if (size.descriptorCount != 0) 
+			//the frame needs more than one pool,replace them with a pool large enough for the peak usage
+			for (auto pool : chain.pools)
+			{
+				vkDestroyDescriptorPool(m_Device, pool, nullptr);
+			}
+			chain.pools.clear();
+			if (auto pool = CreatePool(chain.peak, chain.flags); pool.has_value())
 			{
-				target_pools.push_back(size);
+				chain.pools.push_back(pool.value());
 			}
-			size.descriptorCount = 0;
 		}
+		else if (!chain.pools.empty())
+		{
+			vkResetDescriptorPool(m_Device, chain.pools[0], 0);
+		}
+		chain.current = 0;
+		chain.usage = PoolUsage();
 
-		VkDescriptorPoolCreateInfo info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-		info.poolSizeCount = target_pools.size();
-		info.pPoolSizes = target_pools.data();
-		info.maxSets = m_MaxSetCount;
-
-		m_MaxSetCount = 0;
-
-		VkDescriptorPool pool;
-		if (vkCreateDescriptorPool(m_Device, &info, nullptr, &pool) != VK_SUCCESS)
+		//sets the gpu has finished with are reused by later allocations
+		std::vector<ReleasedSet> released;
 		{
-			return std::nullopt;
+			std::lock_guard<std::mutex> lock(m_ReleaseLock);
+			released.swap(m_ReleasedSets);
+		}
+		for (auto& item : released)
+		{
+			FreeSets& free_sets = m_FreeSets[item.layout->GetLayout()];
+			free_sets.layout = item.layout;
+			free_sets.sets.push_back(item.set);
 		}
+	}
 
-		return pool;
+	void DescriptorAllocator::OnDescriptorSetDestroy(const ptr<DescriptorSetLayout>& layout, VkDescriptorSet set)
+	{
+		//the set may still be used by submitted command buffers,
+		//the release keeps the allocator and its pools alive until they have finished
+		ptr<DescriptorAllocator> alloc = shared_from_this();
+		m_ReleaseQueue->Release([alloc, layout, set]() { alloc->RecycleSet(layout, set); });
+	}
+
+	void DescriptorAllocator::RecycleSet(const ptr<DescriptorSetLayout>& layout, VkDescriptorSet set)
+	{
+		std::lock_guard<std::mutex> lock(m_ReleaseLock);
+		m_ReleasedSets.push_back(ReleasedSet{ layout, set });
 	}
 
 	void RenderPassInlineContent::Record(std::function<void()> commands)
@@ -1365,6 +2186,37 @@ namespace gvk {
 
 	RenderPassInlineContent::RenderPassInlineContent(VkFramebuffer framebuffer, VkCommandBuffer command_buffer)
 		:m_Framebuffer(framebuffer),m_CommandBuffer(command_buffer) {}
+
+	RenderPassSecondaryContent& RenderPassSecondaryContent::Execute(const VkCommandBuffer* cmd_buffers, uint32 cmd_buffer_count)
+	{
+		if (cmd_buffer_count != 0)
+		{
+			vkCmdExecuteCommands(m_CommandBuffer, cmd_buffer_count, cmd_buffers);
+		}
+		return *this;
+	}
+
+	RenderPassSecondaryContent& RenderPassSecondaryContent::NextSubPass()
+	{
+		vkCmdNextSubpass(m_CommandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_Inheritance.subpass++;
+		return *this;
+	}
+
+	void RenderPassSecondaryContent::EndPass()
+	{
+		vkCmdEndRenderPass(m_CommandBuffer);
+	}
+
+	RenderPassSecondaryContent::RenderPassSecondaryContent(VkRenderPass render_pass, VkFramebuffer framebuffer, VkCommandBuffer command_buffer,
+		VkViewport viewport, VkRect2D scissor)
+		:m_Viewport(viewport), m_Scissor(scissor), m_CommandBuffer(command_buffer)
+	{
+		m_Inheritance = VkCommandBufferInheritanceInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+		m_Inheritance.renderPass = render_pass;
+		m_Inheritance.subpass = 0;
+		m_Inheritance.framebuffer = framebuffer;
+	}
 }
 
 using namespace gvk;
@@ -1549,6 +2401,65 @@ void GvkDescriptorLayoutHint::AddDescriptorSetLayout(const ptr<gvk::DescriptorSe
 	precluded_descriptor_layouts.push_back(layout);
 }
 
+void GvkDescriptorLayoutHint::AddBindlessHeap(const gvk::ptr<gvk::BindlessHeap>& heap, uint32_t first_set)
+{
+	for (uint32_t i = 0; i < GVK_BINDLESS_RESOURCE_COUNT; i++)
+	{
+		fixed_descriptor_layouts.push_back(std::make_pair(first_set + i, heap->GetLayout((GVK_BINDLESS_RESOURCE)i)));
+	}
+}
+
+void GvkSpecializationConstants::SetData(const char* name, const void* value, uint32_t size)
+{
+	gvk_assert(name != nullptr);
+	for (uint32_t i = 0; i < names.size(); i++)
+	{
+		if (names[i] != name) continue;
+		if (sizes[i] == size)
+		{
+			memcpy(data.data() + offsets[i], value, size);
+			return;
+		}
+		//the type of the value changed,the old bytes are left unused
+		names.erase(names.begin() + i);
+		offsets.erase(offsets.begin() + i);
+		sizes.erase(sizes.begin() + i);
+		break;
+	}
+	uint32_t offset = data.size();
+	data.resize(offset + size);
+	memcpy(data.data() + offset, value, size);
+	names.push_back(name);
+	offsets.push_back(offset);
+	sizes.push_back(size);
+}
+
+const VkSpecializationInfo* GvkSpecializationConstants::Fill(gvk::Shader* shader, std::vector<VkSpecializationMapEntry>& entries, VkSpecializationInfo& info) const
+{
+	entries.clear();
+	for (auto& constant : shader->GetSpecializationConstants())
+	{
+		for (uint32_t i = 0; i < names.size(); i++)
+		{
+			if (names[i] == constant.Name())
+			{
+				//the value set must have the size of the constant's type in the shader,e.g. a double can't set a float constant
+				gvk_assert(constant.size == 0 || constant.size == sizes[i]);
+				entries.push_back(VkSpecializationMapEntry{ constant.constant_id, offsets[i], sizes[i] });
+			}
+		}
+	}
+	if (entries.empty())
+	{
+		return NULL;
+	}
+	info.mapEntryCount = entries.size();
+	info.pMapEntries = entries.data();
+	info.dataSize = data.size();
+	info.pData = data.data();
+	return &info;
+}
+
 
 GvkRenderPassCreateInfo::GvkRenderPassCreateInfo()
 {
@@ -1675,7 +2586,7 @@ GvkDescriptorSetWrite& GvkDescriptorSetWrite::BufferWrite(ptr<gvk::DescriptorSet
 	auto binding = set->FindBinding(name);
 	if (binding.has_value()) 
 	{
-		BufferWrite(set,(VkDescriptorType)binding.value()->descriptor_type, binding.value()->binding, buffer, offset, size, array_index);
+		BufferWrite(set, set->GetLayout()->GetDescriptorType(binding.value()->binding), binding.value()->binding, buffer, offset, size, array_index);
 	}
 	return *this;
 }
@@ -1780,7 +2691,7 @@ GvkDescriptorSetWrite& GvkDescriptorSetWrite::ImageWrite(ptr<gvk::DescriptorSet>
 	auto binding = set->FindBinding(name);
 	if (binding.has_value())
 	{
-		ImageWrite(set,(VkDescriptorType)binding.value()->descriptor_type, binding.value()->binding, sampler, image_view, layout, array_index);
+		ImageWrite(set, set->GetLayout()->GetDescriptorType(binding.value()->binding), binding.value()->binding, sampler, image_view, layout, array_index);
 	}
 	return *this;
 }
@@ -1794,6 +2705,128 @@ GvkPushConstant::GvkPushConstant(VkPushConstantRange range, VkPipelineLayout lay
 :range(range),layout(layout) {}
 
 
+GvkPushDescriptorSet::GvkPushDescriptorSet(VkCommandBuffer cmd_buffer, gvk::ptr<gvk::Pipeline> pipeline, gvk::ptr<gvk::DescriptorSetLayout> layout)
+	:cmd_buffer(cmd_buffer), bind_point(pipeline->GetPipelineBindPoint()), pipeline_layout(pipeline->GetPipelineLayout()), layout(layout)
+{
+	gvk_assert(layout->IsPushDescriptor());
+}
+
+GvkPushDescriptorSet& GvkPushDescriptorSet::BufferWrite(VkDescriptorType descriptor_type, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t array_index /*= 0*/)
+{
+	gvk_assert(write_count < max_write_count);
+	VkWriteDescriptorSet& write = writes[write_count];
+	write = VkWriteDescriptorSet{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.descriptorType = descriptor_type;
+	write.descriptorCount = 1;
+	write.dstArrayElement = array_index;
+	write.dstBinding = binding;
+
+	buffer_infos[write_count] = VkDescriptorBufferInfo{ buffer, offset, size };
+	write_count++;
+	return *this;
+}
+
+GvkPushDescriptorSet& GvkPushDescriptorSet::ImageWrite(VkDescriptorType descriptor_type, uint32_t binding, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout, uint32_t array_index /*= 0*/)
+{
+	gvk_assert(write_count < max_write_count);
+	VkWriteDescriptorSet& write = writes[write_count];
+	write = VkWriteDescriptorSet{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.descriptorType = descriptor_type;
+	write.descriptorCount = 1;
+	write.dstArrayElement = array_index;
+	write.dstBinding = binding;
+
+	image_infos[write_count] = VkDescriptorImageInfo{ sampler, image_view, image_layout };
+	write_count++;
+	return *this;
+}
+
+//push descriptor sets are small,a linear search is cheaper than building a table
+static opt<const gvk::ShaderDescriptorBinding*> FindPushDescriptorBinding(const gvk::ptr<gvk::DescriptorSetLayout>& layout, const char* name)
+{
+	for (auto binding : layout->GetDescriptorSetBindings())
+	{
+		if (strcmp(binding->Name(), name) == 0)
+		{
+			return binding;
+		}
+	}
+	return std::nullopt;
+}
+
+GvkPushDescriptorSet& GvkPushDescriptorSet::BufferWrite(const char* name, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t array_index /*= 0*/)
+{
+	if (auto binding = FindPushDescriptorBinding(layout, name); binding.has_value())
+	{
+		BufferWrite(layout->GetDescriptorType(binding.value()->binding), binding.value()->binding, buffer, offset, size, array_index);
+	}
+	return *this;
+}
+
+GvkPushDescriptorSet& GvkPushDescriptorSet::ImageWrite(const char* name, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout, uint32_t array_index /*= 0*/)
+{
+	if (auto binding = FindPushDescriptorBinding(layout, name); binding.has_value())
+	{
+		ImageWrite(layout->GetDescriptorType(binding.value()->binding), binding.value()->binding, sampler, image_view, image_layout, array_index);
+	}
+	return *this;
+}
+
+GvkPushDescriptorSet& GvkPushDescriptorSet::AccelerationStructureWrite(uint32_t binding, VkAccelerationStructureKHR tlas)
+{
+	gvk_assert(write_count < max_write_count);
+	VkWriteDescriptorSet& write = writes[write_count];
+	write = VkWriteDescriptorSet{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+	write.descriptorCount = 1;
+	write.dstArrayElement = 0;
+	write.dstBinding = binding;
+
+	acceleration_structures[write_count] = tlas;
+	write_count++;
+	return *this;
+}
+
+void GvkPushDescriptorSet::Push()
+{
+	if (write_count == 0)
+	{
+		return;
+	}
+
+	//pointers are resolved here,so the struct can be copied before pushing
+	for (uint32_t i = 0; i < write_count; i++)
+	{
+		VkWriteDescriptorSet& write = writes[i];
+		switch (write.descriptorType)
+		{
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			write.pBufferInfo = &buffer_infos[i];
+			break;
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+			acceleration_structure_writes[i] = VkWriteDescriptorSetAccelerationStructureKHR{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR };
+			acceleration_structure_writes[i].accelerationStructureCount = 1;
+			acceleration_structure_writes[i].pAccelerationStructures = &acceleration_structures[i];
+			write.pNext = &acceleration_structure_writes[i];
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			//texel buffer views are not supported by GvkPushDescriptorSet
+			gvk_assert(false);
+			break;
+		default:
+			write.pImageInfo = &image_infos[i];
+			break;
+		}
+	}
+
+	vkCmdPushDescriptorSetKHR(cmd_buffer, bind_point, pipeline_layout, layout->GetSetID(), write_count, writes.data());
+	write_count = 0;
+}
+
 GvkDescriptorSetBindingUpdate::GvkDescriptorSetBindingUpdate(VkCommandBuffer cmd_buffer, gvk::ptr<gvk::Pipeline> pipeline)
 {
 	descriptor_set_count = 0;
@@ -1805,6 +2838,20 @@ GvkDescriptorSetBindingUpdate::GvkDescriptorSetBindingUpdate(VkCommandBuffer cmd
 
 GvkDescriptorSetBindingUpdate& GvkDescriptorSetBindingUpdate::BindDescriptorSet(gvk::ptr<gvk::DescriptorSet> set)
 {
+	return BindDescriptorSet(set, gvk::View<uint32_t>());
+}
+
+GvkDescriptorSetBindingUpdate& GvkDescriptorSetBindingUpdate::BindDescriptorSet(gvk::ptr<gvk::DescriptorSet> set, gvk::View<uint32_t> offsets)
+{
+	gvk_assert(descriptor_set_count < target_sets.size());
+	gvk_assert(offsets.size() == set->GetLayout()->GetDynamicOffsetCount());
+	gvk_assert(dynamic_offset_count + offsets.size() <= max_dynamic_offset_count);
+
+	dynamic_offset_starts[descriptor_set_count] = dynamic_offset_count;
+	for (uint32 i = 0; i < offsets.size(); i++)
+	{
+		dynamic_offsets[dynamic_offset_count++] = offsets[i];
+	}
 	target_sets[descriptor_set_count++] = set;
 	return *this;
 }
@@ -1814,49 +2861,48 @@ void GvkDescriptorSetBindingUpdate::Update()
 	//target descriptor sets should not be empty!
 	gvk_assert(descriptor_set_count != 0);
 
-	if (descriptor_set_count == 1)
-	{
-		VkDescriptorSet set = target_sets[0]->GetDescriptorSet();
-		vkCmdBindDescriptorSets(cmd_buffer, bind_point, layout, target_sets[0]->GetSetIndex(),
-			descriptor_set_count, &set, 0, NULL);
-		return;
-	}
-
-	std::sort(target_sets.begin(), target_sets.begin() + descriptor_set_count,
-		[&](const gvk::ptr<gvk::DescriptorSet>& lhs, const gvk::ptr<gvk::DescriptorSet>& rhs)
+	//sort indices instead of sets,dynamic offsets are stored in the order sets are added
+	std::array<uint32, 16> order;
+	for (uint32 i = 0; i < descriptor_set_count; i++) order[i] = i;
+	std::sort(order.begin(), order.begin() + descriptor_set_count,
+		[&](uint32 lhs, uint32 rhs)
 		{
-			return lhs->GetDescriptorSet() < rhs->GetDescriptorSet();
+			return target_sets[lhs]->GetSetIndex() < target_sets[rhs]->GetSetIndex();
 		}
 	);
 
 	std::array<VkDescriptorSet, 16> sets;
-	
-	sets[0] = target_sets[0]->GetDescriptorSet();
-	uint32	batch_set_cnt = 1;
-	uint32	batch_last_set_idx = target_sets[0]->GetSetIndex();
-	uint32	batch_first_set_idx = target_sets[0]->GetSetIndex();
-	
-	for (uint32 i = 1; i < descriptor_set_count; i++)
+	std::array<uint32, max_dynamic_offset_count> batch_offsets;
+	uint32	batch_set_cnt = 0;
+	uint32	batch_offset_cnt = 0;
+	uint32	batch_first_set_idx = 0;
+
+	for (uint32 i = 0; i < descriptor_set_count; i++)
 	{
-		ptr<gvk::DescriptorSet> curr_set = target_sets[i];
-		if (curr_set->GetSetIndex() != batch_last_set_idx + 1)
+		ptr<gvk::DescriptorSet>& curr_set = target_sets[order[i]];
+		uint32 set_idx = curr_set->GetSetIndex();
+		if (batch_set_cnt != 0 && set_idx != batch_first_set_idx + batch_set_cnt)
 		{
 			vkCmdBindDescriptorSets(cmd_buffer, bind_point, layout, batch_first_set_idx,
-				batch_set_cnt, sets.data(), 0, NULL);
-
-			batch_set_cnt = 1;
-			batch_first_set_idx = curr_set->GetSetIndex();
-			batch_last_set_idx = curr_set->GetSetIndex();
-			sets[0] = curr_set->GetDescriptorSet();
+				batch_set_cnt, sets.data(), batch_offset_cnt, batch_offsets.data());
+			batch_set_cnt = 0;
+			batch_offset_cnt = 0;
 		}
-		else
+		if (batch_set_cnt == 0)
+		{
+			batch_first_set_idx = set_idx;
+		}
+		sets[batch_set_cnt++] = curr_set->GetDescriptorSet();
+
+		uint32 offset_start = dynamic_offset_starts[order[i]];
+		uint32 offset_cnt = curr_set->GetLayout()->GetDynamicOffsetCount();
+		for (uint32 j = 0; j < offset_cnt; j++)
 		{
-			batch_last_set_idx = curr_set->GetSetIndex();
-			sets[batch_set_cnt++] = curr_set->GetDescriptorSet();
+			batch_offsets[batch_offset_cnt++] = dynamic_offsets[offset_start + j];
 		}
 	}
 	vkCmdBindDescriptorSets(cmd_buffer, bind_point, layout, batch_first_set_idx,
-		batch_set_cnt, sets.data(), 0, NULL);
+		batch_set_cnt, sets.data(), batch_offset_cnt, batch_offsets.data());
 }
 
 GvkGraphicsPipelineCreateInfo GvkPipelineCIInitializer::mesh(gvk::ptr<gvk::Shader> task, gvk::ptr<gvk::Shader> mesh, gvk::ptr<gvk::Shader> frag, gvk::ptr<gvk::RenderPass> render_pass, uint32_t subpass_idx, const GvkGraphicsPipelineCreateInfo::BlendState* blend_states)
@@ -3,9 +3,37 @@
 #include "gvk_shader.h"
 #include "gvk_shader_common.h"
 #include <functional>
+#include <future>
+#include <type_traits>
+#include <mutex>
 
 namespace gvk {
 	class TopAccelerationStructure;
+	class BindlessHeap;
+	class ReleaseQueue;
+
+	//vulkan layout objects are cached by context and shared by all structurally identical layouts.
+	//they are destroyed when the last user is released
+	struct SharedDescriptorSetLayout
+	{
+		SharedDescriptorSetLayout(VkDescriptorSetLayout layout, VkDevice device) :layout(layout), device(device) {}
+		~SharedDescriptorSetLayout();
+
+		VkDescriptorSetLayout layout;
+		VkDevice			  device;
+	};
+
+	struct SharedPipelineLayout
+	{
+		SharedPipelineLayout(VkPipelineLayout layout, const std::vector<ptr<SharedDescriptorSetLayout>>& set_layouts, VkDevice device)
+			:layout(layout), set_layouts(set_layouts), device(device) {}
+		~SharedPipelineLayout();
+
+		VkPipelineLayout layout;
+		//keep the set layouts alive,their handles are part of the cache key
+		std::vector<ptr<SharedDescriptorSetLayout>> set_layouts;
+		VkDevice		 device;
+	};
 	
 	//descriptor set layout is created from 
 	class DescriptorSetLayout {
@@ -14,28 +42,41 @@ namespace gvk {
 		VkDescriptorSetLayout GetLayout();
 		uint32_t GetSetID() ;
 		bool   CreatedFromShader(const gvk::ptr<gvk::Shader>& shader,uint32_t set);
-		View<SpvReflectDescriptorBinding*> GetDescriptorSetBindings();
+		View<const ShaderDescriptorBinding*> GetDescriptorSetBindings();
 
 		VkShaderStageFlags		GetShaderStageBits();
 
 		uint32_t				GetMaxBindlessDescriptorSetCount();
 		bool					IsBindless();
+		bool					IsPushDescriptor();
+
+		//descriptor type of a binding in the layout,uniform/storage buffers declared dynamic
+		//are reported as dynamic buffers instead of the reflected type
+		VkDescriptorType		GetDescriptorType(uint32_t binding);
+		//count of dynamic offsets expected when binding a set of this layout
+		uint32_t				GetDynamicOffsetCount();
 
 		~DescriptorSetLayout();
 	private:
-		DescriptorSetLayout(VkDescriptorSetLayout layout,const std::vector<gvk::ptr<gvk::Shader>>& shaders,
-			const std::vector<SpvReflectDescriptorBinding*>& descriptor_set_bindings,uint32_t sets,VkDevice device,
-			uint32_t maxBindlessBindingCount, bool isBindless);
+		DescriptorSetLayout(const ptr<SharedDescriptorSetLayout>& layout,const std::vector<gvk::ptr<gvk::Shader>>& shaders,
+			const std::vector<const ShaderDescriptorBinding*>& descriptor_set_bindings,uint32_t sets,VkDevice device,
+			uint32_t maxBindlessBindingCount, bool isBindless, bool isPushDescriptor = false,
+			const std::vector<uint32_t>& dynamic_bindings = {});
 		
 		VkShaderStageFlags							m_ShaderStages;
 		VkDescriptorSetLayout						m_Layout;
+		ptr<SharedDescriptorSetLayout>				m_SharedLayout;
 		std::vector<gvk::ptr<gvk::Shader>>			m_Shader;
-		std::vector<SpvReflectDescriptorBinding*>	m_DescriptorSetBindings;
+		std::vector<const ShaderDescriptorBinding*>	m_DescriptorSetBindings;
+		//indexed like m_DescriptorSetBindings
+		std::vector<VkDescriptorType>				m_DescriptorTypes;
+		uint32_t									m_DynamicOffsetCount = 0;
 		uint32_t									m_Set;
 		VkDevice									m_Device;
 
 		uint32_t									m_MaxBindlessBindingCount;
 		bool										m_IsBindless;
+		bool										m_IsPushDescriptor;
 	};
 
 	class RenderPassInlineContent 
@@ -54,6 +95,42 @@ namespace gvk {
 		VkCommandBuffer m_CommandBuffer;
 	};
 
+	//render pass whose subpasses are recorded into secondary command buffers,
+	//which can be recorded by several threads and are executed by the primary command buffer in order
+	class RenderPassSecondaryContent
+	{
+		friend class RenderPass;
+	public:
+		/// <summary>
+		/// Get the inheritance info of the current subpass for beginning secondary command buffers
+		/// </summary>
+		const VkCommandBufferInheritanceInfo* GetInheritanceInfo() const { return &m_Inheritance; }
+
+		/// <summary>
+		/// Viewport and scissor of the render pass.Dynamic states are not inherited,so secondary command buffers set them again
+		/// </summary>
+		const VkViewport&			GetViewport() const { return m_Viewport; }
+		const VkRect2D&				GetScissor() const { return m_Scissor; }
+		VkCommandBuffer				GetCommandBuffer() const { return m_CommandBuffer; }
+
+		/// <summary>
+		/// Execute secondary command buffers in the current subpass in the order of the array
+		/// </summary>
+		RenderPassSecondaryContent& Execute(const VkCommandBuffer* cmd_buffers, uint32_t cmd_buffer_count);
+
+		RenderPassSecondaryContent& NextSubPass();
+		void						EndPass();
+
+	private:
+		RenderPassSecondaryContent(VkRenderPass render_pass, VkFramebuffer framebuffer, VkCommandBuffer command_buffer,
+			VkViewport viewport, VkRect2D scissor);
+
+		VkCommandBufferInheritanceInfo m_Inheritance;
+		VkViewport					   m_Viewport;
+		VkRect2D					   m_Scissor;
+		VkCommandBuffer				   m_CommandBuffer;
+	};
+
 	class RenderPass {
 		friend class Context;
 	public:
@@ -66,6 +143,13 @@ namespace gvk {
 		RenderPassInlineContent	Begin(VkFramebuffer framebuffer,VkClearValue* clear_values,
 			VkRect2D render_area,VkViewport viewport,VkRect2D sissor,VkCommandBuffer command_buffer);
 
+		/// <summary>
+		/// Begin the render pass with the contents of subpasses recorded in secondary command buffers
+		/// </summary>
+		/// <returns>content executing the secondary command buffers,see SecondaryCommandRecorder</returns>
+		RenderPassSecondaryContent BeginSecondary(VkFramebuffer framebuffer, VkClearValue* clear_values,
+			VkRect2D render_area, VkViewport viewport, VkRect2D sissor, VkCommandBuffer command_buffer);
+
 		~RenderPass();
 	private:
 		RenderPass(VkRenderPass render_pass,VkDevice device,uint32_t subpass_count,
@@ -83,6 +167,53 @@ struct GvkDescriptorLayoutHint
 {
 	void AddDescriptorSetLayout(const gvk::ptr<gvk::DescriptorSetLayout>& layout);
 	std::vector<gvk::ptr<gvk::DescriptorSetLayout>> precluded_descriptor_layouts;
+
+	//use the heaps' layouts for set slots first_set,first_set + 1... in the order of GVK_BINDLESS_RESOURCE
+	//instead of creating layouts from shaders
+	void AddBindlessHeap(const gvk::ptr<gvk::BindlessHeap>& heap, uint32_t first_set);
+	//layouts used for set slots regardless of shaders' reflection
+	std::vector<std::pair<uint32_t, gvk::ptr<gvk::DescriptorSetLayout>>> fixed_descriptor_layouts;
+};
+
+//values of specialization constants set by name.
+//a value is applied to every shader stage declaring a specialization constant with the name
+struct GvkSpecializationConstants
+{
+	template<typename T>
+	GvkSpecializationConstants& Set(const char* name, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T> && (sizeof(T) == 4 || sizeof(T) == 8),
+			"specialization constants must be 32 or 64 bit scalars");
+		SetData(name, &value, sizeof(T));
+		return *this;
+	}
+
+	//booleans are 32 bit in SPIR-V
+	GvkSpecializationConstants& Set(const char* name, bool value)
+	{
+		VkBool32 data = value ? VK_TRUE : VK_FALSE;
+		SetData(name, &data, sizeof(data));
+		return *this;
+	}
+
+	/// <summary>
+	/// Fill the specialization info of a shader with the constants it declares.
+	/// The size of every value set must match the size of the constant's type reflected from the shader
+	/// </summary>
+	/// <param name="shader">the shader</param>
+	/// <param name="entries">storage of map entries,it must stay alive until the pipeline is created</param>
+	/// <param name="info">the specialization info to fill</param>
+	/// <returns>pointer to info,NULL if the shader uses none of the constants</returns>
+	const VkSpecializationInfo* Fill(gvk::Shader* shader, std::vector<VkSpecializationMapEntry>& entries, VkSpecializationInfo& info) const;
+
+	bool empty() const { return names.empty(); }
+
+	std::vector<std::string> names;
+	std::vector<uint32_t>	 offsets;
+	std::vector<uint32_t>	 sizes;
+	std::vector<uint8_t>	 data;
+private:
+	void SetData(const char* name, const void* value, uint32_t size);
 };
 
 struct GvkGraphicsPipelineCreateInfo {
@@ -172,6 +303,15 @@ struct GvkGraphicsPipelineCreateInfo {
 
 	gvk::ptr<gvk::RenderPass>	target_pass;
 	uint32_t					subpass_index = 0;
+
+	GvkSpecializationConstants	specialization_constants;
+
+	template<typename T>
+	GvkGraphicsPipelineCreateInfo& SetSpecializationConstant(const char* name, const T& value)
+	{
+		specialization_constants.Set(name, value);
+		return *this;
+	}
 };
 
 
@@ -181,6 +321,15 @@ struct GvkComputePipelineCreateInfo
 
 	GvkDescriptorLayoutHint		descriptor_layuot_hint;
 	uint32_t					max_bindless_binding_count = 1024;
+
+	GvkSpecializationConstants	specialization_constants;
+
+	template<typename T>
+	GvkComputePipelineCreateInfo& SetSpecializationConstant(const char* name, const T& value)
+	{
+		specialization_constants.Set(name, value);
+		return *this;
+	}
 };
 
 struct GvkPipelineCIInitializer
@@ -256,6 +405,7 @@ struct GvkRenderPassCreateInfo : public VkRenderPassCreateInfo
 class GvkPushConstant 
 {
 	friend class Pipeline;
+	friend struct GvkCommandRecorder;
 public:
 	void Update(VkCommandBuffer cmd_buffer,const void* data);
 	
@@ -267,37 +417,100 @@ private:
 };
 
 namespace gvk{
-	//It's recommended that one thread one descriptor allocator
-	class DescriptorAllocator 
+	//It's recommended that one thread one descriptor allocator,
+	//worker threads can use Context::GetThreadDescriptorAllocator.
+	//long-lived sets are recycled through free lists of their layouts after they are released
+	//and the gpu work submitted before the release has finished,
+	//transient sets live in per-frame pools reset at BeginFrame.
+	//new pools are sized by the descriptor usage observed so far
+	class DescriptorAllocator : public std::enable_shared_from_this<DescriptorAllocator>
 	{
 		friend class DescriptorSet;
 		friend class Context;
 	public:
-		
+		/// <summary>
+		/// Allocate a long-lived descriptor set.
+		/// The set keeps the allocator alive.It is reused by later allocations of the same layout
+		/// after it is released and the submissions made before the release have finished
+		/// </summary>
+		/// <param name="layout">layout of the descriptor set</param>
+		/// <returns>allocated descriptor set</returns>
 		opt<ptr<DescriptorSet>> Allocate(ptr<DescriptorSetLayout> layout);
 
-		~DescriptorAllocator();
-
-	private:
-		DescriptorAllocator(VkDevice device, bool rtSupport);
-		void OnBindlessDescriptorSetDestroy(VkDescriptorSet set);
-
-		opt<ptr<DescriptorSet>> AllocateBindless(ptr<DescriptorSetLayout> layout);
-
-		opt<VkDescriptorPool>	CreatePool();
-
-		//TODO : release the descriptor pools that don't used any more
-		std::vector<VkDescriptorPool> m_UsedDescriptorPool;
-		VkDescriptorPool			  m_CurrentDescriptorPool;
-		//	this allocator is self-adaptive, will change the pool size
-		//	according to the last pool
-		std::vector<VkDescriptorPoolSize> m_PoolSize;
+		/// <summary>
+		/// Allocate a descriptor set valid until BeginFrame is called with the current frame index again
+		/// </summary>
+		/// <param name="layout">layout of the descriptor set,bindless layouts are not supported</param>
+		/// <returns>allocated vulkan descriptor set</returns>
+		opt<VkDescriptorSet>	AllocateTransient(ptr<DescriptorSetLayout> layout);
 
+		/// <summary>
+		/// Begin a frame.The transient pools of the frame index are reset wholesale,
+		/// so the gpu work of the last frame using the index must have finished
+		/// </summary>
+		/// <param name="frame_index">index of the frame in flight</param>
+		void					BeginFrame(uint32_t frame_index);
 
-		std::vector<VkDescriptorPool> m_AllocatedBindlessPool;
-		std::vector<VkDescriptorSet>  m_AllocatedBindlessSet;
+		~DescriptorAllocator();
 
-		uint32_t					  m_MaxSetCount;
+	private:
+		DescriptorAllocator(VkDevice device, bool rtSupport, uint32_t frame_count, ptr<ReleaseQueue> release_queue);
+
+		//descriptor count of every descriptor type and count of sets
+		struct PoolUsage
+		{
+			static constexpr uint32_t type_count = 12;
+			uint32_t sets = 0;
+			uint32_t descriptors[type_count] = {};
+
+			void Add(const PoolUsage& usage);
+			void Max(const PoolUsage& usage);
+		};
+
+		struct PoolChain
+		{
+			std::vector<VkDescriptorPool> pools;
+			uint32_t					  current = 0;
+			//usage since the chain is reset
+			PoolUsage					  usage;
+			//the largest usage observed between resets
+			PoolUsage					  peak;
+			VkDescriptorPoolCreateFlags	  flags = 0;
+		};
+
+		struct FreeSets
+		{
+			//keep the layout alive so that its handle is not reused by another layout
+			ptr<DescriptorSetLayout>	 layout;
+			std::vector<VkDescriptorSet> sets;
+		};
+
+		struct ReleasedSet
+		{
+			ptr<DescriptorSetLayout> layout;
+			VkDescriptorSet			 set;
+		};
+
+		PoolUsage				GetLayoutUsage(DescriptorSetLayout* layout);
+		opt<VkDescriptorSet>	AllocateFromChain(PoolChain& chain, DescriptorSetLayout* layout);
+		opt<VkDescriptorPool>	CreatePool(const PoolUsage& usage, VkDescriptorPoolCreateFlags flags);
+		//called by descriptor sets on any thread
+		void					OnDescriptorSetDestroy(const ptr<DescriptorSetLayout>& layout, VkDescriptorSet set);
+		//called by the release queue on any thread once the gpu has finished with the set
+		void					RecycleSet(const ptr<DescriptorSetLayout>& layout, VkDescriptorSet set);
+
+		PoolChain					  m_PersistentPools;
+		PoolChain					  m_BindlessPools;
+		std::vector<PoolChain>		  m_FramePools;
+		uint32_t					  m_FrameIndex = 0;
+
+		std::unordered_map<VkDescriptorSetLayout, FreeSets> m_FreeSets;
+		ptr<ReleaseQueue>			  m_ReleaseQueue;
+		//sets the gpu has finished with,collected into the free lists at BeginFrame
+		std::mutex					  m_ReleaseLock;
+		std::vector<ReleasedSet>	  m_ReleasedSets;
+
+		bool						  m_RtSupport;
 		VkDevice					  m_Device;
 	};
 
@@ -317,7 +530,9 @@ namespace gvk{
 		/// <returns></returns>
 		uint32_t			GetSetIndex();
 
-		opt<SpvReflectDescriptorBinding*> FindBinding(const char* name);
+		ptr<DescriptorSetLayout> GetLayout();
+
+		opt<const ShaderDescriptorBinding*> FindBinding(const char* name);
 
 		void SetDebugName(const std::string& name);
 
@@ -325,17 +540,74 @@ namespace gvk{
 
 	private:
 		// DescriptorSet(VkDevice device,VkDescriptorSet set,ptr<DescriptorSetLayout> layout);
-		DescriptorSet(VkDevice device, VkDescriptorSet set, ptr<DescriptorSetLayout> layout, DescriptorAllocator* alloc);
+		DescriptorSet(VkDevice device, VkDescriptorSet set, ptr<DescriptorSetLayout> layout, ptr<DescriptorAllocator> alloc);
 
 		VkDevice							m_Device;
 		VkDescriptorSet						m_Set;
 		ptr<DescriptorSetLayout>			m_Layout;
-		DescriptorAllocator*				m_Alloc;
+		ptr<DescriptorAllocator>			m_Alloc;
+	};
+
+	//descriptor update template built from the reflected bindings of a descriptor set layout.
+	//the whole set is updated from a packed block of descriptor infos in one call,
+	//one entry per binding in ascending binding order and one element per array element:
+	//VkDescriptorImageInfo for samplers,images and input attachments,
+	//VkDescriptorBufferInfo for uniform and storage buffers,
+	//VkBufferView for texel buffers and VkAccelerationStructureKHR for acceleration structures.
+	//a struct declaring these members in the same order has the same layout as the block
+	class DescriptorUpdateTemplate
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Get the size of the data block consumed by Update
+		/// </summary>
+		/// <returns>size of the data block in bytes</returns>
+		uint32_t		GetDataSize();
+
+		/// <summary>
+		/// Get the offset of a binding in the data block
+		/// </summary>
+		/// <param name="binding">binding index or name of the descriptor</param>
+		/// <returns>offset in bytes,nullopt if the binding is not in the template</returns>
+		opt<uint32_t>	GetOffset(uint32_t binding);
+		opt<uint32_t>	GetOffset(const char* name);
+
+		/// <summary>
+		/// Update all bindings of the set in the template with one vkUpdateDescriptorSetWithTemplate call
+		/// </summary>
+		/// <param name="set">descriptor set allocated from the layout of this template</param>
+		/// <param name="data">data block of GetDataSize() bytes</param>
+		void			Update(VkDescriptorSet set, const void* data);
+
+		template<typename T>
+		void			Update(const ptr<DescriptorSet>& set, const T& data)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "descriptor data must be a plain struct of descriptor infos");
+			gvk_assert(sizeof(T) == m_DataSize);
+			Update(set->GetDescriptorSet(), &data);
+		}
+
+		VkDescriptorUpdateTemplate GetTemplate();
+
+		~DescriptorUpdateTemplate();
+	private:
+		DescriptorUpdateTemplate(VkDescriptorUpdateTemplate update_template, const ptr<DescriptorSetLayout>& layout,
+			std::unordered_map<uint32_t, uint32_t>&& binding_offsets, std::unordered_map<std::string, uint32_t>&& name_offsets,
+			uint32_t data_size, VkDevice device);
+
+		VkDescriptorUpdateTemplate				m_Template;
+		ptr<DescriptorSetLayout>				m_Layout;
+		std::unordered_map<uint32_t, uint32_t>	m_BindingOffsets;
+		std::unordered_map<std::string, uint32_t> m_NameOffsets;
+		uint32_t								m_DataSize;
+		VkDevice								m_Device;
 	};
 
 
 	class Pipeline {
 		friend class Context;
+		friend class ShaderHotReloader;
 	public:
 		opt<ptr<RenderPass>>					GetRenderPass();
 		opt<ptr<DescriptorSetLayout>>			GetInternalLayout(uint32_t set,VkShaderStageFlagBits stage = (VkShaderStageFlagBits)0);
@@ -351,20 +623,54 @@ namespace gvk{
 		
 		virtual ~Pipeline();
 	protected:
-		Pipeline(VkPipeline pipeline, VkPipelineLayout layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string,VkPushConstantRange>& push_constants, 
+		Pipeline(VkPipeline pipeline, const ptr<SharedPipelineLayout>& layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string,VkPushConstantRange>& push_constants, 
 			ptr<RenderPass> render_pass,uint32_t subpass_index,VkPipelineBindPoint bind_point,VkDevice device);
 
+		//exchange the vulkan objects with a pipeline created from the same create info
+		void Swap(Pipeline& other);
+
 
 		VkPipelineBindPoint										m_BindPoint;
 		VkDevice												m_Device;
 		VkPipeline												m_Pipeline;
 		VkPipelineLayout										m_PipelineLayout;
+		ptr<SharedPipelineLayout>								m_SharedPipelineLayout;
 		//descriptor sets not created from layout hints will be created internally
 		std::vector<ptr<DescriptorSetLayout>>					m_InternalDescriptorSetLayouts;
 		std::unordered_map<std::string, VkPushConstantRange>	m_PushConstants;
 		ptr<RenderPass>											m_RenderPass;
 		uint32_t													m_SubpassIndex;
 	};
+
+	//handle of a pipeline being created on worker threads
+	class AsyncPipeline {
+		friend class Context;
+	public:
+		/// <summary>
+		/// Check if the creation of the pipeline is finished,this function never blocks
+		/// </summary>
+		/// <returns>if the pipeline is ready</returns>
+		bool									IsReady();
+
+		/// <summary>
+		/// Block the calling thread until the creation of the pipeline finishes
+		/// </summary>
+		/// <returns>created pipeline,nullopt if the creation fails</returns>
+		opt<ptr<Pipeline>>						Wait();
+
+		/// <summary>
+		/// Get the pipeline if it is ready,otherwise return the placeholder.
+		/// The placeholder is also returned if the creation fails
+		/// </summary>
+		/// <param name="placeholder">pipeline used before the real one is ready</param>
+		/// <returns>the created pipeline or the placeholder</returns>
+		ptr<Pipeline>							GetOr(const ptr<Pipeline>& placeholder);
+
+	private:
+		AsyncPipeline(std::shared_future<opt<ptr<Pipeline>>> future);
+
+		std::shared_future<opt<ptr<Pipeline>>>	m_Future;
+	};
 	
 }
 
@@ -417,19 +723,62 @@ struct GvkDescriptorSetWrite
 	void				   Emit(VkDevice device);
 };
 
-//TODO currently we don't support dynamic offset
+//descriptors pushed into a command buffer by vkCmdPushDescriptorSetKHR.
+//the layout of the set should be created with push_descriptor,no descriptor set or pool is involved.
+//writes are stored in fixed arrays,so recording a small per-draw set never allocates
+struct GvkPushDescriptorSet
+{
+	static constexpr uint32_t max_write_count = 32;
+
+	GvkPushDescriptorSet(VkCommandBuffer cmd_buffer, gvk::ptr<gvk::Pipeline> pipeline, gvk::ptr<gvk::DescriptorSetLayout> layout);
+
+	GvkPushDescriptorSet& BufferWrite(VkDescriptorType descriptor_type, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t array_index = 0);
+	GvkPushDescriptorSet& ImageWrite(VkDescriptorType descriptor_type, uint32_t binding, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout, uint32_t array_index = 0);
+
+	GvkPushDescriptorSet& BufferWrite(const char* name, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t array_index = 0);
+	GvkPushDescriptorSet& ImageWrite(const char* name, VkSampler sampler, VkImageView image_view, VkImageLayout image_layout, uint32_t array_index = 0);
+
+	GvkPushDescriptorSet& AccelerationStructureWrite(uint32_t binding, VkAccelerationStructureKHR tlas);
+
+	//record all writes into the command buffer,the writes are cleared afterwards
+	void				  Push();
+
+	VkCommandBuffer		cmd_buffer;
+	VkPipelineBindPoint bind_point;
+	VkPipelineLayout	pipeline_layout;
+	gvk::ptr<gvk::DescriptorSetLayout> layout;
+
+	uint32_t			write_count = 0;
+	std::array<VkWriteDescriptorSet, max_write_count> writes;
+	//infos referenced by writes,indexed by the index of the write
+	std::array<VkDescriptorBufferInfo, max_write_count> buffer_infos;
+	std::array<VkDescriptorImageInfo, max_write_count> image_infos;
+	std::array<VkAccelerationStructureKHR, max_write_count> acceleration_structures;
+	std::array<VkWriteDescriptorSetAccelerationStructureKHR, max_write_count> acceleration_structure_writes;
+};
+
 //we assume count of descriptor set wouldn't greater than 16
+//sets are bound in the order of their set index,consecutive sets are bound by one call
 struct GvkDescriptorSetBindingUpdate
 {
+	static constexpr uint32_t max_dynamic_offset_count = 32;
+
 	GvkDescriptorSetBindingUpdate(VkCommandBuffer cmd_buffer, gvk::ptr<gvk::Pipeline> pipeline);
 
 	GvkDescriptorSetBindingUpdate& BindDescriptorSet(gvk::ptr<gvk::DescriptorSet> set);
+	//the offsets are ordered by binding number and array element,
+	//their count should match the dynamic offset count of the set's layout
+	GvkDescriptorSetBindingUpdate& BindDescriptorSet(gvk::ptr<gvk::DescriptorSet> set, gvk::View<uint32_t> dynamic_offsets);
 
 	void Update();
 
 	gvk::uint32 descriptor_set_count;
 
 	std::array<gvk::ptr<gvk::DescriptorSet>,16>  target_sets;
+	//dynamic offsets of target_sets[i] start at dynamic_offset_starts[i]
+	std::array<uint32_t, 16>	dynamic_offset_starts;
+	std::array<uint32_t, max_dynamic_offset_count> dynamic_offsets;
+	uint32_t					dynamic_offset_count = 0;
 	VkPipelineLayout layout;
 	VkPipelineBindPoint bind_point;
 	VkCommandBuffer cmd_buffer;
@@ -87,7 +87,7 @@ namespace gvk
 	}
 
 
-	RaytracingPipeline::RaytracingPipeline(VkPipeline pipeline, VkPipelineLayout layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string, VkPushConstantRange>& push_constants,
+	RaytracingPipeline::RaytracingPipeline(VkPipeline pipeline, const ptr<SharedPipelineLayout>& layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string, VkPushConstantRange>& push_constants,
 		ptr<RenderPass> render_pass, uint32_t subpass_index, VkPipelineBindPoint bind_point, VkDevice device,const RayTracingPieplineCreateInfo& createInfo)
 		:Pipeline(pipeline, layout, descriptor_set_layouts, push_constants, render_pass, subpass_index, bind_point, device)
 	{
@@ -228,7 +228,7 @@ namespace gvk
 		vkCmdBuildAccelerationStructuresKHR(cmd, 1, &asGI, ranges);
 			}, gvk::SemaphoreInfo::None(), NULL, true
 				);
-		return std::make_shared<TopAccelerationStructure>(this, accelS, topAsInfo.GetData(), topAsInfo.size(), accelStructBuffer);
+		return WrapDeferredRelease(new TopAccelerationStructure(this, accelS, topAsInfo.GetData(), topAsInfo.size(), accelStructBuffer));
 	}
 
 	static uint32_t GetIndexTypeSize(VkIndexType type)
@@ -337,7 +337,7 @@ namespace gvk
 				vkCmdBuildAccelerationStructuresKHR(cmd, 1, &asGI, ranges);
 			}, gvk::SemaphoreInfo::None(), NULL, true
 				);
-		return std::make_shared<BottomAccelerationStructure>(this, accelS, bottomASInfo.GetData(), bottomASInfo.size(), accelStructBuffer);
+		return WrapDeferredRelease(new BottomAccelerationStructure(this, accelS, bottomASInfo.GetData(), bottomASInfo.size(), accelStructBuffer));
 	}
 
 
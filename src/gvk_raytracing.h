@@ -41,6 +41,15 @@ namespace gvk
 		uint32_t AddRayMissShader(ptr<Shader> rayMiss);
 		uint32_t AddRayIntersectionShader(ptr<Shader> intersection, ptr<Shader> anyHit, ptr<Shader> closestHit);
 		void SetMaxRecursiveDepth(uint32_t depth);
+
+		GvkSpecializationConstants specializationConstants;
+
+		template<typename T>
+		RayTracingPieplineCreateInfo& SetSpecializationConstant(const char* name, const T& value)
+		{
+			specializationConstants.Set(name, value);
+			return *this;
+		}
 	};
 
 
@@ -121,7 +130,7 @@ namespace gvk
 		void							TraceRay(VkCommandBuffer cmd, uint32_t dispatchX, uint32_t dispatchY, uint32_t dispatchZ);
 
 	private:
-		RaytracingPipeline(VkPipeline pipeline, VkPipelineLayout layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string, VkPushConstantRange>& push_constants,
+		RaytracingPipeline(VkPipeline pipeline, const ptr<SharedPipelineLayout>& layout, const std::vector<ptr<DescriptorSetLayout>>& descriptor_set_layouts, const std::unordered_map<std::string, VkPushConstantRange>& push_constants,
 			ptr<RenderPass> render_pass, uint32_t subpass_index, VkPipelineBindPoint bind_point, VkDevice device,const RayTracingPieplineCreateInfo& createInfo);
 
 		RayTracingPieplineCreateInfo  m_Info;
@@ -0,0 +1,149 @@
+#include "gvk_release.h"
+#include "gvk_command.h"
+#include "gvk_context.h"
+#include <algorithm>
+
+namespace gvk {
+
+	void ReleaseQueue::Release(std::function<void()> release)
+	{
+		bool closed;
+		{
+			std::lock_guard lock(m_Lock);
+			closed = m_Closed;
+			if (!closed)
+			{
+				PendingRelease pending;
+				pending.submissions = CollectUnfinishedSubmissions();
+				pending.release = std::move(release);
+				m_Pending.push_back(std::move(pending));
+			}
+		}
+		//the device is gone or going,there is no gpu work to wait for
+		if (closed)
+		{
+			release();
+			return;
+		}
+		Collect();
+	}
+
+	uint32_t ReleaseQueue::Collect()
+	{
+		std::vector<std::function<void()>> releases;
+		{
+			std::lock_guard lock(m_Lock);
+			while (!m_Pending.empty())
+			{
+				auto& submissions = m_Pending.front().submissions;
+				bool complete = true;
+				for (auto& [queue, submission] : submissions)
+				{
+					if (!queue->IsComplete(submission))
+					{
+						complete = false;
+						break;
+					}
+				}
+				if (!complete)
+				{
+					break;
+				}
+				releases.push_back(std::move(m_Pending.front().release));
+				m_Pending.pop_front();
+			}
+		}
+		//destructors may release other objects,so they run without the lock
+		for (auto& release : releases)
+		{
+			release();
+		}
+		return releases.size();
+	}
+
+	void ReleaseQueue::Flush()
+	{
+		while (true)
+		{
+			std::deque<PendingRelease> pending;
+			{
+				std::lock_guard lock(m_Lock);
+				pending.swap(m_Pending);
+			}
+			//releases performed may enqueue the objects they own
+			if (pending.empty())
+			{
+				return;
+			}
+			for (auto& item : pending)
+			{
+				item.release();
+			}
+		}
+	}
+
+	uint32_t ReleaseQueue::GetPendingCount()
+	{
+		std::lock_guard lock(m_Lock);
+		return m_Pending.size();
+	}
+
+	std::vector<std::pair<CommandQueue*, uint64_t>> ReleaseQueue::GetUnfinishedSubmissions()
+	{
+		std::lock_guard lock(m_Lock);
+		return CollectUnfinishedSubmissions();
+	}
+
+	std::vector<std::pair<CommandQueue*, uint64_t>> ReleaseQueue::CollectUnfinishedSubmissions()
+	{
+		std::vector<std::pair<CommandQueue*, uint64_t>> submissions;
+		for (auto queue : m_Queues)
+		{
+			uint64_t submission = queue->LastSubmission();
+			//nothing waits for queues having finished their work
+			if (!queue->IsComplete(submission))
+			{
+				submissions.push_back(std::make_pair(queue, submission));
+			}
+		}
+		return submissions;
+	}
+
+	void ReleaseQueue::AddQueue(CommandQueue* queue)
+	{
+		std::lock_guard lock(m_Lock);
+		m_Queues.push_back(queue);
+	}
+
+	void ReleaseQueue::RemoveQueue(CommandQueue* queue)
+	{
+		std::lock_guard lock(m_Lock);
+		m_Queues.erase(std::remove(m_Queues.begin(), m_Queues.end(), queue), m_Queues.end());
+		for (auto& pending : m_Pending)
+		{
+			auto& submissions = pending.submissions;
+			submissions.erase(std::remove_if(submissions.begin(), submissions.end(),
+				[queue](const std::pair<CommandQueue*, uint64_t>& submission) { return submission.first == queue; }),
+				submissions.end());
+		}
+	}
+
+	void ReleaseQueue::Close()
+	{
+		{
+			std::lock_guard lock(m_Lock);
+			m_Closed = true;
+		}
+		Flush();
+	}
+
+	ReleaseQueue::~ReleaseQueue()
+	{
+		Flush();
+	}
+
+	ptr<ReleaseQueue> Context::GetReleaseQueue()
+	{
+		return m_ReleaseQueue;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "gvk_common.h"
+#include <functional>
+#include <mutex>
+#include <deque>
+
+namespace gvk {
+
+	class CommandQueue;
+
+	//objects dropped by the application wait here until the gpu work submitted before the drop has finished.
+	//a release records the last submission of every command queue of the context,
+	//it is performed once every queue's timeline semaphore has passed the recorded value.
+	//buffers,images,pipelines and acceleration structures created by Context are released through it
+	//when their last reference drops,so they can be dropped while the gpu may still use them
+	class ReleaseQueue
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Run a callback after every submission made before the call has finished.Thread safe
+		/// </summary>
+		/// <param name="release">destroys the objects</param>
+		void		Release(std::function<void()> release);
+
+		/// <summary>
+		/// Keep an object alive until every submission made before the call has finished
+		/// </summary>
+		template<typename T>
+		void		Release(ptr<T> object)
+		{
+			Release([object]() {});
+		}
+
+		/// <summary>
+		/// Perform the releases whose submissions have finished.
+		/// Called by Release and Context::AcquireNextImage,thread safe
+		/// </summary>
+		/// <returns>count of the releases performed</returns>
+		uint32_t	Collect();
+
+		/// <summary>
+		/// Perform every release without waiting.
+		/// The gpu must not use the objects any more,e.g. after vkDeviceWaitIdle
+		/// </summary>
+		void		Flush();
+
+		/// <summary>
+		/// Count of the releases waiting for the gpu
+		/// </summary>
+		uint32_t	GetPendingCount();
+
+		~ReleaseQueue();
+	private:
+		ReleaseQueue() = default;
+
+		void		AddQueue(CommandQueue* queue);
+		//the queue has waited for its submissions,releases no longer wait for it
+		void		RemoveQueue(CommandQueue* queue);
+		//flush and perform later releases immediately,called when the context is destroyed
+		void		Close();
+		//the last submission of every queue that has not finished
+		std::vector<std::pair<CommandQueue*, uint64_t>> GetUnfinishedSubmissions();
+		//called with the lock held
+		std::vector<std::pair<CommandQueue*, uint64_t>> CollectUnfinishedSubmissions();
+
+		struct PendingRelease
+		{
+			//last submission of every queue when the release is enqueued
+			std::vector<std::pair<CommandQueue*, uint64_t>> submissions;
+			std::function<void()> release;
+		};
+
+		std::mutex					m_Lock;
+		std::vector<CommandQueue*>	m_Queues;
+		//submission values never decrease,so releases complete in the order they are enqueued
+		std::deque<PendingRelease>	m_Pending;
+		bool						m_Closed = false;
+	};
+}
@@ -0,0 +1,212 @@
+#include "gvk_render_queue.h"
+#include "gvk_command.h"
+
+namespace gvk {
+
+	//buckets smaller than this are sorted by comparison
+	static constexpr uint32 g_radix_sort_threshold = 256;
+
+	uint64_t RenderQueue::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth)
+	{
+		gvk_assert(pass < (1u << pass_bits));
+		gvk_assert(pipeline < (1u << pipeline_bits));
+		gvk_assert(material < (1u << material_bits));
+		gvk_assert(depth < (1u << depth_bits));
+		return ((uint64_t)pass << (pipeline_bits + material_bits + depth_bits)) |
+			((uint64_t)pipeline << (material_bits + depth_bits)) |
+			((uint64_t)material << depth_bits) |
+			(uint64_t)depth;
+	}
+
+	uint32_t RenderQueue::QuantizeDepth(float depth, float near_plane, float far_plane, bool back_to_front)
+	{
+		float t = (depth - near_plane) / (far_plane - near_plane);
+		t = std::min(std::max(t, 0.0f), 1.0f);
+		if (back_to_front) t = 1.0f - t;
+		uint32_t max_depth = (1u << depth_bits) - 1;
+		return (uint32_t)(t * max_depth);
+	}
+
+	uint32_t RenderQueue::AddPipeline(const ptr<Pipeline>& pipeline)
+	{
+		gvk_assert(m_Pipelines.size() < (1u << pipeline_bits));
+		m_Pipelines.push_back(pipeline);
+		return m_Pipelines.size() - 1;
+	}
+
+	uint32_t RenderQueue::AddMaterial(const std::vector<ptr<DescriptorSet>>& sets)
+	{
+		gvk_assert(m_Materials.size() < (1u << material_bits));
+		m_Materials.push_back(sets);
+		return m_Materials.size() - 1;
+	}
+
+	void RenderQueue::Submit(uint64_t key, uint32_t payload)
+	{
+		m_Items.push_back(Item{ key, payload });
+	}
+
+	void RenderQueue::Submit(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth, uint32_t payload)
+	{
+		Submit(MakeKey(pass, pipeline, material, depth), payload);
+	}
+
+	void RenderQueue::Sort(ThreadPool* pool)
+	{
+		m_Buckets.clear();
+		m_Scratch.resize(m_Items.size());
+		if (m_Items.empty())
+		{
+			return;
+		}
+
+		//counting sort by pass splits the items into buckets
+		constexpr uint32 pass_shift = 64 - pass_bits;
+		std::array<uint32, bucket_count> counts{};
+		for (auto& item : m_Items)
+		{
+			counts[item.key >> pass_shift]++;
+		}
+		std::array<uint32, bucket_count> offsets;
+		uint32 offset = 0;
+		for (uint32 i = 0; i < bucket_count; i++)
+		{
+			offsets[i] = offset;
+			if (counts[i] != 0)
+			{
+				m_Buckets.push_back(Bucket{ i, offset, offset + counts[i] });
+			}
+			offset += counts[i];
+		}
+		for (auto& item : m_Items)
+		{
+			m_Scratch[offsets[item.key >> pass_shift]++] = item;
+		}
+		std::swap(m_Items, m_Scratch);
+
+		//buckets touch disjoint ranges of the items
+		if (pool != nullptr && m_Buckets.size() > 1)
+		{
+			std::vector<std::future<void>> tasks;
+			for (uint32 i = 1; i < m_Buckets.size(); i++)
+			{
+				tasks.push_back(pool->Submit([this, i]() { SortBucket(m_Buckets[i]); }));
+			}
+			SortBucket(m_Buckets[0]);
+			for (auto& task : tasks)
+			{
+				pool->Wait(task);
+			}
+		}
+		else
+		{
+			for (auto& bucket : m_Buckets)
+			{
+				SortBucket(bucket);
+			}
+		}
+	}
+
+	void RenderQueue::SortBucket(const Bucket& bucket)
+	{
+		Item* items = m_Items.data() + bucket.begin;
+		Item* scratch = m_Scratch.data() + bucket.begin;
+		uint32 count = bucket.end - bucket.begin;
+
+		if (count < g_radix_sort_threshold)
+		{
+			std::stable_sort(items, items + count, [](const Item& lhs, const Item& rhs) { return lhs.key < rhs.key; });
+			return;
+		}
+
+		//least significant digit first,the pass byte is equal in a bucket
+		constexpr uint32 digit_count = (64 - pass_bits) / 8;
+		for (uint32 digit = 0; digit < digit_count; digit++)
+		{
+			uint32 shift = digit * 8;
+			std::array<uint32, 256> counts{};
+			for (uint32 i = 0; i < count; i++)
+			{
+				counts[(items[i].key >> shift) & 0xff]++;
+			}
+			//digits shared by every key don't change the order
+			if (counts[(items[0].key >> shift) & 0xff] == count)
+			{
+				continue;
+			}
+
+			uint32 offset = 0;
+			for (auto& c : counts)
+			{
+				uint32 n = c;
+				c = offset;
+				offset += n;
+			}
+			for (uint32 i = 0; i < count; i++)
+			{
+				scratch[counts[(items[i].key >> shift) & 0xff]++] = items[i];
+			}
+			std::swap(items, scratch);
+		}
+
+		//the result ends in the scratch buffer after an odd count of passes
+		if (items != m_Items.data() + bucket.begin)
+		{
+			memcpy(m_Items.data() + bucket.begin, items, count * sizeof(Item));
+		}
+	}
+
+	View<RenderQueue::Bucket> RenderQueue::GetBuckets()
+	{
+		return View<Bucket>(m_Buckets);
+	}
+
+	void RenderQueue::Record(VkCommandBuffer cmd, const Bucket& bucket, const std::function<void(VkCommandBuffer, uint32_t)>& draw)
+	{
+		constexpr uint32 pipeline_shift = material_bits + depth_bits;
+		constexpr uint32 material_shift = depth_bits;
+
+		uint32 current_pipeline = UINT32_MAX;
+		uint32 current_material = UINT32_MAX;
+		for (uint32 i = bucket.begin; i < bucket.end; i++)
+		{
+			const Item& item = m_Items[i];
+			uint32 pipeline = (item.key >> pipeline_shift) & ((1u << pipeline_bits) - 1);
+			uint32 material = (item.key >> material_shift) & ((1u << material_bits) - 1);
+			gvk_assert(pipeline < m_Pipelines.size());
+
+			if (pipeline != current_pipeline)
+			{
+				GvkBindPipeline(cmd, m_Pipelines[pipeline]);
+				current_pipeline = pipeline;
+				//the sets are bound with the layout of the new pipeline
+				current_material = UINT32_MAX;
+			}
+			if (material != current_material && material < m_Materials.size() && !m_Materials[material].empty())
+			{
+				GvkDescriptorSetBindingUpdate update(cmd, m_Pipelines[pipeline]);
+				for (auto& set : m_Materials[material])
+				{
+					update.BindDescriptorSet(set);
+				}
+				update.Update();
+			}
+			current_material = material;
+
+			draw(cmd, item.payload);
+		}
+	}
+
+	void RenderQueue::Reset()
+	{
+		m_Items.clear();
+		m_Buckets.clear();
+	}
+
+	void RenderQueue::Clear()
+	{
+		Reset();
+		m_Pipelines.clear();
+		m_Materials.clear();
+	}
+}
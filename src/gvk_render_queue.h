@@ -0,0 +1,107 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_pipeline.h"
+#include "gvk_job.h"
+#include <functional>
+
+namespace gvk {
+
+	//draws submitted as 64 bit sort keys and a payload index,recorded in the order of the keys.
+	//from the highest bits a key is made of
+	//  pass 8 bits | pipeline 16 bits | material 16 bits | depth 24 bits
+	//so draws of a pass sharing a pipeline and then a material are recorded next to each other.
+	//pipelines and materials are registered in the queue and referenced by their ids in the keys.
+	//every pass is a bucket,buckets are sorted in parallel and can be recorded by different threads
+	class RenderQueue
+	{
+	public:
+		static constexpr uint32_t pass_bits = 8;
+		static constexpr uint32_t pipeline_bits = 16;
+		static constexpr uint32_t material_bits = 16;
+		static constexpr uint32_t depth_bits = 24;
+		static constexpr uint32_t bucket_count = 1u << pass_bits;
+
+		struct Item
+		{
+			uint64_t key;
+			//index of the draw in the caller's data,passed back when the draw is recorded
+			uint32_t payload;
+		};
+
+		//draws of a pass in the sorted items
+		struct Bucket
+		{
+			uint32_t pass;
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		static uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth);
+
+		/// <summary>
+		/// Quantize view depth into the depth bits of a key
+		/// </summary>
+		/// <param name="depth">view depth of the draw</param>
+		/// <param name="near_plane">depth mapped to 0</param>
+		/// <param name="far_plane">depth mapped to the max value</param>
+		/// <param name="back_to_front">reverse the order,for transparent draws</param>
+		static uint32_t QuantizeDepth(float depth, float near_plane, float far_plane, bool back_to_front = false);
+
+		/// <summary>
+		/// Register a pipeline,the id is used as the pipeline field of keys
+		/// </summary>
+		uint32_t		AddPipeline(const ptr<Pipeline>& pipeline);
+
+		/// <summary>
+		/// Register the descriptor sets of a material,the id is used as the material field of keys.
+		/// The sets are bound with the layout of the pipeline of the draw and without dynamic offsets,
+		/// draws with material ids not registered bind no descriptor sets
+		/// </summary>
+		uint32_t		AddMaterial(const std::vector<ptr<DescriptorSet>>& sets);
+
+		void			Submit(uint64_t key, uint32_t payload);
+		void			Submit(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t depth, uint32_t payload);
+
+		/// <summary>
+		/// Sort the submitted draws.Draws with equal keys keep the order they are submitted in
+		/// </summary>
+		/// <param name="pool">if not null,buckets are sorted by worker threads of the pool</param>
+		void			Sort(ThreadPool* pool = nullptr);
+
+		/// <summary>
+		/// Get the non-empty buckets after Sort,in the order of passes
+		/// </summary>
+		View<Bucket>	GetBuckets();
+
+		/// <summary>
+		/// Record the draws of a bucket.Pipelines and materials are bound only when they change,
+		/// then draw is called to record the draw of the payload.
+		/// Different buckets can be recorded into different command buffers at the same time
+		/// </summary>
+		/// <param name="cmd">command buffer to record into</param>
+		/// <param name="bucket">bucket returned by GetBuckets</param>
+		/// <param name="draw">records the draw command of a payload</param>
+		void			Record(VkCommandBuffer cmd, const Bucket& bucket, const std::function<void(VkCommandBuffer, uint32_t)>& draw);
+
+		/// <summary>
+		/// Clear submitted draws,registered pipelines and materials are kept
+		/// </summary>
+		void			Reset();
+
+		/// <summary>
+		/// Clear submitted draws,pipelines and materials
+		/// </summary>
+		void			Clear();
+
+	private:
+		void			SortBucket(const Bucket& bucket);
+
+		std::vector<ptr<Pipeline>>					m_Pipelines;
+		std::vector<std::vector<ptr<DescriptorSet>>> m_Materials;
+
+		std::vector<Item>	m_Items;
+		//scratch buffer of radix sort
+		std::vector<Item>	m_Scratch;
+		std::vector<Bucket> m_Buckets;
+	};
+}
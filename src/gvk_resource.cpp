@@ -13,6 +13,7 @@ namespace gvk {
 		info.device = m_Device;
 		//for vkGetBufferDeviceAddress 
 		info.flags = addressable ? VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT : 0;
+		//VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT is not set,buffers and images are created from several threads
 		info.vulkanApiVersion = vk_api_version;
 		info.physicalDevice = m_PhyDevice;
 		info.pVulkanFunctions = &funcs;
@@ -67,7 +68,7 @@ namespace gvk {
 
 		bool addressable = (buffer_usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ==
 			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-		return ptr<Buffer>(new Buffer(write, buffer, alloc, mapped_data, m_Allocator, size, addressable,m_Device));
+		return WrapDeferredRelease(new Buffer(write, buffer, alloc, mapped_data, m_Allocator, size, addressable,m_Device));
 	}
 
 	void Buffer::Write(const void* data, uint64_t dst_offset, uint64_t size)
@@ -182,7 +183,7 @@ namespace gvk {
 			return std::nullopt;
 		}
 
-		return ptr<Image>(new Image(image, alloc, m_Allocator,m_Device,info));
+		return WrapDeferredRelease(new Image(image, alloc, m_Allocator,m_Device,info));
 	}
 
 	VkImage Image::GetImage()
@@ -214,6 +215,8 @@ namespace gvk {
 		range.range.layerCount = layerCount;
 		range.type = type;
 
+		//held until the view is staged,so threads asking for the same range share one view
+		std::lock_guard lock(m_ViewLock);
 		if (auto res = m_ViewTable.find(range);res != m_ViewTable.end()) 
 		{
 			//return the image view already created
@@ -261,7 +264,11 @@ namespace gvk {
 
 	void Image::SetDebugName(const std::string& name)
 	{
-		debug_name = name;
+		{
+			//read by CreateView to name the views
+			std::lock_guard lock(m_ViewLock);
+			debug_name = name;
+		}
 
 		VkDebugMarkerObjectNameInfoEXT info{};
 		info.sType = VK_STRUCTURE_TYPE_DEBUG_MARKER_OBJECT_NAME_INFO_EXT;
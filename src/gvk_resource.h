@@ -1,6 +1,7 @@
 #pragma once
 #include "gvk_common.h"
 #include <unordered_map>
+#include <mutex>
 #include <vma/vk_mem_alloc.h>
 
 
@@ -207,7 +208,8 @@ namespace gvk {
 		/// <summary>
 		/// Create a image view for a subresource range.
 		/// Every image view created from image is staged, so you don't have to release it.
-		/// If the range matches the range of a staged view, the staged view will be returned
+		/// If the range matches the range of a staged view, the staged view will be returned.
+		/// Thread safe
 		/// </summary>
 		/// <param name="aspectMask">the aspect mask for the view</param>
 		/// <param name="baseMipLevel">the start of the mip level of the view</param>
@@ -223,6 +225,9 @@ namespace gvk {
 		uint32_t              layerCount,
 		VkImageViewType       type);
 
+		/// <summary>
+		/// Get the staged views.Not thread safe with CreateView
+		/// </summary>
 		View<VkImageView> GetViews();
 
 		void			  SetDebugName(const std::string& name);
@@ -241,6 +246,8 @@ namespace gvk {
 		std::unordered_map<GvkImageSubresourceRange, VkImageView> m_ViewTable;
 		std::vector<VkImageView> m_Views;
 		std::string debug_name = "";
+		//guards the staged views and the debug name
+		std::mutex  m_ViewLock;
 	};
 
 	void ImageViewSetDebugName(VkImageView view,VkDevice device,const std::string& name);
@@ -3,21 +3,48 @@
 #ifdef GVK_WINDOWS_PLATFORM
 #include <Windows.h>
 
-gvk::opt<int32_t> LauchProcess(const char* process,const char* options) {
-	gvk::uint32 process_len = strlen(process), option_len = strlen(options);
-	char buffer[1024];
-	strcpy(buffer, process);
-	strcat(buffer, options);
+//quote an argument so that CommandLineToArgvW splits it back into the same string
+static std::string QuoteArgument(const std::string& arg)
+{
+	std::string quoted = "\"";
+	uint32_t backslashes = 0;
+	for (char c : arg)
+	{
+		if (c == '\\')
+		{
+			backslashes++;
+			continue;
+		}
+		//backslashes before a quote escape each other,the quote itself is escaped too
+		quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+		backslashes = 0;
+		quoted.push_back(c);
+	}
+	//backslashes before the closing quote
+	quoted.append(backslashes * 2, '\\');
+	quoted.push_back('"');
+	return quoted;
+}
+
+gvk::opt<int32_t> LauchProcess(const char* process,const std::vector<std::string>& args) {
+	std::string command_line = QuoteArgument(process);
+	for (auto& arg : args)
+	{
+		command_line += " " + QuoteArgument(arg);
+	}
 
-	STARTUPINFO si;
+	STARTUPINFOA si;
 	PROCESS_INFORMATION pi;
 
 	gvk_zero_mem(si);
 	gvk_zero_mem(pi);
+	si.cb = sizeof(si);
 
-	if (!CreateProcessA(NULL,buffer,NULL,NULL,false,0,NULL,NULL,&si, &pi)) 
+	//the command line passed to CreateProcessA must be writable
+	std::vector<char> buffer(command_line.begin(), command_line.end());
+	buffer.push_back('\0');
+	if (!CreateProcessA(NULL,buffer.data(),NULL,NULL,false,0,NULL,NULL,&si, &pi)) 
 	{
-		printf("fail to create process glslc\n");
 		return std::nullopt;
 	}
 
@@ -30,16 +57,67 @@ gvk::opt<int32_t> LauchProcess(const char* process,const char* options) {
 	return (int32_t)value;
 }
 
+#else
+#include <spawn.h>
+#include <cerrno>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern char** environ;
+
+gvk::opt<int32_t> LauchProcess(const char* process, const std::vector<std::string>& args) {
+	//arguments are passed to the process as they are,no shell parses them
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(process));
+	for (auto& arg : args)
+	{
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	}
+	argv.push_back(nullptr);
+
+	pid_t pid;
+	if (posix_spawnp(&pid, process, nullptr, nullptr, argv.data(), environ) != 0)
+	{
+		return std::nullopt;
+	}
+
+	int status = 0;
+	while (waitpid(pid, &status, 0) == -1)
+	{
+		if (errno != EINTR)
+		{
+			return std::nullopt;
+		}
+	}
+	if (!WIFEXITED(status))
+	{
+		return std::nullopt;
+	}
+	return (int32_t)WEXITSTATUS(status);
+}
+
+#endif
+
+#ifdef GVK_SHADERC_COMPILER
+#include <shaderc/shaderc.hpp>
 #endif
 
 #include <filesystem>
 namespace fs = std::filesystem;
 #include <fstream>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace gvk {
 
-	Shader::Shader(void* byte_code, uint64_t byte_code_size, VkShaderStageFlagBits stage, const std::string& name) :m_ByteCode(byte_code),
-		m_ByteCodeSize(byte_code_size), m_Stage(stage), m_Device(NULL), m_ShaderModule(NULL), m_Name(name) {}
+	Shader::Shader(ptr<void> byte_code, uint64_t byte_code_size, VkShaderStageFlagBits stage, const std::string& name) :m_ByteCode(byte_code),
+		m_ByteCodeSize(byte_code_size), m_Stage(stage), m_Device(NULL), m_ShaderModule(NULL), m_Name(name), m_Reflection(nullptr) {}
 
 	static opt<fs::path> SearchUnderPathes(const char* file, const char** search_pathes, uint32 search_path_count) {
 		fs::path p(file);
@@ -77,39 +155,839 @@ namespace gvk {
 		std::string target_spv;
 	};
 
+	static opt<std::vector<char>> ReadWholeFile(const std::string& file)
+	{
+		std::ifstream stream(file, std::ios::ate | std::ios::binary);
+		if (!stream.is_open())
+		{
+			return std::nullopt;
+		}
+		std::vector<char> data((size_t)stream.tellg());
+		stream.seekg(0, std::ios::beg);
+		stream.read(data.data(), data.size());
+		return std::move(data);
+	}
+
+	//the binary is written to a temporary file first so that shaders compiled
+	//from the same source on several threads never observe a half written file
+	static bool WriteBinaryFile(const std::string& file, const void* data, size_t size)
+	{
+		std::string temp_file = file + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream stream(temp_file, std::ios::binary | std::ios::trunc);
+			if (!stream.is_open())
+			{
+				return false;
+			}
+			stream.write((const char*)data, size);
+			if (!stream.good())
+			{
+				return false;
+			}
+		}
+		std::error_code ec;
+		fs::rename(temp_file, file, ec);
+		if (ec)
+		{
+			fs::remove(temp_file, ec);
+			return false;
+		}
+		return true;
+	}
+
+	static bool WriteSpirvFile(const std::string& file, const std::vector<uint32_t>& code)
+	{
+		return WriteBinaryFile(file, code.data(), code.size() * sizeof(uint32_t));
+	}
+
+#ifdef GVK_SHADERC_COMPILER
+
+	struct ShaderIncludeResult : public shaderc_include_result
+	{
+		std::string name;
+		std::string data;
+	};
+
+	//resolves #include like glslc does,relative includes are searched beside
+	//the including file first and then in the include directories
+	class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+		ShaderIncluder(const std::vector<std::string>& include_directories)
+			:m_IncludeDirectories(include_directories) {}
+
+		shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type,
+			const char* requesting_source, size_t include_depth) override
+		{
+			std::vector<fs::path> candidates;
+			if (type == shaderc_include_type_relative)
+			{
+				candidates.push_back(fs::path(requesting_source).parent_path() / requested_source);
+			}
+			for (auto& directory : m_IncludeDirectories)
+			{
+				candidates.push_back(fs::path(directory) / requested_source);
+			}
+
+			ShaderIncludeResult* result = new ShaderIncludeResult();
+			for (auto& candidate : candidates)
+			{
+				if (auto data = ReadWholeFile(candidate.string()))
+				{
+					result->name = candidate.string();
+					result->data.assign(data.value().begin(), data.value().end());
+					break;
+				}
+			}
+			//an empty source name tells shaderc the include failed,the content is the error message
+			if (result->name.empty())
+			{
+				result->data = "fail to find include file " + std::string(requested_source);
+			}
+
+			result->source_name = result->name.c_str();
+			result->source_name_length = result->name.size();
+			result->content = result->data.c_str();
+			result->content_length = result->data.size();
+			result->user_data = NULL;
+			return result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* data) override
+		{
+			delete static_cast<ShaderIncludeResult*>(data);
+		}
+	private:
+		std::vector<std::string> m_IncludeDirectories;
+	};
+
+	static shaderc_shader_kind GetShaderKind(const std::string& stage)
+	{
+		static const std::unordered_map<std::string, shaderc_shader_kind> kinds = {
+			{"vert", shaderc_vertex_shader},
+			{"frag", shaderc_fragment_shader},
+			{"geom", shaderc_geometry_shader},
+			{"comp", shaderc_compute_shader},
+			{"tesc", shaderc_tess_control_shader},
+			{"tese", shaderc_tess_evaluation_shader},
+			{"mesh", shaderc_mesh_shader},
+			{"task", shaderc_task_shader},
+			{"rgen", shaderc_raygen_shader},
+			{"rchit", shaderc_closesthit_shader},
+			{"rahit", shaderc_anyhit_shader},
+			{"rmiss", shaderc_miss_shader},
+			{"rint", shaderc_intersection_shader},
+			{"rcall", shaderc_callable_shader},
+		};
+		if (auto iter = kinds.find(stage); iter != kinds.end())
+		{
+			return iter->second;
+		}
+		//let the compiler read the stage from "#pragma shader_stage"
+		return shaderc_glsl_infer_from_source;
+	}
+
+	static opt<std::vector<uint32_t>> CompileToSpirv(ShaderCompileOptions& options, std::string* error)
+	{
+		//shaderc compilers can be shared between threads
+		static shaderc::Compiler compiler;
+
+		auto source = ReadWholeFile(options.file);
+		if (!source.has_value())
+		{
+			if (error != nullptr) *error = "gvk : fail to read file " + options.file;
+			return std::nullopt;
+		}
+
+		shaderc::CompileOptions compile_options;
+		for (uint32 i = 0; i < options.macros.size(); i++)
+		{
+			compile_options.AddMacroDefinition(options.macros[i], options.definitions[i]);
+		}
+		if (options.target_env == "1.1")
+		{
+			compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+		}
+		else if (options.target_env == "1.2")
+		{
+			compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+		}
+		else if (options.target_env == "1.3")
+		{
+			compile_options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+		}
+		if (options.target_spv == "1.4")
+		{
+			compile_options.SetTargetSpirv(shaderc_spirv_version_1_4);
+		}
+		compile_options.SetIncluder(std::make_unique<ShaderIncluder>(options.include_directories));
+
+		shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source.value().data(), source.value().size(),
+			GetShaderKind(options.stage), options.file.c_str(), "main", compile_options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+		{
+			if (error != nullptr) *error = "gvk : fail to compile file " + options.file + "\n" + result.GetErrorMessage();
+			return std::nullopt;
+		}
+
+		std::vector<uint32_t> code(result.cbegin(), result.cend());
+		//keep "{file}.spv" on disk so that Shader::Load still works with compiled shaders
+		if (!WriteSpirvFile(options.output_file, code))
+		{
+			if (error != nullptr) *error = "gvk : fail to write binary file " + options.output_file;
+			return std::nullopt;
+		}
+		return std::move(code);
+	}
+
+#else
 
-	std::string GenerateCommandLine(ShaderCompileOptions& options)
+	//arguments of glslc,one element for every argument so paths with spaces stay intact
+	std::vector<std::string> GenerateCommandLine(ShaderCompileOptions& options)
 	{
-		std::string cmd;
+		std::vector<std::string> args;
 		for (uint32 i = 0; i < options.macros.size(); i++)
 		{
-			cmd += std::string(" -D") + std::string(options.macros[i]);
+			std::string macro = "-D" + std::string(options.macros[i]);
 			if (options.definitions[i] != "")
 			{
-				cmd += "=" + std::string(options.definitions[i]);
+				macro += "=" + std::string(options.definitions[i]);
 			}
+			args.push_back(macro);
 		}
 
 		if (options.target_env != "")
 		{
-			cmd += " --target-env=vulkan" + options.target_env;
+			args.push_back("--target-env=vulkan" + options.target_env);
 		}
 		if (options.target_spv != "")
 		{
-			cmd += " --target-spv=spv" + options.target_spv;
+			args.push_back("--target-spv=spv" + options.target_spv);
 		}
 
 		for (uint32 i = 0; i < options.include_directories.size(); i++)
 		{
-			cmd += " -I " + options.include_directories[i];
+			args.push_back("-I");
+			args.push_back(options.include_directories[i]);
 		}
 
 		gvk_assert(options.stage != "");
 		gvk_assert(options.file != "");
-		cmd += " " + options.file + " -o " + options.output_file;
-		return cmd;
+		args.push_back(options.file);
+		args.push_back("-o");
+		args.push_back(options.output_file);
+		return args;
+	}
+
+	static opt<std::vector<uint32_t>> CompileToSpirv(ShaderCompileOptions& options, std::string* error)
+	{
+		//glslc writes to a file private to this thread,the result is moved to "{file}.spv" afterwards
+		std::string target_file = options.output_file;
+		options.output_file = target_file + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+		//lauch the compile process
+		if (auto v = LauchProcess(GLSLC_EXECUATABLE, GenerateCommandLine(options)); !v.has_value())
+		{
+			if (error != nullptr) *error = "gvk : fail to create glslc process";
+			return std::nullopt;
+		}
+		else if (v.value() != 0) {
+			if (error != nullptr) *error = "gvk : fail to compile file " + options.file;
+			return std::nullopt;
+		}
+
+		auto data = ReadWholeFile(options.output_file);
+		std::error_code ec;
+		fs::rename(options.output_file, target_file, ec);
+		if (!data.has_value() || data.value().size() % sizeof(uint32_t) != 0)
+		{
+			if (error != nullptr) *error = "gvk : fail to open binary file " + options.output_file;
+			return std::nullopt;
+		}
+
+		std::vector<uint32_t> code(data.value().size() / sizeof(uint32_t));
+		memcpy(code.data(), data.value().data(), data.value().size());
+		return std::move(code);
+	}
+
+#endif
+
+	struct ShaderReflectionHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t size;
+		//the binary the reflection is generated from
+		uint64_t code_size;
+		uint64_t code_hash;
+		uint32_t stage;
+		uint32_t entry_point_offset;
+		//offsets of the tables from the beginning of the block
+		uint32_t descriptor_set_count;
+		uint32_t descriptor_sets_offset;
+		uint32_t descriptor_binding_count;
+		uint32_t descriptor_bindings_offset;
+		uint32_t input_variable_count;
+		uint32_t input_variables_offset;
+		uint32_t output_variable_count;
+		uint32_t output_variables_offset;
+		uint32_t push_constant_count;
+		uint32_t push_constants_offset;
+		uint32_t specialization_constant_count;
+		uint32_t specialization_constants_offset;
+	};
+	static constexpr uint32_t g_shader_reflection_magic = 0x52535647; //"GVSR"
+	static constexpr uint32_t g_shader_reflection_version = 5;
+
+	template<typename T, typename Enumerator>
+	opt<std::vector<T*>> GetDataFromShaderModule(const spv_reflect::ShaderModule& shader_module, Enumerator enumerator) 
+	{
+		uint32 count = 0;
+		if ((shader_module.*enumerator)(&count, nullptr) != SPV_REFLECT_RESULT_SUCCESS) 
+		{
+			return std::nullopt;
+		}
+		std::vector<T*> values(count);
+		gvk_assert((shader_module.*enumerator)(&count, values.data()) == SPV_REFLECT_RESULT_SUCCESS);
+
+		return std::move(values);
+	}
+
+	// unfortunately reflection can't read mesh shader stage
+	// we have to set it from the extension of the source file
+	static VkShaderStageFlagBits GetStageFromExtension(const std::string& stage)
+	{
+		if (stage == "mesh") return VK_SHADER_STAGE_MESH_BIT_EXT;
+		if (stage == "task") return VK_SHADER_STAGE_TASK_BIT_EXT;
+		return (VkShaderStageFlagBits)0;
+	}
+
+	//sizes of the specialization constants by their result ids.
+	//SPIRV-Reflect doesn't report the types of specialization constants,so they are read from the instructions
+	static std::unordered_map<uint32_t, uint32_t> GetSpecializationConstantSizes(const void* code, uint64_t code_size)
+	{
+		constexpr uint32_t op_type_bool = 20, op_type_int = 21, op_type_float = 22;
+		constexpr uint32_t op_spec_constant_true = 48, op_spec_constant_false = 49, op_spec_constant = 50;
+
+		std::unordered_map<uint32_t, uint32_t> type_sizes, sizes;
+		const uint32_t* words = (const uint32_t*)code;
+		uint64_t word_count = code_size / sizeof(uint32_t);
+		//instructions start after the 5 words of the module header
+		for (uint64_t i = 5; i < word_count;)
+		{
+			uint32_t opcode = words[i] & 0xffff;
+			uint32_t length = words[i] >> 16;
+			if (length == 0 || i + length > word_count) break;
+
+			if (opcode == op_type_bool && length >= 2)
+			{
+				type_sizes[words[i + 1]] = sizeof(VkBool32);
+			}
+			else if ((opcode == op_type_int || opcode == op_type_float) && length >= 3)
+			{
+				type_sizes[words[i + 1]] = words[i + 2] / 8;
+			}
+			else if ((opcode == op_spec_constant_true || opcode == op_spec_constant_false || opcode == op_spec_constant) && length >= 3)
+			{
+				//types are declared before the constants using them
+				if (auto type = type_sizes.find(words[i + 1]); type != type_sizes.end())
+				{
+					sizes[words[i + 2]] = type->second;
+				}
+			}
+			i += length;
+		}
+		return sizes;
 	}
 
+	//reflect the binary once with SPIRV-Reflect and flatten the result to a reflection block
+	static bool BuildReflection(const void* code, uint64_t code_size, uint64_t code_hash, VkShaderStageFlagBits stage,
+		std::vector<uint8_t>& block)
+	{
+		spv_reflect::ShaderModule shader_module(code_size, code, SPV_REFLECT_MODULE_FLAG_NO_COPY);
+		if (shader_module.GetResult() != SPV_REFLECT_RESULT_SUCCESS)
+		{
+			return false;
+		}
+
+		auto bindings = GetDataFromShaderModule<SpvReflectDescriptorBinding>(shader_module, &spv_reflect::ShaderModule::EnumerateDescriptorBindings);
+		auto inputs = GetDataFromShaderModule<SpvReflectInterfaceVariable>(shader_module, &spv_reflect::ShaderModule::EnumerateInputVariables);
+		auto outputs = GetDataFromShaderModule<SpvReflectInterfaceVariable>(shader_module, &spv_reflect::ShaderModule::EnumerateOutputVariables);
+		auto push_constants = GetDataFromShaderModule<SpvReflectBlockVariable>(shader_module, &spv_reflect::ShaderModule::EnumeratePushConstantBlocks);
+		auto specialization_constants = GetDataFromShaderModule<SpvReflectSpecializationConstant>(shader_module, &spv_reflect::ShaderModule::EnumerateSpecializationConstants);
+		if (!bindings.has_value() || !inputs.has_value() || !outputs.has_value() || !push_constants.has_value() || !specialization_constants.has_value())
+		{
+			return false;
+		}
+
+		//bindings of a set are stored next to each other
+		std::sort(bindings.value().begin(), bindings.value().end(),
+			[](SpvReflectDescriptorBinding* lhs, SpvReflectDescriptorBinding* rhs) {
+				return lhs->set != rhs->set ? lhs->set < rhs->set : lhs->binding < rhs->binding;
+			});
+		uint32 set_count = 0;
+		for (uint32 i = 0; i < bindings.value().size(); i++)
+		{
+			if (i == 0 || bindings.value()[i]->set != bindings.value()[i - 1]->set) set_count++;
+		}
+		uint32 member_count = 0;
+		for (auto push_constant : push_constants.value())
+		{
+			member_count += push_constant->member_count;
+		}
+
+		ShaderReflectionHeader header{};
+		header.magic = g_shader_reflection_magic;
+		header.version = g_shader_reflection_version;
+		header.code_size = code_size;
+		header.code_hash = code_hash;
+		header.stage = stage != 0 ? stage : (uint32_t)shader_module.GetShaderStage();
+		header.descriptor_set_count = set_count;
+		header.descriptor_binding_count = bindings.value().size();
+		header.input_variable_count = inputs.value().size();
+		header.output_variable_count = outputs.value().size();
+		header.push_constant_count = push_constants.value().size();
+		header.specialization_constant_count = specialization_constants.value().size();
+
+		header.descriptor_sets_offset = Align(sizeof(ShaderReflectionHeader), 8);
+		header.descriptor_bindings_offset = Align(header.descriptor_sets_offset + set_count * sizeof(ShaderDescriptorSet), 8);
+		header.input_variables_offset = Align(header.descriptor_bindings_offset + header.descriptor_binding_count * sizeof(ShaderDescriptorBinding), 8);
+		header.output_variables_offset = Align(header.input_variables_offset + header.input_variable_count * sizeof(ShaderInterfaceVariable), 8);
+		header.push_constants_offset = Align(header.output_variables_offset + header.output_variable_count * sizeof(ShaderInterfaceVariable), 8);
+		header.specialization_constants_offset = Align(header.push_constants_offset + header.push_constant_count * sizeof(ShaderPushConstant), 8);
+		uint32 members_offset = Align(header.specialization_constants_offset + header.specialization_constant_count * sizeof(ShaderSpecializationConstant), 8);
+		uint32 strings_offset = Align(members_offset + member_count * sizeof(ShaderBlockMember), 8);
+
+		std::string strings;
+		auto add_string = [&](const char* str)
+		{
+			uint32 offset = strings_offset + strings.size();
+			strings += str != nullptr ? str : "";
+			strings.push_back('\0');
+			return offset;
+		};
+		//offset of target relative to the record at position
+		auto relative = [](uint32 target, uint32 position) { return (int32)target - (int32)position; };
+
+		std::vector<ShaderDescriptorSet> set_records;
+		std::vector<ShaderDescriptorBinding> binding_records(header.descriptor_binding_count);
+		for (uint32 i = 0; i < bindings.value().size(); i++)
+		{
+			SpvReflectDescriptorBinding* binding = bindings.value()[i];
+			uint32 position = header.descriptor_bindings_offset + i * sizeof(ShaderDescriptorBinding);
+			if (set_records.empty() || set_records.back().set != binding->set)
+			{
+				ShaderDescriptorSet set{};
+				set.set = binding->set;
+				set.bindings_offset = relative(position, header.descriptor_sets_offset + set_records.size() * sizeof(ShaderDescriptorSet));
+				set_records.push_back(set);
+			}
+			set_records.back().binding_count++;
+
+			ShaderDescriptorBinding& record = binding_records[i];
+			record.set = binding->set;
+			record.binding = binding->binding;
+			record.descriptor_type = binding->descriptor_type;
+			record.resource_type = binding->resource_type;
+			record.count = binding->count;
+			record.image = binding->image;
+			record.array_dims_count = binding->array.dims_count;
+			memcpy(record.array_dims, binding->array.dims, sizeof(record.array_dims));
+			record.block_size = binding->block.size;
+			record.name_offset = relative(add_string(binding->name), position);
+		}
+
+		auto flatten_variables = [&](const std::vector<SpvReflectInterfaceVariable*>& variables, uint32 table_offset)
+		{
+			std::vector<ShaderInterfaceVariable> records(variables.size());
+			for (uint32 i = 0; i < variables.size(); i++)
+			{
+				records[i].location = variables[i]->location;
+				records[i].format = (VkFormat)variables[i]->format;
+				records[i].built_in = (variables[i]->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN) != 0;
+				records[i].name_offset = relative(add_string(variables[i]->name), table_offset + i * sizeof(ShaderInterfaceVariable));
+			}
+			return records;
+		};
+		std::vector<ShaderInterfaceVariable> input_records = flatten_variables(inputs.value(), header.input_variables_offset);
+		std::vector<ShaderInterfaceVariable> output_records = flatten_variables(outputs.value(), header.output_variables_offset);
+
+		std::vector<ShaderPushConstant> push_constant_records(header.push_constant_count);
+		std::vector<ShaderBlockMember> member_records;
+		for (uint32 i = 0; i < push_constants.value().size(); i++)
+		{
+			SpvReflectBlockVariable* push_constant = push_constants.value()[i];
+			uint32 position = header.push_constants_offset + i * sizeof(ShaderPushConstant);
+
+			ShaderPushConstant& record = push_constant_records[i];
+			record.offset = push_constant->offset;
+			record.size = push_constant->size;
+			record.member_count = push_constant->member_count;
+			record.members_offset = relative(members_offset + member_records.size() * sizeof(ShaderBlockMember), position);
+			record.name_offset = relative(add_string(push_constant->name), position);
+
+			for (uint32 j = 0; j < push_constant->member_count; j++)
+			{
+				ShaderBlockMember member{};
+				member.offset = push_constant->members[j].offset;
+				member.size = push_constant->members[j].size;
+				member.name_offset = relative(add_string(push_constant->members[j].name),
+					members_offset + member_records.size() * sizeof(ShaderBlockMember));
+				member_records.push_back(member);
+			}
+		}
+		std::vector<ShaderSpecializationConstant> specialization_constant_records(header.specialization_constant_count);
+		auto specialization_constant_sizes = GetSpecializationConstantSizes(code, code_size);
+		for (uint32 i = 0; i < specialization_constants.value().size(); i++)
+		{
+			specialization_constant_records[i].constant_id = specialization_constants.value()[i]->constant_id;
+			auto size = specialization_constant_sizes.find(specialization_constants.value()[i]->spirv_id);
+			specialization_constant_records[i].size = size != specialization_constant_sizes.end() ? size->second : 0;
+			specialization_constant_records[i].name_offset = relative(add_string(specialization_constants.value()[i]->name),
+				header.specialization_constants_offset + i * sizeof(ShaderSpecializationConstant));
+		}
+
+		header.entry_point_offset = add_string(shader_module.GetEntryPointName());
+		header.size = strings_offset + strings.size();
+
+		block.assign(header.size, 0);
+		auto copy_table = [&](const auto& records, uint32 offset)
+		{
+			if (!records.empty()) memcpy(block.data() + offset, records.data(), records.size() * sizeof(records[0]));
+		};
+		copy_table(set_records, header.descriptor_sets_offset);
+		copy_table(binding_records, header.descriptor_bindings_offset);
+		copy_table(input_records, header.input_variables_offset);
+		copy_table(output_records, header.output_variables_offset);
+		copy_table(push_constant_records, header.push_constants_offset);
+		copy_table(specialization_constant_records, header.specialization_constants_offset);
+		copy_table(member_records, members_offset);
+		memcpy(block.data() + strings_offset, strings.data(), strings.size());
+
+		memcpy(block.data(), &header, sizeof(header));
+		return true;
+	}
+
+	//the block matches the binary if it records the binary's hash.
+	//size alone is not enough,a rebuilt binary may keep the size of the old one.
+	//a truncated block is caught by its size
+	static bool ValidateReflection(const void* data, uint64_t size, uint64_t code_size, uint64_t code_hash)
+	{
+		if (size < sizeof(ShaderReflectionHeader)) return false;
+		const ShaderReflectionHeader* header = (const ShaderReflectionHeader*)data;
+		if (header->magic != g_shader_reflection_magic || header->version != g_shader_reflection_version ||
+			header->size != size || header->code_size != code_size)
+		{
+			return false;
+		}
+		return header->code_hash == code_hash;
+	}
+
+	static ptr<void> MapFile(const std::string& file, uint64_t& size)
+	{
+#ifdef GVK_WINDOWS_PLATFORM
+		HANDLE file_handle = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file_handle == INVALID_HANDLE_VALUE)
+		{
+			return nullptr;
+		}
+		LARGE_INTEGER file_size;
+		HANDLE mapping = NULL;
+		if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart != 0)
+		{
+			mapping = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		}
+		CloseHandle(file_handle);
+		if (mapping == NULL)
+		{
+			return nullptr;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (view == NULL)
+		{
+			return nullptr;
+		}
+		size = file_size.QuadPart;
+		return ptr<void>(view, [](void* address) { UnmapViewOfFile(address); });
+#else
+		int fd = open(file.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		struct stat file_stat;
+		void* view = MAP_FAILED;
+		if (fstat(fd, &file_stat) == 0 && file_stat.st_size != 0)
+		{
+			view = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		close(fd);
+		if (view == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		size = file_stat.st_size;
+		return ptr<void>(view, [size](void* address) { munmap(address, size); });
+#endif
+	}
+
+	static std::mutex  g_shader_cache_lock;
+	static bool		   g_shader_cache_initialized = false;
+	static std::string g_shader_cache_directory;
+
+	void Shader::SetCompileCacheDirectory(const char* directory)
+	{
+		std::lock_guard<std::mutex> lock(g_shader_cache_lock);
+		g_shader_cache_initialized = true;
+		g_shader_cache_directory = directory != nullptr ? directory : "";
+	}
+
+	static std::string GetCompileCacheDirectory()
+	{
+		std::lock_guard<std::mutex> lock(g_shader_cache_lock);
+		if (!g_shader_cache_initialized)
+		{
+			g_shader_cache_initialized = true;
+			std::error_code ec;
+			fs::path temp = fs::temp_directory_path(ec);
+			if (!ec)
+			{
+				g_shader_cache_directory = (temp / "gvk_shader_cache").string();
+			}
+		}
+		return g_shader_cache_directory;
+	}
+
+	//bump this when the key or the layout of cache entries changes
+	static constexpr uint32 g_shader_cache_version = 2;
+
+	struct ShaderCacheFileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t code_size;
+		uint64_t code_hash;
+	};
+	static constexpr uint32_t g_shader_cache_magic = 0x43535647; //"GVSC"
+
+	//replace comments by spaces,newlines are kept so directives stay on their own lines
+	static std::string StripComments(const std::string& source)
+	{
+		std::string stripped;
+		stripped.reserve(source.size());
+		bool in_quote = false;
+		for (size_t i = 0; i < source.size(); i++)
+		{
+			char c = source[i];
+			if (in_quote)
+			{
+				in_quote = c != '"' && c != '\n';
+				stripped.push_back(c);
+			}
+			else if (c == '/' && i + 1 < source.size() && source[i + 1] == '/')
+			{
+				while (i < source.size() && source[i] != '\n') i++;
+				if (i < source.size()) stripped.push_back('\n');
+			}
+			else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*')
+			{
+				size_t end = source.find("*/", i + 2);
+				end = end == std::string::npos ? source.size() : end + 2;
+				stripped.push_back(' ');
+				for (; i < end; i++)
+				{
+					if (source[i] == '\n') stripped.push_back('\n');
+				}
+				i--;
+			}
+			else
+			{
+				in_quote = c == '"';
+				stripped.push_back(c);
+			}
+		}
+		return stripped;
+	}
+
+	struct ShaderIncludeDirective
+	{
+		std::string file;
+		//"file" is searched beside the including file first,<file> only in the include directories
+		bool		relative;
+	};
+
+	//collect the quoted or bracketed file name after "#include"
+	static std::vector<ShaderIncludeDirective> ScanIncludeDirectives(const std::string& source)
+	{
+		std::vector<ShaderIncludeDirective> includes;
+		std::istringstream lines(StripComments(source));
+		std::string line;
+		while (std::getline(lines, line))
+		{
+			size_t pos = line.find_first_not_of(" \t");
+			if (pos == std::string::npos || line[pos] != '#') continue;
+			pos = line.find_first_not_of(" \t", pos + 1);
+			if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) continue;
+
+			size_t begin = line.find_first_of("\"<", pos + 7);
+			if (begin == std::string::npos) continue;
+			bool relative = line[begin] == '"';
+			size_t end = line.find_first_of(relative ? "\"" : ">", begin + 1);
+			if (end == std::string::npos) continue;
+			includes.push_back({ line.substr(begin + 1, end - begin - 1), relative });
+		}
+		return includes;
+	}
+
+	//hash a file together with every file it includes,recursively.
+	//includes are resolved in the same order as ShaderIncluder and glslc do:
+	//"file" beside the including file first and then in the include directories,<file> only in the include directories.
+	//conditionally included files are always hashed,which can only cause extra misses
+	static bool HashIncludeClosure(const fs::path& file, const std::vector<std::string>& include_directories,
+		std::unordered_set<std::string>& visited, uint64_t& hash)
+	{
+		std::error_code ec;
+		std::string key = fs::absolute(file, ec).lexically_normal().string();
+		if (visited.count(key)) return true;
+		visited.insert(key);
+
+		auto data = ReadWholeFile(file.string());
+		if (!data.has_value())
+		{
+			return false;
+		}
+		hash = HashBytes(data.value().data(), data.value().size(), hash);
+
+		for (auto& include : ScanIncludeDirectives(std::string(data.value().begin(), data.value().end())))
+		{
+			//the include name is part of the key as well as the content
+			hash = HashBytes(include.file.data(), include.file.size(), hash);
+			hash = HashBytes(&include.relative, sizeof(include.relative), hash);
+
+			opt<fs::path> resolved;
+			fs::path candidate = file.parent_path() / include.file;
+			if (include.relative && fs::exists(candidate))
+			{
+				resolved = candidate;
+			}
+			for (uint32 i = 0; i < include_directories.size() && !resolved.has_value(); i++)
+			{
+				candidate = fs::path(include_directories[i]) / include.file;
+				if (fs::exists(candidate)) resolved = candidate;
+			}
+			//let the compiler report the missing file
+			if (!resolved.has_value() || !HashIncludeClosure(resolved.value(), include_directories, visited, hash))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//identifies the compiler,a different compiler may produce different binaries from the same source
+	static const std::string& GetCompilerVersion()
+	{
+		static const std::string version = []()
+		{
+#ifdef GVK_SHADERC_COMPILER
+			unsigned int spv_version = 0, spv_revision = 0;
+			shaderc_get_spv_version(&spv_version, &spv_revision);
+			return std::string("shaderc ") + GVK_SHADERC_VERSION + string_format(" spv %u.%u", spv_version, spv_revision);
+#else
+			//glslc can be upgraded without rebuilding the library,its size and modification time identify the build
+			std::error_code ec;
+			uint64_t size = fs::file_size(GLSLC_EXECUATABLE, ec);
+			int64_t time = ec ? 0 : (int64_t)fs::last_write_time(GLSLC_EXECUATABLE, ec).time_since_epoch().count();
+			return std::string("glslc ") + std::to_string(size) + " " + std::to_string(time);
+#endif
+		}();
+		return version;
+	}
+
+	//source_files receives the absolute pathes of the source and every included file
+	static opt<uint64_t> ComputeCompileCacheKey(const ShaderCompileOptions& options, std::vector<std::string>& source_files)
+	{
+		uint64_t hash = HashBytes(&g_shader_cache_version, sizeof(g_shader_cache_version));
+		const std::string& compiler = GetCompilerVersion();
+		hash = HashBytes(compiler.data(), compiler.size(), hash);
+
+		std::unordered_set<std::string> visited;
+		bool closure_complete = HashIncludeClosure(fs::path(options.file), options.include_directories, visited, hash);
+		source_files.assign(visited.begin(), visited.end());
+		if (!closure_complete)
+		{
+			return std::nullopt;
+		}
+
+		auto hash_string = [&](const std::string& str)
+		{
+			//hash the length too so that ("ab","c") and ("a","bc") differ
+			uint64_t size = str.size();
+			hash = HashBytes(&size, sizeof(size), hash);
+			hash = HashBytes(str.data(), str.size(), hash);
+		};
+		for (uint32 i = 0; i < options.macros.size(); i++)
+		{
+			hash_string(options.macros[i]);
+			hash_string(options.definitions[i]);
+		}
+		hash_string(options.stage);
+		hash_string(options.target_env);
+		hash_string(options.target_spv);
+		return hash;
+	}
+
+	static std::string GetCompileCacheFile(const std::string& directory, uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)key);
+		return (fs::path(directory) / name).string();
+	}
+
+	static opt<std::vector<uint32_t>> LoadCachedSpirv(const std::string& file, uint64_t key)
+	{
+		auto data = ReadWholeFile(file);
+		if (!data.has_value() || data.value().size() < sizeof(ShaderCacheFileHeader))
+		{
+			return std::nullopt;
+		}
+
+		ShaderCacheFileHeader header;
+		memcpy(&header, data.value().data(), sizeof(header));
+		const char* code_data = data.value().data() + sizeof(header);
+		if (header.magic != g_shader_cache_magic || header.version != g_shader_cache_version || header.key != key ||
+			header.code_size != data.value().size() - sizeof(header) || header.code_size % sizeof(uint32_t) != 0 ||
+			header.code_hash != HashBytes(code_data, header.code_size))
+		{
+			return std::nullopt;
+		}
+
+		std::vector<uint32_t> code(header.code_size / sizeof(uint32_t));
+		memcpy(code.data(), code_data, header.code_size);
+		return std::move(code);
+	}
+
+	static void StoreCachedSpirv(const std::string& file, uint64_t key, const std::vector<uint32_t>& code)
+	{
+		std::error_code ec;
+		fs::create_directories(fs::path(file).parent_path(), ec);
+
+		ShaderCacheFileHeader header;
+		header.magic = g_shader_cache_magic;
+		header.version = g_shader_cache_version;
+		header.key = key;
+		header.code_size = code.size() * sizeof(uint32_t);
+		header.code_hash = HashBytes(code.data(), header.code_size);
+
+		std::vector<char> data(sizeof(header) + header.code_size);
+		memcpy(data.data(), &header, sizeof(header));
+		memcpy(data.data() + sizeof(header), code.data(), header.code_size);
+		//a failed write only costs a recompile next time
+		WriteBinaryFile(file, data.data(), data.size());
+	}
 
 	opt<ptr<gvk::Shader>> Shader::Compile(const char* file,
 		const ShaderMacros& macros,
@@ -163,69 +1041,115 @@ namespace gvk {
 		options.include_directories.push_back(GVK_SHADER_COMMON_DIRECTORY);
 		
 		options.file = input;
-		options.output_file = input + ".spv";
 
+		//variants compiled with macros write their own outputs,so they can be compiled in parallel
+		uint64_t macro_hash = HashBytes(nullptr, 0);
 		for (uint32 i = 0; i < macros.name.size(); i++)
 		{
 			options.macros.push_back(macros.name[i]);
 			options.definitions.push_back((macros.value[i] == nullptr ? "" : macros.value[i]));
+			std::string macro = options.macros.back() + "=" + options.definitions.back() + ";";
+			macro_hash = HashBytes(macro.data(), macro.size(), macro_hash);
 		}
-
-		//lauch the compile process
-		if (auto v = LauchProcess(GLSLC_EXECUATABLE, GenerateCommandLine(options).c_str()); !v.has_value())
+		options.output_file = input;
+		if (!macros.name.empty())
 		{
-			if (error != nullptr) *error = "gvk : fail to create glslc process";
-			return std::nullopt;
-		}
-		else if (v.value() != 0) {
-			if (error != nullptr) *error = "gvk : fail to compile file " + input;
-			return std::nullopt;
+			options.output_file += string_format(".%016llx", (unsigned long long)macro_hash);
 		}
+		options.output_file += ".spv";
 
-		auto opt_shader =  LoadFromBinaryFile(options.output_file, error);
+		//compiling is skipped if neither the source,the included files nor the options changed
+		std::vector<std::string> source_files;
+		opt<uint64_t> cache_key = ComputeCompileCacheKey(options, source_files);
+		std::string cache_file;
+		if (std::string cache_directory = GetCompileCacheDirectory(); !cache_directory.empty() && cache_key.has_value())
+		{
+			cache_file = GetCompileCacheFile(cache_directory, cache_key.value());
+		}
 
-		// unfortunately reflection can't read mesh shader stage
-		// we have to set it manually
-		if (options.stage == "mesh" && opt_shader.has_value())
+		opt<std::vector<uint32_t>> code;
+		if (!cache_file.empty())
 		{
-			opt_shader.value()->m_Stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+			code = LoadCachedSpirv(cache_file, cache_key.value());
+			if (code.has_value() && !WriteSpirvFile(options.output_file, code.value()))
+			{
+				if (error != nullptr) *error = "gvk : fail to write binary file " + options.output_file;
+				return std::nullopt;
+			}
 		}
-		if (options.stage == "task" && opt_shader.has_value())
+		if (!code.has_value())
 		{
-			opt_shader.value()->m_Stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+			code = CompileToSpirv(options, error);
+			if (!code.has_value())
+			{
+				return std::nullopt;
+			}
+			if (!cache_file.empty())
+			{
+				StoreCachedSpirv(cache_file, cache_key.value(), code.value());
+			}
 		}
 
-		return opt_shader;
+		//the shader keeps the compiled code without copying it
+		auto code_storage = std::make_shared<std::vector<uint32_t>>(std::move(code.value()));
+		uint64_t code_size = code_storage->size() * sizeof(uint32_t);
+		auto shader = LoadFromMemory(ptr<void>(code_storage, code_storage->data()), code_size,
+			options.output_file, GetStageFromExtension(options.stage), HashBytes(code_storage->data(), code_size), error);
+		if (shader.has_value())
+		{
+			shader.value()->m_SourceFiles = std::move(source_files);
+		}
+		return shader;
 	}
 
-
-
-	opt<ptr<Shader>> Shader::LoadFromBinaryFile(std::string& file, std::string* error)
+	opt<ptr<Shader>> Shader::LoadFromMemory(ptr<void> code, uint64_t code_size, const std::string& file, VkShaderStageFlagBits stage,
+		uint64_t code_hash, std::string* error)
 	{
-		std::ifstream binary_code_file(file, std::ios::ate | std::ios::binary);
-		if (!binary_code_file.is_open()) {
-			if (error != nullptr) *error = "gvk : fail to open binary file " + file;
-			return std::nullopt;
-		}
-
-		uint64_t code_file_len = binary_code_file.tellg();
-		binary_code_file.seekg(0, std::ios::beg);
-		char* data = (char*)malloc(code_file_len);
-		binary_code_file.read(data, code_file_len);
+		std::string name = fs::path(file).filename().string();
+		std::string reflection_file = file + ".refl";
 
-		spv_reflect::ShaderModule shader_module(code_file_len, data, SPV_REFLECT_MODULE_FLAG_NONE);
-		if (shader_module.GetResult() != SPV_REFLECT_RESULT_SUCCESS)
+		//use the reflection written beside the binary if it is generated from the same binary
+		ptr<void> storage;
+		uint64_t reflection_size = 0;
+		if (auto mapped = MapFile(reflection_file, reflection_size);
+			mapped != nullptr && ValidateReflection(mapped.get(), reflection_size, code_size, code_hash))
 		{
-			if (error != nullptr) *error = "gvk : fail to create reflection for compiled shader code " + file;
-			return std::nullopt;
+			storage = mapped;
+		}
+		else
+		{
+			auto block = std::make_shared<std::vector<uint8_t>>();
+			if (!BuildReflection(code.get(), code_size, code_hash, stage, *block))
+			{
+				if (error != nullptr) *error = "gvk : fail to create reflection for compiled shader code " + name;
+				return std::nullopt;
+			}
+			//a failed write only costs reflecting the binary again next time
+			WriteBinaryFile(reflection_file, block->data(), block->size());
+			storage = std::shared_ptr<void>(block, block->data());
 		}
 
-		ptr<Shader> shader(new Shader(data, code_file_len, (VkShaderStageFlagBits)shader_module.GetShaderStage(), fs::path(file).filename().string()));
-		shader->m_ReflectShaderModule = std::move(shader_module);
+		const ShaderReflectionHeader* header = (const ShaderReflectionHeader*)storage.get();
+		ptr<Shader> shader(new Shader(code, code_size, (VkShaderStageFlagBits)header->stage, name));
+		shader->m_ReflectionStorage = storage;
+		shader->m_Reflection = header;
 		shader->m_ShaderModule = NULL;
 		return shader;
 	}
 
+	opt<ptr<Shader>> Shader::LoadFromBinaryFile(std::string& file, VkShaderStageFlagBits stage, std::string* error)
+	{
+		//the binary is used from the mapping,nothing is copied
+		uint64_t size = 0;
+		ptr<void> code = MapFile(file, size);
+		if (code == nullptr || size % sizeof(uint32_t) != 0) {
+			if (error != nullptr) *error = "gvk : fail to open binary file " + file;
+			return std::nullopt;
+		}
+		//hashing the mapped binary is far cheaper than reflecting it again
+		return LoadFromMemory(code, size, file, stage, HashBytes(code.get(), size), error);
+	}
+
 	opt<ptr<Shader>> Shader::Load(const char* _file, const char** search_pathes, uint32 search_path_count, std::string* error)
 	{
 		std::string file = _file;
@@ -237,17 +1161,17 @@ namespace gvk {
 		}
 		else 
 		{
-			*error = "gvk : fail to load file " + file;
+			if (error != nullptr) *error = "gvk : fail to load file " + file;
 			return std::nullopt;
 		}
 
-		return LoadFromBinaryFile(file, error);
+		std::string ext = fs::path(_file).extension().string();
+		return LoadFromBinaryFile(path, GetStageFromExtension(ext.empty() ? ext : ext.substr(1)), error);
 	}
 
 
 	Shader::~Shader() 
 	{
-		free(m_ByteCode);
 		if (m_ShaderModule != NULL) 
 		{
 			vkDestroyShaderModule(m_Device, m_ShaderModule, nullptr);
@@ -267,7 +1191,7 @@ namespace gvk {
 		VkShaderModuleCreateInfo info{};
 		info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 		info.pNext = NULL;
-		info.pCode = (uint32_t*)m_ByteCode;
+		info.pCode = (const uint32_t*)m_ByteCode.get();
 		info.codeSize = m_ByteCodeSize;
 		info.flags = 0;
 
@@ -286,83 +1210,65 @@ namespace gvk {
 		return m_ShaderModule;
 	}
 
-	template<typename T, typename Enumerator>
-	opt<std::vector<T*>> GetDataFromShaderModule(const spv_reflect::ShaderModule& shader_module, Enumerator enumerator) 
+	template<typename T>
+	static View<T> GetReflectionTable(const ShaderReflectionHeader* header, uint32_t offset, uint32_t count)
 	{
-		uint32 count = 0;
-		if ((shader_module.*enumerator)(&count, nullptr) != SPV_REFLECT_RESULT_SUCCESS) 
-		{
-			return std::nullopt;
-		}
-		std::vector<T*> values(count);
-		gvk_assert((shader_module.*enumerator)(&count, values.data()) == SPV_REFLECT_RESULT_SUCCESS);
-
-		return std::move(values);
+		return View<T>((const T*)((const char*)header + offset), 0, count);
 	}
 
-	template<typename Enumerator>
-	uint32 GetDataElementCountFromShaderModule(const spv_reflect::ShaderModule& shader_module,Enumerator enumerator) 
+	View<ShaderDescriptorBinding> Shader::GetDescriptorBindings()
 	{
-		uint32 count = 0;
-		(shader_module.*enumerator)(&count, nullptr);
-		return count;
+		return GetReflectionTable<ShaderDescriptorBinding>(m_Reflection, m_Reflection->descriptor_bindings_offset, m_Reflection->descriptor_binding_count);
 	}
 
-	opt<std::vector<SpvReflectDescriptorBinding*>> Shader::GetDescriptorBindings()
+	View<ShaderDescriptorSet> Shader::GetDescriptorSets()
 	{
-		return GetDataFromShaderModule<SpvReflectDescriptorBinding>
-			(m_ReflectShaderModule, &spv_reflect::ShaderModule::EnumerateDescriptorBindings);
+		return GetReflectionTable<ShaderDescriptorSet>(m_Reflection, m_Reflection->descriptor_sets_offset, m_Reflection->descriptor_set_count);
 	}
 
-	opt<std::vector<SpvReflectDescriptorSet*>> Shader::GetDescriptorSets()
+	View<ShaderInterfaceVariable> Shader::GetInputVariables()
 	{
-		return GetDataFromShaderModule<SpvReflectDescriptorSet>
-			(m_ReflectShaderModule, &spv_reflect::ShaderModule::EnumerateDescriptorSets);
+		return GetReflectionTable<ShaderInterfaceVariable>(m_Reflection, m_Reflection->input_variables_offset, m_Reflection->input_variable_count);
 	}
 
-	opt<std::vector<SpvReflectInterfaceVariable*>> Shader::GetInputVariables()
+	View<ShaderInterfaceVariable> Shader::GetOutputVariables()
 	{
-		return GetDataFromShaderModule<SpvReflectInterfaceVariable>
-			(m_ReflectShaderModule, &spv_reflect::ShaderModule::EnumerateInputVariables);
+		return GetReflectionTable<ShaderInterfaceVariable>(m_Reflection, m_Reflection->output_variables_offset, m_Reflection->output_variable_count);
 	}
 
-	opt<std::vector<SpvReflectInterfaceVariable*>> Shader::GetOutputVariables()
+	View<ShaderPushConstant> Shader::GetPushConstants() 
 	{
-		return GetDataFromShaderModule<SpvReflectInterfaceVariable>
-			(m_ReflectShaderModule, &spv_reflect::ShaderModule::EnumerateOutputVariables);
+		return GetReflectionTable<ShaderPushConstant>(m_Reflection, m_Reflection->push_constants_offset, m_Reflection->push_constant_count);
 	}
 
-
-	opt<std::vector<SpvReflectBlockVariable*>>	Shader::GetPushConstants() 
+	View<ShaderSpecializationConstant> Shader::GetSpecializationConstants()
 	{
-		return GetDataFromShaderModule<SpvReflectBlockVariable>
-			(m_ReflectShaderModule, &spv_reflect::ShaderModule::EnumeratePushConstantBlocks);
+		return GetReflectionTable<ShaderSpecializationConstant>(m_Reflection, m_Reflection->specialization_constants_offset, m_Reflection->specialization_constant_count);
 	}
 
 	uint32 Shader::GetDescriptorBindingCount() 
 	{
-		return GetDataElementCountFromShaderModule(m_ReflectShaderModule,
-			&spv_reflect::ShaderModule::EnumerateDescriptorBindings);
+		return m_Reflection->descriptor_binding_count;
 	}
 	uint32 Shader::GetDescriptorSetCount() 
 	{
-		return GetDataElementCountFromShaderModule(m_ReflectShaderModule,
-			&spv_reflect::ShaderModule::EnumerateDescriptorSets);
+		return m_Reflection->descriptor_set_count;
 	}
 	uint32 Shader::GetInputVariableCount() 
 	{
-		return GetDataElementCountFromShaderModule(m_ReflectShaderModule,
-			&spv_reflect::ShaderModule::EnumerateInputVariables);
+		return m_Reflection->input_variable_count;
 	}
 	uint32 Shader::GetOutputVariableCount() 
 	{
-		return GetDataElementCountFromShaderModule(m_ReflectShaderModule,
-			&spv_reflect::ShaderModule::EnumerateOutputVariables);
+		return m_Reflection->output_variable_count;
 	}
 	uint32 Shader::GetPushConstantCount() 
 	{
-		return GetDataElementCountFromShaderModule(m_ReflectShaderModule,
-			&spv_reflect::ShaderModule::EnumeratePushConstants);
+		return m_Reflection->push_constant_count;
+	}
+	uint32 Shader::GetSpecializationConstantCount() 
+	{
+		return m_Reflection->specialization_constant_count;
 	}
 
 	const std::string& Shader::Name()
@@ -372,7 +1278,116 @@ namespace gvk {
 
 	const char* Shader::GetEntryPointName()
 	{
-		return m_ReflectShaderModule.GetEntryPointName();
+		return (const char*)m_Reflection + m_Reflection->entry_point_offset;
+	}
+
+	const std::vector<std::string>& Shader::GetSourceFiles()
+	{
+		return m_SourceFiles;
+	}
+
+	const void* Shader::GetByteCode()
+	{
+		return m_ByteCode.get();
+	}
+
+	uint64_t Shader::GetByteCodeSize()
+	{
+		return m_ByteCodeSize;
+	}
+
+	ShaderPermutation& ShaderPermutation::Axis(const char* name)
+	{
+		return Axis(name, { nullptr });
+	}
+
+	ShaderPermutation& ShaderPermutation::Axis(const char* name, const std::vector<const char*>& values)
+	{
+		gvk_assert(name != nullptr && !values.empty());
+		AxisInfo axis;
+		axis.name = name;
+		axis.values = values;
+		axis.shift = m_BitCount;
+		//a value is reserved for "undefined" on boolean axes
+		uint32 value_count = values.size() + (values.size() == 1 && values[0] == nullptr ? 1 : 0);
+		axis.bits = 0;
+		while ((1u << axis.bits) < value_count) axis.bits++;
+		m_BitCount += axis.bits;
+		//every mask gets an entry in the variant archive
+		gvk_assert(m_BitCount <= 16);
+		m_Axes.push_back(axis);
+		return *this;
+	}
+
+	uint32 ShaderPermutation::Select(const char* name, uint32 value_index) const
+	{
+		for (auto& axis : m_Axes)
+		{
+			if (strcmp(axis.name, name) == 0)
+			{
+				gvk_assert(value_index < (1u << axis.bits));
+				return value_index << axis.shift;
+			}
+		}
+		return 0;
+	}
+
+	uint32 ShaderPermutation::GetBitCount() const
+	{
+		return m_BitCount;
+	}
+
+	bool ShaderPermutation::GetMacros(uint32 mask, ShaderMacros& macros) const
+	{
+		for (auto& axis : m_Axes)
+		{
+			uint32 value_index = (mask >> axis.shift) & ((1u << axis.bits) - 1);
+			if (axis.values.size() == 1 && axis.values[0] == nullptr)
+			{
+				if (value_index == 1) macros.D(axis.name);
+			}
+			else if (value_index < axis.values.size())
+			{
+				macros.D(axis.name, axis.values[value_index]);
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ShaderVariantArchive::ShaderVariantArchive(const ShaderPermutation& permutation)
+		:m_Permutation(permutation), m_VariantShaderIndex(1u << permutation.GetBitCount(), UINT32_MAX) {}
+
+	ptr<Shader> ShaderVariantArchive::Get(uint32 mask)
+	{
+		if (mask >= m_VariantShaderIndex.size() || m_VariantShaderIndex[mask] == UINT32_MAX)
+		{
+			return nullptr;
+		}
+		return m_Shaders[m_VariantShaderIndex[mask]];
+	}
+
+	const ShaderPermutation& ShaderVariantArchive::GetPermutation()
+	{
+		return m_Permutation;
+	}
+
+	uint32 ShaderVariantArchive::GetVariantCount()
+	{
+		return m_VariantShaderIndex.size();
+	}
+
+	uint32 ShaderVariantArchive::GetUniqueShaderCount()
+	{
+		return m_Shaders.size();
+	}
+
+	const std::vector<std::pair<uint32, std::string>>& ShaderVariantArchive::GetFailedVariants()
+	{
+		return m_FailedVariants;
 	}
 
 }
\ No newline at end of file
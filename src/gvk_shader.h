@@ -16,6 +16,116 @@ namespace gvk {
 			return *this;
 		}
 	};
+
+	//a shader compiled with Context::CompileShaders
+	struct ShaderCompileInfo {
+		const char*  file;
+		ShaderMacros macros;
+	};
+
+	//macro axes of a shader,every combination of values of the axes is a variant of the shader.
+	//a variant is addressed by a bit mask,each axis takes the bits needed to index its values in declaration order
+	class ShaderPermutation {
+	public:
+		//an axis whose macro is either undefined (0) or defined (1)
+		ShaderPermutation& Axis(const char* name);
+		//an axis whose macro is defined as one of the values
+		ShaderPermutation& Axis(const char* name, const std::vector<const char*>& values);
+
+		//bits in the variant mask selecting the value of the axis,0 if the axis doesn't exist
+		uint32 Select(const char* name, uint32 value_index = 1) const;
+		uint32 GetBitCount() const;
+		//append the macros of the variant,false if the mask selects a value out of range
+		bool   GetMacros(uint32 mask, ShaderMacros& macros) const;
+
+	private:
+		struct AxisInfo {
+			const char* name;
+			std::vector<const char*> values;
+			uint32 shift;
+			uint32 bits;
+		};
+		std::vector<AxisInfo> m_Axes;
+		uint32				  m_BitCount = 0;
+	};
+
+	//reflection records of a shader are laid out in one contiguous block which is mapped from disk directly.
+	//records refer to each other by offsets relative to themselves,so the block needs no fix up after loading
+	struct ShaderInterfaceVariable
+	{
+		uint32	 location;
+		VkFormat format;
+		uint32	 built_in;
+		int32	 name_offset;
+
+		const char* Name() const { return (const char*)this + name_offset; }
+	};
+
+	struct ShaderDescriptorBinding
+	{
+		uint32					 set;
+		uint32					 binding;
+		SpvReflectDescriptorType descriptor_type;
+		SpvReflectResourceType	 resource_type;
+		uint32					 count;
+		SpvReflectImageTraits	 image;
+		uint32					 array_dims_count;
+		uint32					 array_dims[SPV_REFLECT_MAX_ARRAY_DIMS];
+		//size of the uniform/storage block,0 for other descriptors
+		uint32					 block_size;
+		int32					 name_offset;
+
+		const char* Name() const { return (const char*)this + name_offset; }
+	};
+
+	struct ShaderDescriptorSet
+	{
+		uint32  set;
+		uint32  binding_count;
+		int32   bindings_offset;
+
+		View<ShaderDescriptorBinding> Bindings() const
+		{
+			return View<ShaderDescriptorBinding>((const ShaderDescriptorBinding*)((const char*)this + bindings_offset), 0, binding_count);
+		}
+	};
+
+	struct ShaderBlockMember
+	{
+		uint32  offset;
+		uint32  size;
+		int32   name_offset;
+
+		const char* Name() const { return (const char*)this + name_offset; }
+	};
+
+	struct ShaderPushConstant
+	{
+		uint32  offset;
+		uint32  size;
+		uint32  member_count;
+		int32   members_offset;
+		int32   name_offset;
+
+		const char* Name() const { return (const char*)this + name_offset; }
+		View<ShaderBlockMember> Members() const
+		{
+			return View<ShaderBlockMember>((const ShaderBlockMember*)((const char*)this + members_offset), 0, member_count);
+		}
+	};
+
+	struct ShaderSpecializationConstant
+	{
+		uint32 constant_id;
+		int32  name_offset;
+		//size of the constant's scalar type in bytes,booleans are 4 bytes
+		uint32 size;
+
+		const char* Name() const { return (const char*)this + name_offset; }
+	};
+
+	struct ShaderReflectionHeader;
+
 	class Shader {
 	public:
 		static opt<ptr<Shader>> Compile(const char* file,
@@ -24,6 +134,15 @@ namespace gvk {
 			const char** search_pathes,uint32 search_path_count,
 			std::string* error);
 
+		/// <summary>
+		/// Set the directory of the compile cache shared by all shaders.
+		/// Compiled SPIR-V is stored under a key hashed from the source,the included files,the macros and the target,
+		/// so a shader is only recompiled if one of them changed.
+		/// The cache is placed under the system temporary directory by default,pass NULL or "" to disable it
+		/// </summary>
+		/// <param name="directory">the directory of the cache</param>
+		static void SetCompileCacheDirectory(const char* directory);
+
 		static opt<ptr<Shader>> Load(const char* file,
 			const char** search_pathes,uint32 search_path_count,
 			std::string* error);
@@ -33,36 +152,78 @@ namespace gvk {
 		opt<VkShaderModule> CreateShaderModule(VkDevice device);
 		opt<VkShaderModule>	GetShaderModule();
 
-		opt<std::vector<SpvReflectDescriptorBinding*>>	GetDescriptorBindings();
-		opt<std::vector<SpvReflectDescriptorSet*>>		GetDescriptorSets();
-		opt<std::vector<SpvReflectInterfaceVariable*>>	GetInputVariables();
-		opt<std::vector<SpvReflectInterfaceVariable*>>	GetOutputVariables();
-		opt<std::vector<SpvReflectBlockVariable*>>		GetPushConstants();
+		//views of the reflection block,valid as long as the shader is alive
+		View<ShaderDescriptorBinding>	GetDescriptorBindings();
+		View<ShaderDescriptorSet>		GetDescriptorSets();
+		View<ShaderInterfaceVariable>	GetInputVariables();
+		View<ShaderInterfaceVariable>	GetOutputVariables();
+		View<ShaderPushConstant>		GetPushConstants();
+		View<ShaderSpecializationConstant> GetSpecializationConstants();
 
 		uint32 GetDescriptorBindingCount();
 		uint32 GetDescriptorSetCount();
 		uint32 GetInputVariableCount();
 		uint32 GetOutputVariableCount();
 		uint32 GetPushConstantCount();
+		uint32 GetSpecializationConstantCount();
 
 		const std::string& Name();
 
+		//absolute pathes of the source file and the files it includes,empty for shaders loaded from binaries
+		const std::vector<std::string>& GetSourceFiles();
+
+		const void* GetByteCode();
+		uint64_t	GetByteCodeSize();
+
 		const char* GetEntryPointName();
 
 		~Shader();
 
 	private:
-		Shader(void* byte_code, uint64_t byte_code_size,VkShaderStageFlagBits stage,const std::string& name);
+		Shader(ptr<void> byte_code, uint64_t byte_code_size,VkShaderStageFlagBits stage,const std::string& name);
 
-		static opt<ptr<Shader>> LoadFromBinaryFile(std::string& file,std::string* error);
+		static opt<ptr<Shader>> LoadFromBinaryFile(std::string& file, VkShaderStageFlagBits stage, std::string* error);
+		//the reflection beside the file is used only if it records code_hash
+		static opt<ptr<Shader>> LoadFromMemory(ptr<void> code, uint64_t code_size, const std::string& file, VkShaderStageFlagBits stage,
+			uint64_t code_hash, std::string* error);
 
 		VkShaderStageFlagBits m_Stage;
-		void*  m_ByteCode;
+		//either mapped from the binary file or the code returned by the compiler
+		ptr<void> m_ByteCode;
 		uint64_t m_ByteCodeSize;
-		spv_reflect::ShaderModule m_ReflectShaderModule;
+		//the reflection block is either mapped from the ".refl" file beside the binary or generated in memory
+		ptr<void> m_ReflectionStorage;
+		const ShaderReflectionHeader* m_Reflection;
 		VkShaderModule m_ShaderModule;
 		VkDevice	   m_Device;
 		std::string    m_Name;
+		std::vector<std::string> m_SourceFiles;
 	};
 
+
+	//variants of a shader compiled with Context::CompileShaderVariants.
+	//variants compiled to identical SPIR-V share the same shader.
+	//variants failing to compile are left out,their errors are kept by the archive
+	class ShaderVariantArchive {
+		friend class Context;
+	public:
+		//get the variant of the mask,nullptr if the mask selects a value out of range or the variant fails to compile
+		ptr<Shader> Get(uint32 mask);
+
+		const ShaderPermutation& GetPermutation();
+		uint32 GetVariantCount();
+		uint32 GetUniqueShaderCount();
+
+		//masks of the variants failing to compile and their error messages
+		const std::vector<std::pair<uint32, std::string>>& GetFailedVariants();
+
+	private:
+		ShaderVariantArchive(const ShaderPermutation& permutation);
+
+		ShaderPermutation		 m_Permutation;
+		//index of the shader for every mask
+		std::vector<uint32>		 m_VariantShaderIndex;
+		std::vector<ptr<Shader>> m_Shaders;
+		std::vector<std::pair<uint32, std::string>> m_FailedVariants;
+	};
 }
\ No newline at end of file
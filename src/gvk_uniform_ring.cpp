@@ -0,0 +1,60 @@
+#include "gvk_uniform_ring.h"
+#include "gvk_context.h"
+
+namespace gvk {
+
+	UniformRing::UniformRing(ptr<Buffer> buffer, uint32_t frame_size, uint32_t frame_count, uint32_t alignment)
+		:m_Buffer(buffer), m_FrameSize(frame_size), m_FrameCount(frame_count), m_Alignment(alignment) {}
+
+	opt<uint32_t> UniformRing::Push(const void* data, uint32_t size)
+	{
+		//every allocation is rounded up,so offsets stay aligned without a lock
+		uint32_t offset = m_Head.fetch_add(Align(size, m_Alignment));
+		if (offset + size > m_FrameSize)
+		{
+			return std::nullopt;
+		}
+		m_Buffer->Write(data, m_FrameStart + offset, size);
+		return m_FrameStart + offset;
+	}
+
+	void UniformRing::BeginFrame(uint32_t frame_index)
+	{
+		gvk_assert(frame_index < m_FrameCount);
+		m_FrameStart = frame_index * m_FrameSize;
+		m_Head = 0;
+	}
+
+	ptr<Buffer> UniformRing::GetBuffer()
+	{
+		return m_Buffer;
+	}
+
+	uint32_t UniformRing::GetFrameSize()
+	{
+		return m_FrameSize;
+	}
+
+	uint32_t UniformRing::GetAlignment()
+	{
+		return m_Alignment;
+	}
+
+	opt<ptr<UniformRing>> Context::CreateUniformRing(uint32_t frame_size, uint32_t frame_count, std::string* error)
+	{
+		auto& limits = m_DevicePropertiesFeature.DeviceProperties().limits;
+		//the ring may back dynamic uniform and storage buffers
+		uint32 alignment = (uint32)std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+		frame_size = Align(frame_size, alignment);
+		frame_count = frame_count != 0 ? frame_count : m_BackBufferCount;
+
+		auto buffer = CreateBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			(uint64_t)frame_size * frame_count, GVK_HOST_WRITE_SEQUENTIAL);
+		if (!buffer.has_value())
+		{
+			if (error) *error = "gvk : fail to create buffer for uniform ring";
+			return std::nullopt;
+		}
+		return ptr<UniformRing>(new UniformRing(buffer.value(), frame_size, frame_count, alignment));
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "gvk_common.h"
+#include "gvk_resource.h"
+#include <atomic>
+
+namespace gvk {
+
+	//persistently mapped buffer split into one region per frame in flight.
+	//uniform data of a frame is pushed into the region of the frame and addressed by the returned offset,
+	//so draws can share one dynamic uniform/storage buffer descriptor written once for the whole buffer.
+	//the descriptor range should not be larger than the data pushed with each offset
+	class UniformRing
+	{
+		friend class Context;
+	public:
+		/// <summary>
+		/// Copy data into the region of the current frame.Push can be called from several threads
+		/// </summary>
+		/// <param name="data">data to copy</param>
+		/// <param name="size">size of the data</param>
+		/// <returns>offset of the data from the start of the buffer,used as the dynamic offset.nullopt if the region is full</returns>
+		opt<uint32_t>	Push(const void* data, uint32_t size);
+
+		template<typename T>
+		opt<uint32_t>	Push(const T& data)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "uniform data must be trivially copyable");
+			return Push(&data, sizeof(T));
+		}
+
+		/// <summary>
+		/// Begin a frame.The region of the frame index is reused,
+		/// so the gpu work of the last frame using the index must have finished
+		/// </summary>
+		/// <param name="frame_index">index of the frame in flight</param>
+		void			BeginFrame(uint32_t frame_index);
+
+		ptr<Buffer>		GetBuffer();
+		uint32_t		GetFrameSize();
+		uint32_t		GetAlignment();
+
+	private:
+		UniformRing(ptr<Buffer> buffer, uint32_t frame_size, uint32_t frame_count, uint32_t alignment);
+
+		ptr<Buffer>				m_Buffer;
+		uint32_t				m_FrameSize;
+		uint32_t				m_FrameCount;
+		uint32_t				m_Alignment;
+		uint32_t				m_FrameStart = 0;
+		//bytes used in the region of the current frame
+		std::atomic<uint32_t>	m_Head{ 0 };
+	};
+}